@@ -0,0 +1,285 @@
+/**
+ * @file AsyncEngine.cpp
+ *
+ * Timer interrupt driven OneWire master
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AsyncEngine.h"
+#include "OneWireTiming.h"
+
+
+namespace OneWire
+{
+
+	void OneWireLine::Fire(void)
+	{
+		if (engine) engine->Service();
+	}
+
+
+	AsyncTransaction::AsyncTransaction()
+		: reset(false)
+		, data(0)
+		, length(0)
+		, callback(0)
+		, context(0)
+		, done(false)
+		, presence(0)
+	{
+	}
+
+	/**
+	 * @param[in] reset Issue a reset pulse before the data
+	 * @param[in] data Bytes to touch, 0xFF for bytes to be read
+	 * @param[in] length Number of bytes in data
+	 */
+	AsyncTransaction::AsyncTransaction(bool reset, BYTE* data, int length)
+		: reset(reset)
+		, data(data)
+		, length(length)
+		, callback(0)
+		, context(0)
+		, done(false)
+		, presence(0)
+	{
+	}
+
+
+	/**
+	 * AsyncEngine constructor
+	 *
+	 * @param[in] line Pin and timer to run on. The line is bound to this engine
+	 * and must outlive it.
+	 * @param[in] busSpeed OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+	 */
+	AsyncEngine::AsyncEngine(OneWireLine& line, unsigned int busSpeed)
+		: edgeCount(0)
+		, line(line)
+		, head(0)
+		, count(0)
+		, completing(false)
+		, phase(PHASE_IDLE)
+		, byteIndex(0)
+		, bitIndex(0)
+		, bit(0)
+		, result(0)
+	{
+		line.engine = this;
+		SetSpeed(busSpeed);
+		timing = speedTiming;
+	}
+
+	void AsyncEngine::SetSpeed(unsigned int busSpeed)
+	{
+		speedTiming = TimingNS(busSpeed);
+	}
+
+	bool AsyncEngine::Idle(void) const
+	{
+		return count == 0;
+	}
+
+	/**
+	 * Queue a transaction. If the bus is idle the first edge is generated right
+	 * away, otherwise it starts once everything ahead of it has completed.
+	 */
+	bool AsyncEngine::Submit(AsyncTransaction& transaction)
+	{
+		bool start;
+
+		transaction.done = false;
+		transaction.presence = 0;
+
+		line.EnterCritical();
+
+		if (count == OW_ASYNC_QUEUE_DEPTH)
+		{
+			line.ExitCritical();
+			return false;
+		}
+
+		queue[(head + count) % OW_ASYNC_QUEUE_DEPTH] = &transaction;
+		start = (count++ == 0) && !completing;
+
+		if (start) Start();
+
+		line.ExitCritical();
+		return true;
+	}
+
+	/**
+	 * Begin the transaction at the head of the queue
+	 */
+	void AsyncEngine::Start(void)
+	{
+		AsyncTransaction* t = queue[head];
+
+		byteIndex = 0;
+		bitIndex = 0;
+		result = 0;
+		timing = speedTiming;
+
+		if (t->reset)
+		{
+			// The line stays released for G before the reset pulse
+			if (timing[OW_TIME_G])
+			{
+				line.Release();
+				phase = PHASE_RESET_DELAY;
+				line.Schedule(timing[OW_TIME_G]);
+			}
+			else
+			{
+				StartReset();
+			}
+		}
+		else if (t->length > 0)
+		{
+			StartBit();
+		}
+		else
+		{
+			Complete();
+		}
+	}
+
+	/**
+	 * Falling edge of the reset pulse
+	 */
+	void AsyncEngine::StartReset(void)
+	{
+		line.Low();
+		phase = PHASE_RESET_LOW;
+		line.Schedule(timing[OW_TIME_H]);
+	}
+
+	/**
+	 * Falling edge of the next bit slot
+	 */
+	void AsyncEngine::StartBit(void)
+	{
+		bit = (queue[head]->data[byteIndex] >> bitIndex) & 0x01;
+
+		line.Low();
+		phase = PHASE_SLOT_LOW;
+		line.Schedule(bit ? timing[OW_TIME_A] : timing[OW_TIME_C]);
+	}
+
+	/**
+	 * Finish the head transaction and move on to the next one
+	 */
+	void AsyncEngine::Complete(void)
+	{
+		AsyncTransaction* t = queue[head];
+
+		head = (head + 1) % OW_ASYNC_QUEUE_DEPTH;
+		--count;
+		phase = PHASE_IDLE;
+
+		// A callback that resubmits, to chain polls, leaves the start to us
+		t->done = true;
+		completing = true;
+		if (t->callback) t->callback(t, t->context);
+		completing = false;
+
+		if (count > 0) Start();
+	}
+
+	/**
+	 * Run the edge that is due and schedule the next one. Called from the timer
+	 * interrupt, so keep it short.
+	 */
+	void AsyncEngine::Service(void)
+	{
+		AsyncTransaction* t = queue[head];
+
+		++edgeCount;
+
+		switch (phase)
+		{
+		case PHASE_RESET_DELAY:
+			StartReset();
+			break;
+
+		case PHASE_RESET_LOW:
+			line.Release();
+			phase = PHASE_RESET_SAMPLE;
+			line.Schedule(timing[OW_TIME_I]);
+			break;
+
+		case PHASE_RESET_SAMPLE:
+			t->presence = line.Sample() == 0 ? 1 : 0;
+			phase = PHASE_RESET_RECOVER;
+			line.Schedule(timing[OW_TIME_J]);
+			break;
+
+		case PHASE_RESET_RECOVER:
+			if (t->length > 0) StartBit();
+			else Complete();
+			break;
+
+		case PHASE_SLOT_LOW:
+			line.Release();
+			if (bit)
+			{
+				phase = PHASE_SLOT_SAMPLE;
+				line.Schedule(timing[OW_TIME_E]);
+			}
+			else
+			{
+				phase = PHASE_SLOT_RECOVER;
+				line.Schedule(timing[OW_TIME_D]);
+			}
+			break;
+
+		case PHASE_SLOT_SAMPLE:
+			bit = line.Sample() & 0x01;
+			phase = PHASE_SLOT_RECOVER;
+			line.Schedule(timing[OW_TIME_F]);
+			break;
+
+		case PHASE_SLOT_RECOVER:
+			// LSB first, same as OneWireMaster::TouchByte()
+			result >>= 1;
+			if (bit) result |= 0x80;
+
+			if (++bitIndex == 8)
+			{
+				t->data[byteIndex] = result;
+				result = 0;
+				bitIndex = 0;
+
+				if (++byteIndex == t->length)
+				{
+					Complete();
+					break;
+				}
+			}
+			StartBit();
+			break;
+
+		default:
+			break;
+		}
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,179 @@
+/**
+ * @file AsyncEngine.h
+ *
+ * AsyncEngine class prototype. A non-blocking OneWire master that generates
+ * slots from a compare timer interrupt instead of busy-waiting, leaving the
+ * CPU free between slot edges.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_ASYNCENGINE_H
+#define STELLARIS_ONEWIRE_ASYNCENGINE_H
+
+
+#include "OneWireBus.h"
+
+
+// Number of transactions that can be queued on an AsyncEngine at once. The
+// queue holds pointers only, the transactions themselves belong to the caller.
+#ifndef OW_ASYNC_QUEUE_DEPTH
+#define OW_ASYNC_QUEUE_DEPTH	8
+#endif // OW_ASYNC_QUEUE_DEPTH
+
+
+namespace OneWire
+{
+
+	class AsyncEngine;
+
+
+	/**
+	 * Pin and compare timer an AsyncEngine runs on
+	 *
+	 * Schedule() arms a one-shot timer, and the implementation must call Fire()
+	 * when it expires, normally from the timer interrupt handler.
+	 */
+	class OneWireLine
+	{
+	public:
+		OneWireLine() : engine(0) {}
+		virtual ~OneWireLine() {}
+
+		// Line control
+		virtual void Low(void) = 0;
+		virtual void Release(void) = 0;
+		virtual BYTE Sample(void) = 0;
+
+		// Arm the timer to fire ns nanoseconds from now
+		virtual void Schedule(unsigned long ns) = 0;
+
+		// Keep the timer interrupt out while the queue is being changed
+		virtual void EnterCritical(void) {}
+		virtual void ExitCritical(void) {}
+
+	protected:
+		// Timer expired, run the next step of the engine
+		void Fire(void);
+
+	private:
+		friend class AsyncEngine;
+		AsyncEngine* engine;
+	};
+
+
+	/**
+	 * A queued bus transaction
+	 *
+	 * The data buffer is touched in place like OneWireMaster::Block(), so bytes
+	 * to be read should be set to 0xFF. The buffer must stay valid until done is
+	 * set.
+	 */
+	struct AsyncTransaction
+	{
+		AsyncTransaction();
+		AsyncTransaction(bool reset, BYTE* data, int length);
+
+		// Request
+		bool reset;		// Issue a reset before the data
+		BYTE* data;		// Bytes to touch, replaced with the sampled values
+		int length;
+
+		// Completion callback, run from the timer interrupt
+		void (*callback)(AsyncTransaction* transaction, void* context);
+		void* context;
+
+		// Result
+		volatile bool done;
+		int presence;		// Presence detect of the reset, if one was issued
+	};
+
+
+	/**
+	 * Timer driven OneWire master
+	 *
+	 * Every bit is a short sequence of line edges. Each call to Service() runs
+	 * the edge that is due and arms the timer for the next, so apart from the
+	 * few instructions per edge the CPU is free while the bus is busy.
+	 */
+	class AsyncEngine
+	{
+	public:
+		AsyncEngine(OneWireLine& line, unsigned int busSpeed);
+
+		// Queue a transaction, returns false if the queue is full
+		bool Submit(AsyncTransaction& transaction);
+
+		// Whether there is no transaction in progress or queued
+		bool Idle(void) const;
+
+		// Speed for transactions started after this call. The one on the
+		// bus keeps the timing it started with.
+		void SetSpeed(unsigned int busSpeed);
+
+		// Timer expired, called through OneWireLine::Fire()
+		void Service(void);
+
+		// Number of timer interrupts taken so far
+		unsigned long edgeCount;
+
+	private:
+		enum Phase
+		{
+			PHASE_IDLE,
+			PHASE_RESET_DELAY,
+			PHASE_RESET_LOW,
+			PHASE_RESET_SAMPLE,
+			PHASE_RESET_RECOVER,
+			PHASE_SLOT_LOW,
+			PHASE_SLOT_SAMPLE,
+			PHASE_SLOT_RECOVER
+		};
+
+		void Start(void);
+		void StartReset(void);
+		void StartBit(void);
+		void Complete(void);
+
+		OneWireLine& line;
+
+		// Timing of the transaction on the bus, latched from speedTiming
+		// when it starts
+		const unsigned long* timing;
+		const unsigned long* speedTiming;
+
+		// Transaction queue, head is the one on the bus
+		AsyncTransaction* queue[OW_ASYNC_QUEUE_DEPTH];
+		volatile unsigned int head;
+		volatile unsigned int count;
+
+		// Set while a completion callback runs. Submit() from the callback
+		// only queues, Complete() starts whatever is next afterwards.
+		volatile bool completing;
+
+		// Position in the current transaction
+		volatile Phase phase;
+		int byteIndex;
+		int bitIndex;
+		BYTE bit;
+		BYTE result;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_ASYNCENGINE_H
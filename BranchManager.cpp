@@ -0,0 +1,333 @@
+/**
+ * @file BranchManager.cpp
+ *
+ * BranchManager class methods, see BranchManager.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BranchManager.h"
+
+#include <string.h>
+
+
+namespace OneWire
+{
+
+	// Coupler of a branch other than the trunk, and whether it is the
+	// auxiliary output
+	static unsigned int BranchCoupler(unsigned int branch)
+	{
+		return (branch - 1) / 2;
+	}
+
+	static bool BranchAux(unsigned int branch)
+	{
+		return (branch - 1) % 2 == 1;
+	}
+
+
+	/**
+	 * BranchManager constructor. Nothing is known until Discover().
+	 *
+	 * @param[in] master Master the trunk is reached through
+	 */
+	BranchManager::BranchManager(OneWireMaster& master)
+		: switchCount(0)
+		, reuseCount(0)
+		, master(master)
+		, couplerCount(0)
+		, active(OW_BRANCH_UNKNOWN)
+	{
+	}
+
+	/**
+	 * Search the trunk and every branch. Couplers are all off afterwards.
+	 *
+	 * @return Number of devices found, couplers included
+	 */
+	int BranchManager::Discover(void)
+	{
+		unsigned int first;
+		unsigned int found;
+
+		devices.Clear();
+		couplerCount = 0;
+
+		// Branches left on would make their devices look like trunk ones
+		master.Search();
+		found = master.devices.FamilyRange(OW_FAMILY_DS2409, first);
+		for (unsigned int i = 0; i < found && couplerCount < OW_MAX_COUPLERS; ++i)
+		{
+			couplers[couplerCount++] = master.devices[first + i];
+		}
+		for (unsigned int i = 0; i < couplerCount; ++i) LinesOff(i);
+
+		master.Search();
+		for (unsigned int i = 0; i < master.devices.Count(); ++i)
+		{
+			Record(master.devices[i], OW_BRANCH_TRUNK);
+		}
+
+		// Couplers that were on a branch are no longer on the trunk
+		couplerCount = 0;
+		found = devices.FamilyRange(OW_FAMILY_DS2409, first);
+		for (unsigned int i = 0; i < found && couplerCount < OW_MAX_COUPLERS; ++i)
+		{
+			couplers[couplerCount++] = devices[first + i];
+		}
+		active = OW_BRANCH_TRUNK;
+
+		for (unsigned int branch = 1; branch < BranchCount(); ++branch)
+		{
+			bool presence;
+
+			if (!SmartOn(branch, presence)) continue;
+
+			if (presence)
+			{
+				master.Search();
+				for (unsigned int i = 0; i < master.devices.Count(); ++i)
+				{
+					Record(master.devices[i], branch);
+				}
+			}
+
+			if (BranchAux(branch)) LinesOff(BranchCoupler(branch));
+		}
+
+		Activate(OW_BRANCH_TRUNK);
+		master.devices = devices;
+
+		return devices.Count();
+	}
+
+	const DeviceTable& BranchManager::Devices(void) const
+	{
+		return devices;
+	}
+
+	unsigned int BranchManager::Branch(ROM rom) const
+	{
+		int index = devices.Find(rom);
+
+		return index < 0 ? OW_BRANCH_UNKNOWN : branches[index];
+	}
+
+	unsigned int BranchManager::BranchCount(void) const
+	{
+		return 1 + 2 * couplerCount;
+	}
+
+	unsigned int BranchManager::CouplerCount(void) const
+	{
+		return couplerCount;
+	}
+
+	ROM BranchManager::Coupler(unsigned int index) const
+	{
+		return index < couplerCount ? couplers[index] : 0;
+	}
+
+	/**
+	 * Make a branch the active one. Only the coupler commands needed to get
+	 * there from the active branch are sent: none if it is already on, a
+	 * single smart-on to move between the outputs of one coupler.
+	 *
+	 * @param[in] branch Branch number, OW_BRANCH_TRUNK turns every coupler off
+	 * @return false if a coupler didn't confirm its command, which leaves the
+	 * active branch unknown
+	 */
+	bool BranchManager::Activate(unsigned int branch)
+	{
+		bool presence;
+
+		if (branch >= BranchCount()) return false;
+		if (branch == active) return true;
+
+		if (active == OW_BRANCH_UNKNOWN)
+		{
+			for (unsigned int i = 0; i < couplerCount; ++i)
+			{
+				if (!LinesOff(i)) return false;
+			}
+			active = OW_BRANCH_TRUNK;
+			if (branch == active) return true;
+		}
+
+		// Turning on one output of a coupler turns the other one off
+		if (active != OW_BRANCH_TRUNK
+			&& (branch == OW_BRANCH_TRUNK || BranchCoupler(branch) != BranchCoupler(active)))
+		{
+			if (!LinesOff(BranchCoupler(active))) return false;
+			active = OW_BRANCH_TRUNK;
+		}
+
+		if (branch != OW_BRANCH_TRUNK && !SmartOn(branch, presence)) return false;
+
+		active = branch;
+		return true;
+	}
+
+	unsigned int BranchManager::Active(void) const
+	{
+		return active;
+	}
+
+	void BranchManager::Invalidate(void)
+	{
+		active = OW_BRANCH_UNKNOWN;
+	}
+
+	/**
+	 * Switch to the transaction's branch if need be, then run it. Skip ROM,
+	 * Resume and unknown devices run on whatever is active; note that a
+	 * switch selects a coupler, so a Resume after one reaches the coupler.
+	 */
+	TransactionResult BranchManager::Execute(const Transaction& transaction)
+	{
+		return Run(transaction, Target(transaction));
+	}
+
+	/**
+	 * Run a batch one branch at a time, starting with the active one and
+	 * keeping the batch order within a branch. Transactions that aren't
+	 * addressed to a known device run with the first group.
+	 *
+	 * @param[in] transactions count transactions
+	 * @param[out] results count results, in the same order
+	 * @param[in] count Number of transactions
+	 * @return Number of TRANSACTION_OK results
+	 */
+	int BranchManager::ExecuteAll
+		( const Transaction* transactions
+		, TransactionResult* results
+		, int count
+		)
+	{
+		unsigned int start = active == OW_BRANCH_UNKNOWN ? OW_BRANCH_TRUNK : active;
+		int ok = 0;
+
+		for (unsigned int group = 0; group <= BranchCount(); ++group)
+		{
+			unsigned int branch = group == 0 ? start : group - 1;
+
+			if (group && branch == start) continue;
+
+			for (int i = 0; i < count; ++i)
+			{
+				unsigned int target = Target(transactions[i]);
+
+				if (target == OW_BRANCH_UNKNOWN) target = start;
+				if (target != branch) continue;
+
+				results[i] = Run(transactions[i], target);
+				if (results[i] == TRANSACTION_OK) ++ok;
+			}
+		}
+
+		return ok;
+	}
+
+	unsigned int BranchManager::Target(const Transaction& transaction) const
+	{
+		if (transaction.select != SELECT_MATCH && transaction.select != SELECT_OVERDRIVE_MATCH)
+			return OW_BRANCH_UNKNOWN;
+
+		return Branch(transaction.rom);
+	}
+
+	/**
+	 * A failure on a branch could be the coupler having lost its state, so
+	 * the active branch is forgotten and set up from scratch next time.
+	 */
+	TransactionResult BranchManager::Run(const Transaction& transaction, unsigned int branch)
+	{
+		TransactionResult result;
+
+		if (branch != OW_BRANCH_UNKNOWN)
+		{
+			if (branch == active) ++reuseCount;
+			else if (!Activate(branch)) return TRANSACTION_NO_PRESENCE;
+		}
+
+		result = master.Execute(transaction);
+		if (result != TRANSACTION_OK && active != OW_BRANCH_TRUNK) Invalidate();
+
+		return result;
+	}
+
+	/**
+	 * Smart-on a branch: after the command comes the reset stimulus byte, on
+	 * which the coupler resets the branch, then the presence byte and the
+	 * confirmation are read
+	 */
+	bool BranchManager::SmartOn(unsigned int branch, bool& presence)
+	{
+		BYTE command = BranchAux(branch) ? OW_COUPLER_SMART_ON_AUX : OW_COUPLER_SMART_ON_MAIN;
+		BYTE stimulus = OW_COUPLER_STIMULUS;
+		BYTE reply[2];
+		Transaction t;
+
+		++switchCount;
+		t.Match(couplers[BranchCoupler(branch)]).Command(command).Write(&stimulus, 1).Read(reply, 2);
+
+		if (master.Execute(t) != TRANSACTION_OK || reply[1] != command)
+		{
+			active = OW_BRANCH_UNKNOWN;
+			return false;
+		}
+
+		presence = reply[0] != 0xFF;
+		return true;
+	}
+
+	bool BranchManager::LinesOff(unsigned int coupler)
+	{
+		BYTE reply;
+		Transaction t;
+
+		++switchCount;
+		t.Match(couplers[coupler]).Command(OW_COUPLER_ALL_LINES_OFF).Read(&reply, 1);
+
+		if (master.Execute(t) != TRANSACTION_OK || reply != OW_COUPLER_ALL_LINES_OFF)
+		{
+			active = OW_BRANCH_UNKNOWN;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Keep branches[] lined up with the sorted device table. A device seen
+	 * before keeps the branch it was first seen on.
+	 */
+	void BranchManager::Record(ROM rom, unsigned int branch)
+	{
+		int index;
+
+		if (devices.Contains(rom) || !devices.Insert(rom)) return;
+
+		index = devices.Find(rom);
+		memmove(branches + index + 1, branches + index, devices.Count() - 1 - index);
+		branches[index] = branch;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,152 @@
+/**
+ * @file BranchManager.h
+ *
+ * BranchManager class prototype. Keeps track of which DS2409 coupler branch
+ * every device is on, and switches the couplers so each transaction reaches
+ * its device.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_BRANCHMANAGER_H
+#define STELLARIS_ONEWIRE_BRANCHMANAGER_H
+
+
+#include "OneWireMaster.h"
+
+
+// DS2409 MicroLAN coupler family code
+#define OW_FAMILY_DS2409	0x1F
+
+// Coupler function commands. Each is answered with a confirmation byte
+// equal to the command. The smart-on commands take a reset stimulus byte of
+// OW_COUPLER_STIMULUS first, reset the branch on it and report its presence
+// in the byte before the confirmation.
+#define OW_COUPLER_SMART_ON_MAIN	0xCC
+#define OW_COUPLER_SMART_ON_AUX		0x33
+#define OW_COUPLER_DIRECT_ON_MAIN	0xA5
+#define OW_COUPLER_ALL_LINES_OFF	0x66
+#define OW_COUPLER_DISCHARGE		0x99
+#define OW_COUPLER_STATUS			0x5A
+#define OW_COUPLER_STIMULUS			0xFF
+
+// Branch numbers: the trunk, then the main and auxiliary output of every
+// coupler in turn
+#define OW_BRANCH_TRUNK		0
+#define OW_BRANCH_UNKNOWN	0xFF
+
+// Number of couplers on the trunk a BranchManager can hold
+#ifndef OW_MAX_COUPLERS
+#define OW_MAX_COUPLERS		16
+#endif // OW_MAX_COUPLERS
+
+
+namespace OneWire
+{
+
+	/**
+	 * Bus split into branches by DS2409 couplers
+	 *
+	 * Discover() turns every coupler off and searches the trunk, then turns
+	 * on each branch in turn and searches again. Whatever wasn't on the trunk
+	 * is on that branch. The master's device table ends up holding every
+	 * device found.
+	 *
+	 * The active branch is remembered, and Execute() only sends coupler
+	 * commands when a transaction's device is on another one. ExecuteAll()
+	 * runs a batch grouped by branch, the active one first, so a poll of the
+	 * whole bus switches once per branch however the batch is ordered.
+	 *
+	 * Only couplers on the trunk are handled. A coupler found on a branch is
+	 * just another device on it, its own branches stay unseen.
+	 */
+	class BranchManager
+	{
+	public:
+		BranchManager(OneWireMaster& master);
+
+		// Map out the branches, returns the number of devices found
+		int Discover(void);
+
+		// Every device found, couplers included
+		const DeviceTable& Devices(void) const;
+
+		// Branch a device is on, OW_BRANCH_UNKNOWN if it wasn't found
+		unsigned int Branch(ROM rom) const;
+
+		// Branch numbers run from OW_BRANCH_TRUNK to BranchCount() - 1
+		unsigned int BranchCount(void) const;
+
+		// Couplers on the trunk
+		unsigned int CouplerCount(void) const;
+		ROM Coupler(unsigned int index) const;
+
+		// Switch a branch on, if it isn't already
+		bool Activate(unsigned int branch);
+		unsigned int Active(void) const;
+
+		// Forget the coupler states, after something else has switched
+		// them. The next switch turns every coupler off first.
+		void Invalidate(void);
+
+		// Run a transaction on its device's branch
+		TransactionResult Execute(const Transaction& transaction);
+
+		// Run a batch grouped by branch. Each transaction's result goes in
+		// results, returns the number that succeeded.
+		int ExecuteAll
+			( const Transaction* transactions
+			, TransactionResult* results
+			, int count
+			);
+
+		// Coupler commands sent, and transactions that found their branch
+		// already on
+		unsigned long switchCount;
+		unsigned long reuseCount;
+
+	private:
+		// Branch a transaction has to run on, OW_BRANCH_UNKNOWN if it isn't
+		// addressed to a known device
+		unsigned int Target(const Transaction& transaction) const;
+
+		// Run a transaction once its branch is on
+		TransactionResult Run(const Transaction& transaction, unsigned int branch);
+
+		// Coupler commands, presence is set if the smart-on found devices
+		bool SmartOn(unsigned int branch, bool& presence);
+		bool LinesOff(unsigned int coupler);
+
+		// Add a device found on a branch
+		void Record(ROM rom, unsigned int branch);
+
+		OneWireMaster& master;
+
+		ROM couplers[OW_MAX_COUPLERS];
+		unsigned int couplerCount;
+
+		// Every device, and the branch of each, entry i being device i
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> devices;
+		BYTE branches[OW_MAX_NUM_DEVICES];
+
+		unsigned int active;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_BRANCHMANAGER_H
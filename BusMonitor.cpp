@@ -0,0 +1,219 @@
+/**
+ * @file BusMonitor.cpp
+ *
+ * Hotplug monitor with incremental re-enumeration
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "BusMonitor.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * BusMonitor constructor
+	 *
+	 * The master's device table is taken as the current picture of the bus,
+	 * so run Search() first if it isn't.
+	 *
+	 * @param[in] master Master to monitor through
+	 * @param[in] handler Event callback, may be 0
+	 * @param[in] context Passed to the callback untouched
+	 */
+	BusMonitor::BusMonitor
+		( OneWireMaster& master
+		, DeviceEventHandler handler
+		, void* context
+		)
+		: pollCount(0)
+		, fingerprintCount(0)
+		, rewalkCount(0)
+		, master(master)
+		, handler(handler)
+		, context(context)
+		, presence(master.devices.Count() > 0)
+		, interval(OW_FINGERPRINT_INTERVAL)
+		, countdown(OW_FINGERPRINT_INTERVAL)
+		, cursor(0)
+	{
+	}
+
+	void BusMonitor::SetFingerprintInterval(unsigned int polls)
+	{
+		interval = polls;
+		countdown = polls;
+	}
+
+	/**
+	 * Run one monitoring period
+	 */
+	int BusMonitor::Poll(void)
+	{
+		bool now = master.Reset() != 0;
+		bool was = presence;
+
+		++pollCount;
+		presence = now;
+
+		// Bus went quiet, everything is gone
+		if (!now)
+		{
+			return was || master.devices.Count() ? Rewalk(0, 0) : 0;
+		}
+
+		// Something showed up on a bus we think is empty
+		if (!was || master.devices.Count() == 0) return Rewalk(0, 0);
+
+		if (interval == 0 || --countdown > 0) return 0;
+		countdown = interval;
+
+		return Fingerprint();
+	}
+
+	int BusMonitor::Rescan(void)
+	{
+		return Rewalk(0, 0);
+	}
+
+	/**
+	 * Verify the next device in the table and compare the branch points on its
+	 * path with what the table predicts
+	 */
+	int BusMonitor::Fingerprint(void)
+	{
+		SearchState state;
+		ROM rom, expected, changed;
+		int events = 0;
+
+		if (cursor >= master.devices.Count()) cursor = 0;
+		rom = master.devices[cursor++];
+
+		++fingerprintCount;
+
+		expected = ExpectedBranches(rom);
+
+		state.BeginPrefix(rom, 64);
+		switch (master.SearchStep(state))
+		{
+		case SEARCH_FOUND:
+			break;
+
+		case SEARCH_DONE:
+			// The device is gone. Below its last expected branch point its
+			// side of the tree only ever held this one device.
+			for (int bit = 63; bit >= 0; --bit)
+			{
+				if (expected & ((ROM)1 << bit)) return Rewalk(rom, bit + 1);
+			}
+			return Rewalk(0, 0);
+
+		default:
+			// Noise, try again next time
+			--cursor;
+			return 0;
+		}
+
+		// A new branch means devices turned up down its other side, a lost one
+		// means the other side emptied out. Either way that side is rewalked.
+		changed = expected ^ state.branches;
+		for (int bit = 0; bit < 64; ++bit)
+		{
+			ROM mask = (ROM)1 << bit;
+			if (!(changed & mask)) continue;
+
+			events += Rewalk((rom & (mask - 1)) | (~rom & mask), bit + 1);
+		}
+
+		return events;
+	}
+
+	ROM BusMonitor::ExpectedBranches(ROM rom) const
+	{
+		ROM branches = 0;
+
+		for (int bit = 0; bit < 64; ++bit)
+		{
+			ROM mask = (ROM)1 << bit;
+			ROM sibling = (rom & (mask - 1)) | (~rom & mask);
+
+			if (master.devices.ContainsPrefix(sibling, bit + 1)) branches |= mask;
+		}
+
+		return branches;
+	}
+
+	/**
+	 * Search the part of the tree under prefix and update the device table to
+	 * match, delivering an event for every difference. Nothing changes if the
+	 * search fails part way or finds more devices than the table holds.
+	 *
+	 * @param[in] prefix Path to the subtree, bit 0 first
+	 * @param[in] length Number of bits in the path, 0 for the whole bus
+	 * @return Number of events delivered
+	 */
+	int BusMonitor::Rewalk(ROM prefix, int length)
+	{
+		ROM mask = length >= 64 ? ~(ROM)0 : ((ROM)1 << length) - 1;
+		SearchState state;
+		SearchResult result;
+		int events = 0;
+
+		++rewalkCount;
+
+		found.Clear();
+		state.BeginPrefix(prefix, length);
+		while ((result = master.SearchStep(state)) == SEARCH_FOUND)
+		{
+			// A partial picture would report everything past it as gone
+			if (!found.Insert(state.rom)) return 0;
+		}
+
+		if (result == SEARCH_ERROR) return 0;
+
+		// Removals first, walking down so removing doesn't skip entries
+		for (unsigned int i = master.devices.Count(); i-- > 0; )
+		{
+			ROM rom = master.devices[i];
+
+			if ((rom ^ prefix) & mask) continue;
+			if (found.Contains(rom)) continue;
+
+			master.devices.Remove(rom);
+			if (handler) handler(rom, false, context);
+			++events;
+		}
+
+		for (unsigned int i = 0; i < found.Count(); ++i)
+		{
+			if (master.devices.Contains(found[i])) continue;
+			if (!master.devices.Insert(found[i])) break;
+
+			if (handler) handler(found[i], true, context);
+			++events;
+		}
+
+		if (cursor > master.devices.Count()) cursor = 0;
+
+		return events;
+	}
+
+} // Namespace OneWire
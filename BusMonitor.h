@@ -0,0 +1,104 @@
+/**
+ * @file BusMonitor.h
+ *
+ * BusMonitor class prototype. Watches a bus for devices being plugged in or
+ * pulled out, keeping the master's device table up to date without running a
+ * full search every time.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_BUSMONITOR_H
+#define STELLARIS_ONEWIRE_BUSMONITOR_H
+
+
+#include "OneWireMaster.h"
+
+
+// Polls between fingerprint steps unless SetFingerprintInterval() says
+// otherwise. Most polls are then a single reset.
+#ifndef OW_FINGERPRINT_INTERVAL
+#define OW_FINGERPRINT_INTERVAL	8
+#endif // OW_FINGERPRINT_INTERVAL
+
+
+namespace OneWire
+{
+
+	/**
+	 * Called for every device that appears on or disappears from the bus
+	 */
+	typedef void (*DeviceEventHandler)(ROM rom, bool added, void* context);
+
+
+	/**
+	 * Hotplug monitor
+	 *
+	 * Every Poll() costs one reset, which catches the bus going empty or coming
+	 * back. Every few polls it also runs a fingerprint step: one verification
+	 * pass down the path of the next device in the table, comparing the branch
+	 * points the bus shows against the ones the table predicts. Any difference
+	 * pins a change down to one subtree, and only that subtree is searched
+	 * again. Over a full round of fingerprint steps every change is seen.
+	 */
+	class BusMonitor
+	{
+	public:
+		BusMonitor(OneWireMaster& master, DeviceEventHandler handler, void* context);
+
+		// Polls between fingerprint steps, 0 for presence checks only. The
+		// default is OW_FINGERPRINT_INTERVAL.
+		void SetFingerprintInterval(unsigned int polls);
+
+		// Run one monitoring period, returns the number of events delivered
+		int Poll(void);
+
+		// Search the whole bus again and report the differences
+		int Rescan(void);
+
+		// Work done so far
+		unsigned long pollCount;
+		unsigned long fingerprintCount;
+		unsigned long rewalkCount;
+
+	private:
+		// Branch points along rom's path the device table predicts
+		ROM ExpectedBranches(ROM rom) const;
+
+		// Search one subtree and bring the table in line with it
+		int Rewalk(ROM prefix, int length);
+
+		// Run the fingerprint step for the next device
+		int Fingerprint(void);
+
+		OneWireMaster& master;
+		DeviceEventHandler handler;
+		void* context;
+
+		bool presence;
+		unsigned int interval;
+		unsigned int countdown;
+		unsigned int cursor;
+
+		// Devices found by Rewalk(), kept here to stay off the stack
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> found;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_BUSMONITOR_H
@@ -0,0 +1,269 @@
+/**
+ * @file BusScheduler.cpp
+ *
+ * Prioritized transaction queue for a shared bus
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "BusScheduler.h"
+
+#include <string.h>
+
+
+namespace OneWire
+{
+
+	ScheduledTransaction::ScheduledTransaction()
+		: priority(OW_SCHEDULER_PRIORITIES - 1)
+		, callback(0)
+		, context(0)
+		, done(false)
+		, result(TRANSACTION_OK)
+		, submittedUS(0)
+		, finishedUS(0)
+		, merged(0)
+	{
+	}
+
+	/**
+	 * BusScheduler constructor
+	 *
+	 * @param[in] master Master of the shared bus
+	 * @param[in] hooks Locking and clock of the system
+	 */
+	BusScheduler::BusScheduler(OneWireMaster& master, SchedulerHooks& hooks)
+		: master(master)
+		, hooks(hooks)
+	{
+		for (int p = 0; p < OW_SCHEDULER_PRIORITIES; ++p) queueCount[p] = 0;
+		ClearCounters();
+	}
+
+	/**
+	 * Queue a transaction. Safe to call from any task.
+	 *
+	 * @param[in] transaction Transaction to run, priority clamped to the
+	 * levels there are
+	 * @return false if that priority level is full, the transaction is not
+	 * queued then
+	 */
+	bool BusScheduler::Submit(ScheduledTransaction& transaction)
+	{
+		ScheduledTransaction* t = &transaction;
+		int priority = t->priority;
+
+		if (priority < 0) priority = 0;
+		if (priority >= OW_SCHEDULER_PRIORITIES) priority = OW_SCHEDULER_PRIORITIES - 1;
+
+		t->done = false;
+		t->merged = 0;
+
+		hooks.Lock();
+		t->submittedUS = hooks.NowUS();
+
+		// Ride along on an identical broadcast that is already waiting
+		for (int p = 0; p < OW_SCHEDULER_PRIORITIES; ++p)
+		{
+			for (unsigned int i = 0; i < queueCount[p]; ++i)
+			{
+				ScheduledTransaction* head = queue[p][i];
+				if (!Mergeable(head->transaction, t->transaction)) continue;
+
+				// Move it up if this one is more urgent
+				if (priority < p)
+				{
+					if (queueCount[priority] == OW_SCHEDULER_QUEUE_DEPTH) continue;
+					Remove(p, i);
+					Enqueue(head, priority);
+				}
+
+				t->merged = head->merged;
+				head->merged = t;
+				++mergedCount;
+
+				hooks.Unlock();
+				return true;
+			}
+		}
+
+		if (queueCount[priority] == OW_SCHEDULER_QUEUE_DEPTH)
+		{
+			hooks.Unlock();
+			return false;
+		}
+
+		Enqueue(t, priority);
+		hooks.Unlock();
+
+		return true;
+	}
+
+	bool BusScheduler::Done(ScheduledTransaction& transaction)
+	{
+		bool done;
+
+		hooks.Lock();
+		done = transaction.done;
+		hooks.Unlock();
+
+		return done;
+	}
+
+	/**
+	 * Run the most urgent queued transaction. The queues are unlocked while
+	 * it is on the bus, so other tasks can keep submitting.
+	 *
+	 * @return false if there was nothing to run
+	 */
+	bool BusScheduler::RunOne(void)
+	{
+		ScheduledTransaction* t = 0;
+
+		hooks.Lock();
+		for (int p = 0; p < OW_SCHEDULER_PRIORITIES && !t; ++p)
+		{
+			if (!queueCount[p]) continue;
+
+			t = queue[p][0];
+			Remove(p, 0);
+		}
+		hooks.Unlock();
+
+		if (!t) return false;
+
+		Complete(t, master.Execute(t->transaction));
+		return true;
+	}
+
+	/**
+	 * Run queued transactions back to back until there are none left,
+	 * including any submitted in the meantime
+	 *
+	 * @return Number of transactions run, merged ones counting once
+	 */
+	int BusScheduler::RunPending(void)
+	{
+		int run = 0;
+
+		while (RunOne()) ++run;
+
+		return run;
+	}
+
+	unsigned int BusScheduler::Pending(void)
+	{
+		unsigned int pending = 0;
+
+		hooks.Lock();
+		for (int p = 0; p < OW_SCHEDULER_PRIORITIES; ++p) pending += queueCount[p];
+		hooks.Unlock();
+
+		return pending;
+	}
+
+	void BusScheduler::ClearCounters(void)
+	{
+		hooks.Lock();
+		for (int p = 0; p < OW_SCHEDULER_PRIORITIES; ++p)
+		{
+			latency[p].count = 0;
+			latency[p].totalUS = 0;
+			latency[p].maxUS = 0;
+		}
+		mergedCount = 0;
+		hooks.Unlock();
+	}
+
+	/**
+	 * Two transactions can share one run if they are the same write-only
+	 * Skip ROM broadcast. Anything that reads back, or addresses a single
+	 * device, has to run on its own.
+	 */
+	bool BusScheduler::Mergeable(const Transaction& a, const Transaction& b)
+	{
+		if (a.select != SELECT_SKIP || b.select != SELECT_SKIP) return false;
+		if (a.readLength || b.readLength) return false;
+		if (a.reset != b.reset || a.hasCommand != b.hasCommand) return false;
+		if (a.hasCommand && a.command != b.command) return false;
+		if (a.writeLength != b.writeLength) return false;
+
+		return a.writeLength == 0 || memcmp(a.write, b.write, a.writeLength) == 0;
+	}
+
+	void BusScheduler::Enqueue(ScheduledTransaction* t, int priority)
+	{
+		queue[priority][queueCount[priority]++] = t;
+	}
+
+	void BusScheduler::Remove(int priority, unsigned int index)
+	{
+		--queueCount[priority];
+		for (unsigned int i = index; i < queueCount[priority]; ++i)
+		{
+			queue[priority][i] = queue[priority][i + 1];
+		}
+	}
+
+	/**
+	 * Hand out the result to a transaction and everything merged into it,
+	 * and run their callbacks outside the lock
+	 */
+	void BusScheduler::Complete(ScheduledTransaction* t, TransactionResult result)
+	{
+		hooks.Lock();
+		unsigned long long now = hooks.NowUS();
+
+		for (ScheduledTransaction* m = t; m; m = m->merged)
+		{
+			int p = m->priority;
+			if (p < 0) p = 0;
+			if (p >= OW_SCHEDULER_PRIORITIES) p = OW_SCHEDULER_PRIORITIES - 1;
+
+			unsigned long long us = now - m->submittedUS;
+			latency[p].count++;
+			latency[p].totalUS += us;
+			if (us > latency[p].maxUS) latency[p].maxUS = us;
+
+			m->result = result;
+			m->finishedUS = now;
+		}
+
+		hooks.Unlock();
+
+		// Nothing can merge into t any more, it has left the queue. Each one
+		// is only marked done after its callback, as a submitter may reuse
+		// its transaction the moment it sees done.
+		for (ScheduledTransaction* m = t; m; )
+		{
+			ScheduledTransaction* next = m->merged;
+
+			if (m->callback) m->callback(m, m->context);
+
+			hooks.Lock();
+			m->merged = 0;
+			m->done = true;
+			hooks.Unlock();
+
+			m = next;
+		}
+	}
+
+} // Namespace OneWire
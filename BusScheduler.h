@@ -0,0 +1,160 @@
+/**
+ * @file BusScheduler.h
+ *
+ * BusScheduler class prototype. Lets several tasks share one bus, queuing
+ * their transactions by priority and running them back to back.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_BUSSCHEDULER_H
+#define STELLARIS_ONEWIRE_BUSSCHEDULER_H
+
+
+#include "OneWireMaster.h"
+
+
+// Number of priority levels, 0 is the most urgent
+#ifndef OW_SCHEDULER_PRIORITIES
+#define OW_SCHEDULER_PRIORITIES	4
+#endif // OW_SCHEDULER_PRIORITIES
+
+// Transactions that can wait at each priority level
+#ifndef OW_SCHEDULER_QUEUE_DEPTH
+#define OW_SCHEDULER_QUEUE_DEPTH	8
+#endif // OW_SCHEDULER_QUEUE_DEPTH
+
+
+namespace OneWire
+{
+
+	/**
+	 * What the scheduler needs from the system it runs on
+	 *
+	 * Lock()/Unlock() guard the queues against the tasks submitting to them,
+	 * a mutex under an OS or interrupt masking on bare metal. NowUS() is a
+	 * free running microsecond clock for the latency figures. The defaults do
+	 * nothing, which is fine for a single task.
+	 */
+	class SchedulerHooks
+	{
+	public:
+		virtual ~SchedulerHooks() {}
+
+		virtual void Lock(void) {}
+		virtual void Unlock(void) {}
+		virtual unsigned long long NowUS(void) { return 0; }
+	};
+
+
+	/**
+	 * A transaction waiting for its turn on the bus
+	 *
+	 * Belongs to the submitter, and has to stay valid until it is done. The
+	 * transaction's own buffers are used in place.
+	 */
+	struct ScheduledTransaction
+	{
+		ScheduledTransaction();
+
+		// Request
+		Transaction transaction;
+		int priority;
+
+		// Completion callback, run by the task running the bus just before
+		// done is set
+		void (*callback)(ScheduledTransaction* transaction, void* context);
+		void* context;
+
+		// Result, check done through BusScheduler::Done()
+		bool done;
+		TransactionResult result;
+
+		// Submitted and finished, from SchedulerHooks::NowUS()
+		unsigned long long submittedUS;
+		unsigned long long finishedUS;
+
+		// Identical broadcasts riding along on this one, set by the scheduler
+		ScheduledTransaction* merged;
+	};
+
+
+	/**
+	 * Latency of one priority level, submission to completion
+	 */
+	struct LatencyStats
+	{
+		unsigned long count;
+		unsigned long long totalUS;
+		unsigned long long maxUS;
+	};
+
+
+	/**
+	 * Prioritized transaction queue for a shared bus
+	 *
+	 * Any task may Submit(). One task owns the bus and calls RunPending(),
+	 * which runs the queue most urgent first until it is empty. A broadcast
+	 * submitted while an identical one is still queued, such as a second
+	 * Skip ROM Convert T, is merged into it rather than run twice; the merged
+	 * transaction runs at the more urgent of the two priorities.
+	 */
+	class BusScheduler
+	{
+	public:
+		BusScheduler(OneWireMaster& master, SchedulerHooks& hooks);
+
+		// Queue a transaction, returns false if its priority level is full
+		bool Submit(ScheduledTransaction& transaction);
+
+		// Whether a submitted transaction has finished
+		bool Done(ScheduledTransaction& transaction);
+
+		// Run queued transactions, returns the number run
+		bool RunOne(void);
+		int RunPending(void);
+
+		// Number of transactions waiting
+		unsigned int Pending(void);
+
+		// Statistics
+		LatencyStats latency[OW_SCHEDULER_PRIORITIES];
+		unsigned long mergedCount;
+		void ClearCounters(void);
+
+	private:
+		// Identical broadcasts that may share one run
+		static bool Mergeable(const Transaction& a, const Transaction& b);
+
+		// Put into / take out of a priority queue, with the lock held
+		void Enqueue(ScheduledTransaction* t, int priority);
+		void Remove(int priority, unsigned int index);
+
+		// Mark a transaction and those merged into it as done
+		void Complete(ScheduledTransaction* t, TransactionResult result);
+
+		OneWireMaster& master;
+		SchedulerHooks& hooks;
+
+		ScheduledTransaction* queue[OW_SCHEDULER_PRIORITIES][OW_SCHEDULER_QUEUE_DEPTH];
+		unsigned int queueCount[OW_SCHEDULER_PRIORITIES];
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_BUSSCHEDULER_H
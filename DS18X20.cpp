@@ -0,0 +1,592 @@
+/**
+ * @file DS18X20.cpp
+ *
+ * DS18B20, DS1822 and DS18S20 digital thermometer handlers
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "DS18X20.h"
+#include "DeviceSnapshot.h"
+#include "OneWireTiming.h"
+
+
+namespace OneWire
+{
+
+	bool IsThermometer(ROM rom)
+	{
+		BYTE family = FamilyCode(rom);
+
+		return family == OW_FAMILY_DS18S20
+			|| family == OW_FAMILY_DS1822
+			|| family == OW_FAMILY_DS18B20;
+	}
+
+	/**
+	 * Work out the temperature from a scratchpad
+	 *
+	 * The DS18B20 and DS1822 give 1/16 degree steps directly, with the bits
+	 * below the configured resolution undefined, so those are cleared. The
+	 * DS18S20 gives half degrees, and the count remaining registers give the
+	 * rest.
+	 *
+	 * @param[in] family Family code of the device
+	 * @param[in] scratchpad Scratchpad as read
+	 * @return Temperature in 1/16 degree C
+	 */
+	int DecodeTemperature(BYTE family, const BYTE* scratchpad)
+	{
+		int raw = (short)(scratchpad[0] | (scratchpad[1] << 8));
+
+		if (family == OW_FAMILY_DS18S20)
+		{
+			// T = whole degrees - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+			int remain = scratchpad[6];
+			int perC = scratchpad[7] ? scratchpad[7] : 16;
+
+			return (raw >> 1) * 16 - 4 + (perC - remain) * 16 / perC;
+		}
+
+		return raw & ~((1 << (OW_RESOLUTION_MAX - DecodeResolution(family, scratchpad))) - 1);
+	}
+
+	/**
+	 * Resolution a sensor is set to, from its configuration register. The
+	 * DS18S20 has none, it reads 9 bits and always takes the full time.
+	 */
+	int DecodeResolution(BYTE family, const BYTE* scratchpad)
+	{
+		if (family == OW_FAMILY_DS18S20) return OW_RESOLUTION_MIN;
+
+		return OW_RESOLUTION_MIN + ((scratchpad[4] >> 5) & 0x03);
+	}
+
+	/**
+	 * Worst case conversion time, halving for every bit below 12
+	 *
+	 * @param[in] bits Resolution, 9 to 12
+	 * @return Time in ms, rounded up
+	 */
+	unsigned long ConversionMS(int bits)
+	{
+		int shift = OW_RESOLUTION_MAX - bits;
+
+		if (shift < 0) shift = 0;
+		return (OW_CONVERSION_MS + (1 << shift) - 1) >> shift;
+	}
+
+	// Conversion time of one sensor, the DS18S20 doesn't get any faster
+	static unsigned long ConversionMS(ROM rom, int bits)
+	{
+		return FamilyCode(rom) == OW_FAMILY_DS18S20 ? OW_CONVERSION_MS : ConversionMS(bits);
+	}
+
+	// Bus time of a Match ROM and Convert T: a reset and 10 bytes, rounded up
+	static const unsigned long START_MS =
+		( StandardTimingNS[OW_TIME_G] + StandardTimingNS[OW_TIME_H]
+		+ StandardTimingNS[OW_TIME_I] + StandardTimingNS[OW_TIME_J]
+		+ 80 * (StandardTimingNS[OW_TIME_A] + StandardTimingNS[OW_TIME_B])
+		) / 1000000 + 1;
+
+	/**
+	 * Wait for a conversion by polling read slots, which read 0 until it is
+	 * done. Parasite powered devices can't drive the line, so they get the
+	 * full conversion time instead.
+	 */
+	static bool PollConversion
+		( OneWireMaster& master
+		, bool parasite
+		, unsigned long maxMS
+		, unsigned long& polls
+		)
+	{
+		unsigned long waitedUS = 0;
+
+		if (parasite)
+		{
+			master.WaitUS(maxMS * 1000UL);
+			return true;
+		}
+
+		while (!master.ReadBit())
+		{
+			++polls;
+			if (waitedUS >= maxMS * 1000UL) return false;
+
+			master.WaitUS(OW_CONVERSION_POLL_US);
+			waitedUS += OW_CONVERSION_POLL_US;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Valid scratchpad: the CRC matches, and it isn't a shorted bus reading
+	 * all zeroes, which also passes the CRC
+	 *
+	 * @param[in] scratchpad Scratchpad, CRC byte last
+	 * @param[in] length Bytes in the scratchpad, CRC included
+	 */
+	bool CheckScratchpad(const BYTE* scratchpad, unsigned int length)
+	{
+		BYTE any = 0;
+
+		for (unsigned int i = 0; i < length; ++i) any |= scratchpad[i];
+
+		return any && CRC8Update(CRC8Init(), scratchpad, length) == 0;
+	}
+
+	/**
+	 * Read a scratchpad
+	 */
+	static bool ReadScratchpad(OneWireMaster& master, ROM rom, BYTE* scratchpad)
+	{
+		Transaction t;
+
+		t.Match(rom).Command(OW_READ_SCRATCHPAD).Read(scratchpad, OW_DS18X20_SCRATCHPAD);
+
+		return master.Execute(t) == TRANSACTION_OK && CheckScratchpad(scratchpad, OW_DS18X20_SCRATCHPAD);
+	}
+
+	/**
+	 * Write a new resolution into the configuration register, keeping the
+	 * alarm thresholds, and read it back to make sure it took
+	 *
+	 * @param[in,out] scratchpad Current scratchpad, replaced by the new one
+	 * @return false if the device doesn't have a resolution setting, or the
+	 * write didn't make it
+	 */
+	static bool WriteResolution
+		( OneWireMaster& master
+		, ROM rom
+		, BYTE* scratchpad
+		, int bits
+		, bool save
+		)
+	{
+		BYTE config[3];
+		Transaction t;
+
+		if (FamilyCode(rom) == OW_FAMILY_DS18S20) return false;
+		if (bits < OW_RESOLUTION_MIN || bits > OW_RESOLUTION_MAX) return false;
+
+		// TH, TL, then the resolution in bits 5 and 6
+		config[0] = scratchpad[2];
+		config[1] = scratchpad[3];
+		config[2] = ((bits - OW_RESOLUTION_MIN) << 5) | 0x1F;
+
+		t.Match(rom).Command(OW_WRITE_SCRATCHPAD).Write(config, 3);
+		if (master.Execute(t) != TRANSACTION_OK) return false;
+
+		if (!ReadScratchpad(master, rom, scratchpad)) return false;
+		if (DecodeResolution(FamilyCode(rom), scratchpad) != bits) return false;
+
+		if (save)
+		{
+			Transaction copy;
+
+			copy.Match(rom).Command(OW_COPY_SCRATCHPAD);
+			if (master.Execute(copy) != TRANSACTION_OK) return false;
+			master.WaitUS(OW_COPY_SCRATCHPAD_MS * 1000UL);
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * DS18X20 constructor
+	 *
+	 * @param[in] master Master the thermometer is reached through
+	 * @param[in] rom ROM ID of the thermometer
+	 */
+	DS18X20::DS18X20(OneWireMaster& master, ROM rom)
+		: OneWireDevice(master, rom)
+		, parasite(-1)
+		, resolution(0)
+	{
+	}
+
+	/**
+	 * Convert and read the temperature
+	 *
+	 * @return Temperature in 1/16 degree C, or OW_TEMP_INVALID
+	 */
+	int DS18X20::GetTemp(void)
+	{
+		BYTE data[OW_DS18X20_SCRATCHPAD];
+
+		if (!StartConversion() || !WaitConversion()) return OW_TEMP_INVALID;
+		if (!ReadScratchpad(data)) return OW_TEMP_INVALID;
+
+		return DecodeTemperature(GetFamily(), data);
+	}
+
+	bool DS18X20::StartConversion(void)
+	{
+		// Power supply has to be known before the conversion starts
+		Parasite();
+
+		if (!Select()) return false;
+		master.WriteByte(OW_CONVERT_T);
+
+		return true;
+	}
+
+	/**
+	 * Wait for the conversion started by StartConversion()
+	 *
+	 * @return false if it didn't finish in time
+	 */
+	bool DS18X20::WaitConversion(void)
+	{
+		unsigned long polls = 0;
+		int bits = resolution ? resolution : OW_RESOLUTION_MAX;
+
+		return PollConversion(master, parasite > 0, ConversionMS(rom, bits), polls);
+	}
+
+	/**
+	 * Read and check the scratchpad
+	 *
+	 * @param[out] scratchpad OW_DS18X20_SCRATCHPAD bytes
+	 * @return false if nobody answered or the CRC is wrong
+	 */
+	bool DS18X20::ReadScratchpad(BYTE* scratchpad)
+	{
+		if (!OneWire::ReadScratchpad(master, rom, scratchpad)) return false;
+
+		resolution = DecodeResolution(GetFamily(), scratchpad);
+		return true;
+	}
+
+	bool DS18X20::Parasite(void)
+	{
+		if (parasite < 0 && Select())
+		{
+			master.WriteByte(OW_READ_POWER_SUPPLY);
+			parasite = master.ReadBit() ? 0 : 1;
+		}
+
+		return parasite > 0;
+	}
+
+	/**
+	 * Resolution the device is set to
+	 *
+	 * @return 9 to 12 bits, or 0 if it couldn't be read
+	 */
+	int DS18X20::GetResolution(void)
+	{
+		BYTE data[OW_DS18X20_SCRATCHPAD];
+
+		if (!ReadScratchpad(data)) return 0;
+		return resolution;
+	}
+
+	/**
+	 * Change the resolution. Lower resolutions convert faster, 94ms at 9 bits
+	 * up to 750ms at 12.
+	 *
+	 * @param[in] bits New resolution, 9 to 12
+	 * @param[in] save Also copy it to EEPROM
+	 * @return false if it couldn't be set, always for a DS18S20
+	 */
+	bool DS18X20::SetResolution(int bits, bool save)
+	{
+		BYTE data[OW_DS18X20_SCRATCHPAD];
+
+		if (!ReadScratchpad(data)) return false;
+		if (!WriteResolution(master, rom, data, bits, save)) return false;
+
+		resolution = bits;
+		return true;
+	}
+
+
+	/**
+	 * ThermometerArray constructor
+	 *
+	 * @param[in] master Master the thermometers are reached through
+	 */
+	ThermometerArray::ThermometerArray(OneWireMaster& master)
+		: parasite(false)
+		, pollCount(0)
+		, master(master)
+		, count(0)
+	{
+	}
+
+	/**
+	 * Pick the thermometers out of a device table, normally the master's own
+	 * after a Search(), and find out how they are powered
+	 *
+	 * @param[in] devices Devices to choose from
+	 * @return Number of thermometers taken
+	 */
+	int ThermometerArray::Attach(const DeviceTable& devices)
+	{
+		return Attach(devices, 0);
+	}
+
+	/**
+	 * Attach for a warm start. Sensors the snapshot gives a resolution for
+	 * are not read, only those it doesn't know.
+	 *
+	 * @param[in] devices Devices to choose from
+	 * @param[in] known Snapshot saved by Record()
+	 * @return Number of thermometers taken
+	 */
+	int ThermometerArray::Attach(const DeviceTable& devices, const DeviceSnapshot& known)
+	{
+		return Attach(devices, &known);
+	}
+
+	int ThermometerArray::Attach(const DeviceTable& devices, const DeviceSnapshot* known)
+	{
+		count = 0;
+
+		for (unsigned int i = 0; i < devices.Count() && count < OW_MAX_THERMOMETERS; ++i)
+		{
+			if (!IsThermometer(devices[i])) continue;
+
+			rom[count] = devices[i];
+			converting[count] = false;
+			++count;
+		}
+
+		// Any parasite powered device pulls the read slot low
+		parasite = false;
+		if (count && master.Reset())
+		{
+			master.SkipROM();
+			master.WriteByte(OW_READ_POWER_SUPPLY);
+			parasite = !master.ReadBit();
+		}
+
+		// Learn every resolution. The temperatures read here are left over
+		// from before, so they don't count as readings.
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			const SnapshotEntry* entry = known ? known->Find(rom[i]) : 0;
+
+			if (entry && entry->resolution >= OW_RESOLUTION_MIN
+				&& entry->resolution <= OW_RESOLUTION_MAX)
+			{
+				resolution[i] = entry->resolution;
+			}
+			else if (!Read(i)) resolution[i] = OW_RESOLUTION_MAX;
+
+			temperature[i] = OW_TEMP_INVALID;
+			valid[i] = false;
+			readCount[i] = 0;
+		}
+
+		return count;
+	}
+
+	void ThermometerArray::Record(DeviceSnapshot& snapshot) const
+	{
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			snapshot.SetResolution(rom[i], resolution[i]);
+		}
+	}
+
+	unsigned int ThermometerArray::Count(void) const
+	{
+		return count;
+	}
+
+	int ThermometerArray::Update(void)
+	{
+		if (!StartConversion() || !WaitConversion()) return 0;
+		return ReadAll();
+	}
+
+	/**
+	 * Start a conversion on every device on the bus at once
+	 */
+	bool ThermometerArray::StartConversion(void)
+	{
+		if (!master.Reset()) return false;
+
+		master.SkipROM();
+		master.WriteByte(OW_CONVERT_T);
+
+		return true;
+	}
+
+	/**
+	 * Wait for every conversion to finish. Read slots read 0 as long as any
+	 * device is still converting.
+	 *
+	 * @return false if they didn't finish in time
+	 */
+	bool ThermometerArray::WaitConversion(void)
+	{
+		return PollConversion(master, parasite, SlowestMS(), pollCount);
+	}
+
+	/**
+	 * Read every scratchpad, one straight after the other
+	 *
+	 * @return Number of sensors with a valid reading
+	 */
+	int ThermometerArray::ReadAll(void)
+	{
+		int good = 0;
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (Read(i)) ++good;
+		}
+
+		return good;
+	}
+
+	bool ThermometerArray::Read(unsigned int index)
+	{
+		unsigned int i = index;
+
+		valid[i] = ReadScratchpad(master, rom[i], scratchpad[i]);
+		if (!valid[i])
+		{
+			temperature[i] = OW_TEMP_INVALID;
+			return false;
+		}
+
+		temperature[i] = DecodeTemperature(FamilyCode(rom[i]), scratchpad[i]);
+		resolution[i] = DecodeResolution(FamilyCode(rom[i]), scratchpad[i]);
+		++readCount[i];
+
+		return true;
+	}
+
+	/**
+	 * Change the resolution of one sensor
+	 *
+	 * @param[in] index Sensor number
+	 * @param[in] bits New resolution, 9 to 12
+	 * @param[in] save Also copy it to EEPROM
+	 * @return false if it couldn't be set, always for a DS18S20
+	 */
+	bool ThermometerArray::SetResolution(unsigned int index, int bits, bool save)
+	{
+		if (index >= count) return false;
+
+		// The alarm thresholds have to be written back as they are
+		if (!valid[index] && !Read(index)) return false;
+
+		if (!WriteResolution(master, rom[index], scratchpad[index], bits, save))
+			return false;
+
+		resolution[index] = bits;
+		return true;
+	}
+
+	unsigned long ThermometerArray::SlowestMS(void) const
+	{
+		unsigned long slowest = 0;
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			unsigned long ms = ConversionMS(rom[i], resolution[i]);
+			if (ms > slowest) slowest = ms;
+		}
+
+		return slowest;
+	}
+
+	/**
+	 * Run the per sensor schedule
+	 *
+	 * Every sensor is read as soon as its own conversion time has passed and
+	 * then started again, so each one cycles at the rate its resolution
+	 * allows. When every sensor is idle they are all started with one Skip
+	 * ROM, otherwise each is started on its own with Match ROM.
+	 *
+	 * Parasite powered buses get no traffic at all while converting, so
+	 * there every cycle takes as long as the slowest sensor.
+	 *
+	 * @param[in] nowMS Free running millisecond clock, may wrap
+	 * @return Number of valid readings taken
+	 */
+	int ThermometerArray::Service(unsigned long nowMS)
+	{
+		unsigned int busy = 0;
+		unsigned long started = 0;
+		bool reads = false;
+		int readings = 0;
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (!converting[i]) continue;
+
+			if ((long)(nowMS - readyMS[i]) < 0)
+			{
+				++busy;
+				continue;
+			}
+
+			converting[i] = false;
+			reads = true;
+			if (Read(i)) ++readings;
+		}
+
+		// Starting waits for the next call, so that the reads don't delay
+		// the conversions past the time they are scheduled from
+		if (reads || busy == count) return readings;
+		if (parasite && busy) return readings;
+
+		if (busy == 0)
+		{
+			if (!StartConversion()) return readings;
+
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				converting[i] = true;
+				readyMS[i] = nowMS + START_MS
+					+ (parasite ? SlowestMS() : ConversionMS(rom[i], resolution[i]));
+			}
+
+			return readings;
+		}
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			Transaction t;
+
+			if (converting[i]) continue;
+
+			t.Match(rom[i]).Command(OW_CONVERT_T);
+			if (master.Execute(t) != TRANSACTION_OK) continue;
+
+			// Each start pushes the ones after it back a little
+			started += START_MS;
+			converting[i] = true;
+			readyMS[i] = nowMS + started + ConversionMS(rom[i], resolution[i]);
+		}
+
+		return readings;
+	}
+
+} // Namespace OneWire
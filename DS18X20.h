@@ -0,0 +1,213 @@
+/**
+ * @file DS18X20.h
+ *
+ * DS18X20 and ThermometerArray class prototypes. Handlers for the DS18B20,
+ * DS1822 and DS18S20 digital thermometers, one at a time or a whole bus of
+ * them together.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DS18X20_H
+#define STELLARIS_ONEWIRE_DS18X20_H
+
+
+#include "OneWireDevice.h"
+
+
+// Family codes
+#define OW_FAMILY_DS18S20	0x10
+#define OW_FAMILY_DS1822	0x22
+#define OW_FAMILY_DS18B20	0x28
+
+// Thermometer function commands
+#define OW_CONVERT_T			0x44
+#define OW_WRITE_SCRATCHPAD		0x4E
+#define OW_READ_SCRATCHPAD		0xBE
+#define OW_COPY_SCRATCHPAD		0x48
+#define OW_RECALL_EEPROM		0xB8
+#define OW_READ_POWER_SUPPLY	0xB4
+
+// Scratchpad size, CRC included
+#define OW_DS18X20_SCRATCHPAD	9
+
+// Longest conversion, 12 bit resolution
+#define OW_CONVERSION_MS	750
+
+// Resolution range of the DS18B20 and DS1822, the DS18S20 is fixed
+#define OW_RESOLUTION_MIN	9
+#define OW_RESOLUTION_MAX	12
+
+// EEPROM write time after a Copy Scratchpad
+#define OW_COPY_SCRATCHPAD_MS	10
+
+// Returned for a temperature that could not be read
+#define OW_TEMP_INVALID		(-0x8000)
+
+// Number of sensors a ThermometerArray can hold
+#ifndef OW_MAX_THERMOMETERS
+#define OW_MAX_THERMOMETERS	OW_MAX_NUM_DEVICES
+#endif // OW_MAX_THERMOMETERS
+
+// Time between read slots while waiting for a conversion to finish. Shorter
+// notices the end sooner, at the cost of more bus traffic.
+#ifndef OW_CONVERSION_POLL_US
+#define OW_CONVERSION_POLL_US	1000
+#endif // OW_CONVERSION_POLL_US
+
+
+namespace OneWire
+{
+
+	class DeviceSnapshot;
+
+	// Whether a ROM belongs to one of the supported thermometers
+	bool IsThermometer(ROM rom);
+
+	// Temperature in 1/16 degree C from a scratchpad
+	int DecodeTemperature(BYTE family, const BYTE* scratchpad);
+
+	// Resolution in bits from a scratchpad
+	int DecodeResolution(BYTE family, const BYTE* scratchpad);
+
+	// Whether a scratchpad passes its CRC and isn't all zeroes
+	bool CheckScratchpad(const BYTE* scratchpad, unsigned int length);
+
+	// Worst case conversion time in ms at a resolution
+	unsigned long ConversionMS(int bits);
+
+
+	/**
+	 * A single DS18B20, DS1822 or DS18S20
+	 *
+	 * Temperatures are in 1/16 of a degree C, so divide by 16 for degrees.
+	 */
+	class DS18X20 : public OneWireDevice
+	{
+	public:
+		DS18X20(OneWireMaster& master, ROM rom);
+
+		// Convert and read in one go
+		int GetTemp(void);
+
+		// The separate steps
+		bool StartConversion(void);
+		bool WaitConversion(void);
+		bool ReadScratchpad(BYTE* scratchpad);
+
+		// Whether the device runs off parasite power
+		bool Parasite(void);
+
+		// Resolution in bits, 9 to 12. Setting it can also store it in
+		// EEPROM, so it survives a power cycle.
+		int GetResolution(void);
+		bool SetResolution(int bits, bool save = false);
+
+	private:
+		// -1 until the power supply has been read
+		int parasite;
+
+		// 0 until known
+		int resolution;
+	};
+
+	typedef DS18X20 DS18B20;
+	typedef DS18X20 DS1822;
+	typedef DS18X20 DS18S20;
+
+
+	/**
+	 * Every thermometer on a bus, read together
+	 *
+	 * One Convert T goes out to all of them with Skip ROM, the end of the
+	 * conversion is watched with read slots, then the scratchpads are read
+	 * back to back. The whole bus costs one conversion time plus the reads.
+	 *
+	 * Results are kept as parallel arrays, entry i of each being sensor i.
+	 *
+	 * Sensors can run at different resolutions. Update() waits for the
+	 * slowest of them, Service() instead gives each sensor its own cycle, so
+	 * a 9 bit sensor is read 8 times for every read of a 12 bit one.
+	 */
+	class ThermometerArray
+	{
+	public:
+		ThermometerArray(OneWireMaster& master);
+
+		// Take the thermometers out of a device table, returns how many
+		int Attach(const DeviceTable& devices);
+
+		// Same, taking resolutions from a snapshot rather than reading them
+		// from each sensor
+		int Attach(const DeviceTable& devices, const DeviceSnapshot& known);
+
+		// Store every sensor's resolution in a snapshot
+		void Record(DeviceSnapshot& snapshot) const;
+		unsigned int Count(void) const;
+
+		// Convert, wait and read, returns the number of good readings
+		int Update(void);
+
+		// The separate steps
+		bool StartConversion(void);
+		bool WaitConversion(void);
+		int ReadAll(void);
+
+		// Change the resolution of sensor index, see DS18X20
+		bool SetResolution(unsigned int index, int bits, bool save = false);
+
+		// Run the per sensor schedule, without ever waiting for a conversion.
+		// Call it often with a millisecond clock, returns the number of new
+		// readings.
+		int Service(unsigned long nowMS);
+
+		// Results
+		ROM rom[OW_MAX_THERMOMETERS];
+		int temperature[OW_MAX_THERMOMETERS];
+		bool valid[OW_MAX_THERMOMETERS];
+		BYTE scratchpad[OW_MAX_THERMOMETERS][OW_DS18X20_SCRATCHPAD];
+		BYTE resolution[OW_MAX_THERMOMETERS];
+		unsigned long readCount[OW_MAX_THERMOMETERS];
+
+		// Set by Attach() if any sensor is parasite powered. Those can't
+		// signal the end of a conversion, so the full time is waited.
+		bool parasite;
+
+		// Read slots spent waiting for conversions
+		unsigned long pollCount;
+
+	private:
+		int Attach(const DeviceTable& devices, const DeviceSnapshot* known);
+
+		// Read sensor index into the result arrays
+		bool Read(unsigned int index);
+
+		// Conversion time of the slowest sensor
+		unsigned long SlowestMS(void) const;
+
+		OneWireMaster& master;
+		unsigned int count;
+
+		// Service() schedule
+		bool converting[OW_MAX_THERMOMETERS];
+		unsigned long readyMS[OW_MAX_THERMOMETERS];
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DS18X20_H
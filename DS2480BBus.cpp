@@ -0,0 +1,319 @@
+/**
+ * @file DS2480BBus.cpp
+ *
+ * DS2480BBus implementation. Command values and the search accelerator
+ * encoding are from the DS2480B datasheet and Maxim Application Note 192.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DS2480BBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * DS2480BBus constructor
+	 *
+	 * @param[in] port Serial port the DS2480B is on, at 9600 baud
+	 * @param[in] busSpeed OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+	 */
+	DS2480BBus::DS2480BBus(SerialPort& port, unsigned int busSpeed)
+		: writeCount(0)
+		, bytesSent(0)
+		, bytesReceived(0)
+		, timeoutCount(0)
+		, port(port)
+		, speed(busSpeed)
+		, dataMode(false)
+		, txLen(0)
+	{
+	}
+
+	/**
+	 * Bring the chip to a known state. After a break the DS2480B is in
+	 * command mode and takes the first byte it sees to calibrate its baud
+	 * rate detection, without answering it. The configuration from
+	 * Application Note 192 follows: 1.37V/us pulldown slew rate, 10us write
+	 * 1 low time, 8us data sample offset, then a read of the baud rate
+	 * parameter and a single bit as a check.
+	 */
+	bool DS2480BBus::Detect(void)
+	{
+		static const BYTE config[5] = { 0x17, 0x45, 0x5B, 0x0F, 0x91 };
+		static const BYTE expected[5] = { 0x16, 0x44, 0x5A, 0x00, 0x93 };
+		BYTE response[5];
+
+		port.Break();
+		port.DelayUS(2000);
+		port.Flush();
+		dataMode = false;
+
+		txLen = 0;
+		tx[txLen++] = OW_DS2480B_RESET;
+		Send(0, 0);
+		port.DelayUS(4000);
+		port.Flush();
+
+		for (int i = 0; i < 5; ++i) tx[txLen++] = config[i];
+		if (!Send(response, 5)) return false;
+
+		for (int i = 0; i < 5; ++i)
+		{
+			if (response[i] != expected[i]) return false;
+		}
+
+		return true;
+	}
+
+	BYTE DS2480BBus::SpeedBits(void) const
+	{
+		return speed == OW_SPEED_OVERDRIVE
+			? OW_DS2480B_SPEED_OVERDRIVE
+			: OW_DS2480B_SPEED_STANDARD;
+	}
+
+	void DS2480BBus::Command(BYTE command)
+	{
+		if (dataMode)
+		{
+			tx[txLen++] = OW_DS2480B_COMMAND_MODE;
+			dataMode = false;
+		}
+		tx[txLen++] = command;
+	}
+
+	void DS2480BBus::Data(BYTE data)
+	{
+		if (!dataMode)
+		{
+			tx[txLen++] = OW_DS2480B_DATA_MODE;
+			dataMode = true;
+		}
+		tx[txLen++] = data;
+		if (data == OW_DS2480B_COMMAND_MODE) tx[txLen++] = data;
+	}
+
+	/**
+	 * Write the queued bytes and wait for the answer. A timeout leaves the
+	 * bridge in an unknown mode, so command mode is queued ahead of whatever
+	 * is sent next. 0xE3 in command mode does nothing.
+	 */
+	bool DS2480BBus::Send(BYTE* response, int len)
+	{
+		port.Write(tx, txLen);
+		++writeCount;
+		bytesSent += txLen;
+		txLen = 0;
+
+		if (len == 0) return true;
+
+		if (!port.Read(response, len))
+		{
+			++timeoutCount;
+			tx[txLen++] = OW_DS2480B_COMMAND_MODE;
+			dataMode = false;
+			return false;
+		}
+
+		bytesReceived += len;
+		return true;
+	}
+
+	void DS2480BBus::ClearCounters(void)
+	{
+		writeCount = 0;
+		bytesSent = 0;
+		bytesReceived = 0;
+		timeoutCount = 0;
+	}
+
+	/**
+	 * Reset the bus, returns 1 if a presence pulse was detected. The alarming
+	 * presence the chip reports for a DS1994 counts as presence too.
+	 */
+	int DS2480BBus::Reset(void)
+	{
+		BYTE response;
+
+		Command(OW_DS2480B_RESET | SpeedBits());
+		if (!Send(&response, 1)) return 0;
+
+		response &= OW_DS2480B_RESET_MASK;
+		return response == OW_DS2480B_RESET_PRESENCE
+			|| response == OW_DS2480B_RESET_ALARM;
+	}
+
+	void DS2480BBus::WriteBit(BYTE bit)
+	{
+		BYTE response;
+
+		Command(OW_DS2480B_BIT | (bit & 0x01 ? OW_DS2480B_BIT_ONE : 0) | SpeedBits());
+		Send(&response, 1);
+	}
+
+	BYTE DS2480BBus::ReadBit(void)
+	{
+		BYTE response;
+
+		Command(OW_DS2480B_BIT | OW_DS2480B_BIT_ONE | SpeedBits());
+		if (!Send(&response, 1)) return 1;
+
+		return response & 0x01;
+	}
+
+	/**
+	 * The bridge times its own slots, this is only for waits between them,
+	 * such as a temperature conversion
+	 */
+	void DS2480BBus::WaitUS(unsigned int us)
+	{
+		port.DelayUS(us);
+	}
+
+	/**
+	 * Set the speed for all following slots. Data mode runs at the speed of
+	 * the last command, so this sends a search accelerator off command, which
+	 * carries speed bits and does nothing on the bus.
+	 */
+	void DS2480BBus::SetSpeed(unsigned int busSpeed)
+	{
+		speed = busSpeed;
+		Command(OW_DS2480B_SEARCH_OFF | SpeedBits());
+		Send(0, 0);
+	}
+
+	unsigned int DS2480BBus::GetSpeed(void) const
+	{
+		return speed;
+	}
+
+	/**
+	 * Run a block through data mode. The bridge echoes every data byte with
+	 * the bits it read, in chunks of OW_DS2480B_BLOCK bytes per serial write.
+	 */
+	void DS2480BBus::TouchBytes(BYTE* data, int len)
+	{
+		while (len > 0)
+		{
+			int chunk = len < OW_DS2480B_BLOCK ? len : OW_DS2480B_BLOCK;
+
+			for (int i = 0; i < chunk; ++i) Data(data[i]);
+
+			// A lost response reads as a released line
+			if (!Send(data, chunk))
+			{
+				for (int i = 0; i < chunk; ++i) data[i] = 0xFF;
+			}
+
+			data += chunk;
+			len -= chunk;
+		}
+	}
+
+	void DS2480BBus::WriteBytes(const BYTE* data, int len)
+	{
+		BYTE echo[OW_DS2480B_BLOCK];
+
+		while (len > 0)
+		{
+			int chunk = len < OW_DS2480B_BLOCK ? len : OW_DS2480B_BLOCK;
+
+			for (int i = 0; i < chunk; ++i) echo[i] = data[i];
+			TouchBytes(echo, chunk);
+
+			data += chunk;
+			len -= chunk;
+		}
+	}
+
+	void DS2480BBus::ReadBytes(BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i) data[i] = 0xFF;
+		TouchBytes(data, len);
+	}
+
+	/**
+	 * A whole search pass in one serial write: accelerator on, the 16 byte
+	 * request in data mode, accelerator off. The request holds two bits per
+	 * ROM bit, with the direction to take at a discrepancy in the odd bit.
+	 * The response has the discrepancy flag in the even bit and the path
+	 * taken in the odd one.
+	 *
+	 * The flag is also set where the ID bit and its complement both read 1,
+	 * which has to be told apart from a real discrepancy. Once nothing answers
+	 * a bit nothing answers the rest of the pass, so the CRC byte reads 1 and
+	 * 1 as well. The CRC is a function of the first 56 bits, two devices can't
+	 * differ only there, and any flag in it means the pass fell off the tree.
+	 * A flag where the bridge wrote a 1 against a preferred 0 can't be a real
+	 * discrepancy either. When the CRC byte is flagged, the whole run of
+	 * flags it ends is taken as unanswered, so an alarm search nobody
+	 * answers shows errors from the first bit.
+	 */
+	void DS2480BBus::SearchPass
+		( ROM preferred
+		, ROM& taken
+		, ROM& discrepancies
+		, ROM& errors
+		)
+	{
+		BYTE request[OW_DS2480B_SEARCH_BYTES] = { 0 };
+		BYTE response[OW_DS2480B_SEARCH_BYTES];
+
+		for (int i = 0; i < 64; ++i)
+		{
+			if ((preferred >> i) & 0x01) request[i / 4] |= 0x02 << ((i % 4) * 2);
+		}
+
+		Command(OW_DS2480B_SEARCH_ON | SpeedBits());
+		for (int i = 0; i < OW_DS2480B_SEARCH_BYTES; ++i) Data(request[i]);
+		Command(OW_DS2480B_SEARCH_OFF | SpeedBits());
+
+		taken = 0;
+		discrepancies = 0;
+		errors = 0;
+
+		if (!Send(response, OW_DS2480B_SEARCH_BYTES))
+		{
+			// Looks like nothing answered, which fails the CRC
+			taken = ~(ROM)0;
+			return;
+		}
+
+		for (int i = 0; i < 64; ++i)
+		{
+			BYTE pair = response[i / 4] >> ((i % 4) * 2);
+
+			if (pair & 0x01) discrepancies |= (ROM)1 << i;
+			if (pair & 0x02) taken |= (ROM)1 << i;
+		}
+
+		const ROM crcByte = (ROM)0xFF << 56;
+
+		errors = discrepancies & ((taken & ~preferred) | crcByte);
+		if (discrepancies & crcByte)
+		{
+			for (int i = 63; i >= 0 && ((discrepancies >> i) & 0x01); --i)
+				errors |= (ROM)1 << i;
+		}
+		discrepancies &= ~errors;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,136 @@
+/**
+ * @file DS2480BBus.h
+ *
+ * DS2480BBus class prototype. OneWire transport through a DS2480B serial to
+ * 1-Wire line driver. Bytes, blocks and whole search passes are packed into a
+ * single serial write each and run by the bridge in its data mode, rather
+ * than costing a serial round trip per bit.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DS2480BBUS_H
+#define STELLARIS_ONEWIRE_DS2480BBUS_H
+
+
+#include "OneWireBus.h"
+#include "SerialPort.h"
+
+
+// Mode switch bytes
+#define OW_DS2480B_DATA_MODE		0xE1
+#define OW_DS2480B_COMMAND_MODE		0xE3
+
+// Command mode commands, or'd with one of the speed settings below
+#define OW_DS2480B_RESET		0xC1
+#define OW_DS2480B_BIT			0x81
+#define OW_DS2480B_BIT_ONE		0x10
+#define OW_DS2480B_SEARCH_ON		0xB1
+#define OW_DS2480B_SEARCH_OFF		0xA1
+
+// Speed bits of the commands
+#define OW_DS2480B_SPEED_STANDARD	0x00
+#define OW_DS2480B_SPEED_OVERDRIVE	0x08
+#define OW_DS2480B_SPEED_MASK		0x0C
+
+// Reset response, low two bits
+#define OW_DS2480B_RESET_MASK		0x03
+#define OW_DS2480B_RESET_SHORT		0x00
+#define OW_DS2480B_RESET_PRESENCE	0x01
+#define OW_DS2480B_RESET_ALARM		0x02
+#define OW_DS2480B_RESET_NONE		0x03
+
+// Data bytes sent per serial write. Every data byte may need escaping, so the
+// transmit buffer is twice this plus the mode switches around it.
+#ifndef OW_DS2480B_BLOCK
+#define OW_DS2480B_BLOCK	128
+#endif // OW_DS2480B_BLOCK
+
+// Search accelerator request/response length, two bits per ROM bit
+#define OW_DS2480B_SEARCH_BYTES	16
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWire transport on a DS2480B
+	 *
+	 * The bridge runs the slot timing itself, so the only cost on this side is
+	 * serial traffic. Call Detect() once after opening the port to calibrate
+	 * and configure the chip.
+	 */
+	class DS2480BBus : public OneWireBus
+	{
+	public:
+		DS2480BBus(SerialPort& port, unsigned int busSpeed = OW_SPEED_STANDARD);
+
+		// Break, calibrate and configure the chip, returns false if there is
+		// no DS2480B answering on the port
+		bool Detect(void);
+
+		// OneWireBus interface
+		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
+		void WaitUS(unsigned int us);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+		void WriteBytes(const BYTE* data, int len);
+		void ReadBytes(BYTE* data, int len);
+		void TouchBytes(BYTE* data, int len);
+		void SearchPass
+			( ROM preferred
+			, ROM& taken
+			, ROM& discrepancies
+			, ROM& errors
+			);
+
+		// Serial traffic counters
+		unsigned long writeCount;
+		unsigned long bytesSent;
+		unsigned long bytesReceived;
+		unsigned long timeoutCount;
+		void ClearCounters(void);
+
+	private:
+		// Queue a command, switching to command mode first if needed
+		void Command(BYTE command);
+
+		// Queue a data byte, switching to data mode first if needed. 0xE3 is
+		// sent twice so the bridge doesn't take it as a mode switch.
+		void Data(BYTE data);
+
+		// Send everything queued in one write and read len response bytes
+		bool Send(BYTE* response, int len);
+
+		// Speed bits for the commands
+		BYTE SpeedBits(void) const;
+
+		SerialPort& port;
+		unsigned int speed;
+		bool dataMode;
+
+		BYTE tx[OW_DS2480B_BLOCK * 2 + 4];
+		int txLen;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DS2480BBUS_H
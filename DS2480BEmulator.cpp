@@ -0,0 +1,314 @@
+/**
+ * @file DS2480BEmulator.cpp
+ *
+ * DS2480BEmulator implementation
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DS2480BEmulator.h"
+
+#include <chrono>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+namespace OneWire
+{
+
+	/**
+	 * DS2480BEmulator constructor
+	 *
+	 * @param[in] bus Simulated bus the chip drives
+	 */
+	DS2480BEmulator::DS2480BEmulator(SimulatedBus& bus)
+		: bytesIn(0)
+		, bytesOut(0)
+		, bus(bus)
+		, master(-1)
+		, slave(-1)
+		, running(false)
+	{
+		PowerOn();
+	}
+
+	DS2480BEmulator::~DS2480BEmulator()
+	{
+		Close();
+	}
+
+	void DS2480BEmulator::PowerOn(void)
+	{
+		calibrated = false;
+		dataMode = false;
+		escape = false;
+		accelerator = false;
+
+		for (int i = 0; i < 8; ++i) parameters[i] = 0;
+	}
+
+	/**
+	 * Open a pty pair and start the thread answering on the master side. The
+	 * slave side is kept open too and put in raw mode, so nothing is echoed
+	 * before the host opens it and the pty survives the host closing it.
+	 */
+	bool DS2480BEmulator::Open(void)
+	{
+		Close();
+
+		master = posix_openpt(O_RDWR | O_NOCTTY);
+		if (master < 0) return false;
+
+		if (grantpt(master) != 0 || unlockpt(master) != 0)
+		{
+			Close();
+			return false;
+		}
+
+		path = ptsname(master);
+		slave = open(path.c_str(), O_RDWR | O_NOCTTY);
+		if (slave < 0)
+		{
+			Close();
+			return false;
+		}
+
+		struct termios tio;
+		tcgetattr(slave, &tio);
+		cfmakeraw(&tio);
+		tcsetattr(slave, TCSANOW, &tio);
+
+		PowerOn();
+		running = true;
+		thread = std::thread(&DS2480BEmulator::Run, this);
+		return true;
+	}
+
+	void DS2480BEmulator::Close(void)
+	{
+		running = false;
+		if (thread.joinable()) thread.join();
+
+		if (slave >= 0) close(slave);
+		if (master >= 0) close(master);
+		slave = -1;
+		master = -1;
+	}
+
+	const char* DS2480BEmulator::Path(void) const
+	{
+		return path.c_str();
+	}
+
+	/**
+	 * Answer the pty. Between two reads the simulated bus is moved on by at
+	 * least the wall clock time that passed, so waits on the host side, such
+	 * as for a temperature conversion, pass on the bus as well.
+	 */
+	void DS2480BEmulator::Run(void)
+	{
+		BYTE in[256];
+		std::vector<BYTE> out;
+		std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+		unsigned long long busLast = bus.Now();
+
+		while (running)
+		{
+			struct pollfd pfd = { master, POLLIN, 0 };
+			if (poll(&pfd, 1, 20) <= 0) continue;
+
+			ssize_t got = read(master, in, sizeof(in));
+			if (got <= 0) continue;
+
+			std::chrono::steady_clock::time_point wall = std::chrono::steady_clock::now();
+			unsigned long long waited = std::chrono::duration_cast<std::chrono::nanoseconds>
+				(wall - last).count();
+			if (bus.Now() - busLast < waited) bus.Advance(waited - (bus.Now() - busLast));
+
+			out.clear();
+			Process(in, got, out);
+			last = wall;
+			busLast = bus.Now();
+
+			const BYTE* p = out.data();
+			size_t left = out.size();
+			while (left > 0)
+			{
+				ssize_t written = write(master, p, left);
+				if (written <= 0) break;
+				p += written;
+				left -= written;
+			}
+		}
+	}
+
+	void DS2480BEmulator::Process(const BYTE* in, int len, std::vector<BYTE>& out)
+	{
+		size_t before = out.size();
+
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE b = in[i];
+
+			if (!dataMode)
+			{
+				CommandByte(b, out);
+			}
+			else if (escape)
+			{
+				// 0xE3 twice is a data byte, anything else after it is a
+				// command
+				escape = false;
+				if (b == OW_DS2480B_COMMAND_MODE) out.push_back(DataByte(b));
+				else
+				{
+					dataMode = false;
+					CommandByte(b, out);
+				}
+			}
+			else if (b == OW_DS2480B_COMMAND_MODE) escape = true;
+			else out.push_back(DataByte(b));
+		}
+
+		bytesIn += len;
+		bytesOut += out.size() - before;
+	}
+
+	/**
+	 * Speed bits of a command become the speed of everything that follows,
+	 * data mode included
+	 */
+	void DS2480BEmulator::Speed(BYTE command)
+	{
+		bus.SetSpeed((command & OW_DS2480B_SPEED_MASK) == OW_DS2480B_SPEED_OVERDRIVE
+			? OW_SPEED_OVERDRIVE
+			: OW_SPEED_STANDARD);
+	}
+
+	void DS2480BEmulator::CommandByte(BYTE command, std::vector<BYTE>& out)
+	{
+		// The first byte after power on only sets the baud rate detection
+		if (!calibrated)
+		{
+			calibrated = true;
+			return;
+		}
+
+		if (command == OW_DS2480B_DATA_MODE)
+		{
+			dataMode = true;
+		}
+		else if (command == OW_DS2480B_COMMAND_MODE)
+		{
+			// Already there
+		}
+		else if ((command & 0x80) == 0)
+		{
+			// Configuration, parameter code 0 reads the parameter selected by
+			// the value bits, anything else writes it
+			BYTE code = (command >> 4) & 0x07;
+			BYTE value = (command >> 1) & 0x07;
+
+			if (code == 0) out.push_back(parameters[value] << 1);
+			else
+			{
+				parameters[code] = value;
+				out.push_back(command & 0xFE);
+			}
+		}
+		else if ((command & 0xE3) == OW_DS2480B_RESET)
+		{
+			Speed(command);
+			BYTE result = bus.Reset()
+				? OW_DS2480B_RESET_PRESENCE
+				: OW_DS2480B_RESET_NONE;
+			out.push_back(0xCC | result);
+		}
+		else if ((command & 0xE3) == OW_DS2480B_BIT)
+		{
+			Speed(command);
+			BYTE level;
+
+			if (command & OW_DS2480B_BIT_ONE) level = bus.ReadBit();
+			else
+			{
+				bus.WriteBit(0);
+				level = 0;
+			}
+			out.push_back((command & 0xFC) | (level ? 0x03 : 0x00));
+		}
+		else if ((command & 0xE3) == OW_DS2480B_SEARCH_OFF)
+		{
+			// Covers accelerator on as well, which has bit 4 set
+			Speed(command);
+			accelerator = (command & 0x10) != 0;
+		}
+	}
+
+	/**
+	 * A data mode byte, returns the chip's answer to it
+	 */
+	BYTE DS2480BEmulator::DataByte(BYTE data)
+	{
+		if (accelerator) return SearchByte(data);
+
+		BYTE result = 0;
+		for (int bit = 0; bit < 8; ++bit, data >>= 1)
+		{
+			if (data & 0x01)
+			{
+				if (bus.ReadBit()) result |= 1 << bit;
+			}
+			else bus.WriteBit(0);
+		}
+		return result;
+	}
+
+	/**
+	 * Four search triplets for one request byte. Where both devices answer the
+	 * direction comes from the request and the discrepancy flag is set. Where
+	 * nothing answers the flag is set as well and a 1 is written.
+	 */
+	BYTE DS2480BEmulator::SearchByte(BYTE request)
+	{
+		BYTE response = 0;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			BYTE id = bus.ReadBit();
+			BYTE comp = bus.ReadBit();
+			BYTE flag = id == comp;
+			BYTE direction;
+
+			if (!flag) direction = id;
+			else if (id) direction = 1;
+			else direction = (request >> (i * 2 + 1)) & 0x01;
+
+			bus.WriteBit(direction);
+			response |= (flag | (direction << 1)) << (i * 2);
+		}
+
+		return response;
+	}
+
+} // Namespace OneWire
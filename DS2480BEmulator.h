@@ -0,0 +1,100 @@
+/**
+ * @file DS2480BEmulator.h
+ *
+ * DS2480BEmulator class prototype. A DS2480B on a Linux pseudo terminal, in
+ * front of a SimulatedBus, so DS2480BBus can be run and timed through a real
+ * tty without the hardware.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DS2480BEMULATOR_H
+#define STELLARIS_ONEWIRE_DS2480BEMULATOR_H
+
+
+#include "DS2480BBus.h"
+#include "SimulatedBus.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace OneWire
+{
+
+	/**
+	 * DS2480B emulated on a pty
+	 *
+	 * Covers what DS2480BBus uses: configuration parameters, reset, single
+	 * bits, data mode with 0xE3 escaping and the search accelerator. Once
+	 * Open() has been called the simulated bus belongs to the emulator's
+	 * thread and must not be touched until Close().
+	 */
+	class DS2480BEmulator
+	{
+	public:
+		DS2480BEmulator(SimulatedBus& bus);
+		~DS2480BEmulator();
+
+		// Create the pty and start answering on it, returns false if a pty
+		// can't be had
+		bool Open(void);
+		void Close(void);
+
+		// Path of the slave side, for PosixSerialPort::Open()
+		const char* Path(void) const;
+
+		// Run bytes received from the host through the chip, appending the
+		// chip's answers to out. Open() feeds the pty through this.
+		void Process(const BYTE* in, int len, std::vector<BYTE>& out);
+
+		// Back to the power on state, waiting for the calibration byte
+		void PowerOn(void);
+
+		// Bytes seen and answered
+		unsigned long bytesIn;
+		unsigned long bytesOut;
+
+	private:
+		void Run(void);
+
+		void CommandByte(BYTE command, std::vector<BYTE>& out);
+		BYTE DataByte(BYTE data);
+		BYTE SearchByte(BYTE request);
+		void Speed(BYTE command);
+
+		SimulatedBus& bus;
+
+		bool calibrated;
+		bool dataMode;
+		bool escape;
+		bool accelerator;
+		BYTE parameters[8];
+
+		int master;
+		int slave;
+		std::string path;
+		std::thread thread;
+		std::atomic<bool> running;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DS2480BEMULATOR_H
@@ -0,0 +1,314 @@
+/**
+ * @file DS2482Bus.cpp
+ *
+ * DS2482 and DS2482Bus implementation. Command values are from the
+ * DS2482-100 and DS2482-800 datasheets, the byte level behaviour from Maxim
+ * Application Note 3684.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DS2482Bus.h"
+
+
+namespace OneWire
+{
+
+	// Channel select codes, and what the channel register reads back as
+	static const BYTE channelCode[OW_DS2482_CHANNELS] =
+		{ 0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87 };
+	static const BYTE channelReadback[OW_DS2482_CHANNELS] =
+		{ 0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87 };
+
+
+	/**
+	 * DS2482 constructor
+	 *
+	 * @param[in] port I2C port addressing the bridge
+	 */
+	DS2482::DS2482(I2CPort& port)
+		: transactionCount(0)
+		, pollCount(0)
+		, selectCount(0)
+		, selectSkipped(0)
+		, port(port)
+		, channel(-1)
+		, config(-1)
+	{
+	}
+
+	/**
+	 * Device reset, then active pullup on. After the reset the status
+	 * register has RST set and a DS2482-800 is on channel 0.
+	 */
+	bool DS2482::Detect(void)
+	{
+		BYTE command = OW_DS2482_DEVICE_RESET;
+		BYTE status;
+
+		channel = -1;
+		config = -1;
+
+		++transactionCount;
+		if (!port.WriteRead(&command, 1, &status, 1)) return false;
+		if ((status & ~OW_DS2482_STATUS_LL) != OW_DS2482_STATUS_RST) return false;
+
+		channel = 0;
+		config = 0;
+		return Configure(OW_DS2482_CONFIG_APU);
+	}
+
+	bool DS2482::Select(int channel)
+	{
+		BYTE command[2];
+		BYTE readback;
+
+		if (channel < 0 || channel >= OW_DS2482_CHANNELS) return true;
+		if (channel == this->channel)
+		{
+			++selectSkipped;
+			return true;
+		}
+
+		command[0] = OW_DS2482_CHANNEL_SELECT;
+		command[1] = channelCode[channel];
+
+		++selectCount;
+		++transactionCount;
+		if (!port.WriteRead(command, 2, &readback, 1) || readback != channelReadback[channel])
+		{
+			this->channel = -1;
+			return false;
+		}
+
+		this->channel = channel;
+		return true;
+	}
+
+	/**
+	 * The register takes the configuration in the low nibble and its
+	 * complement in the high one, and reads back without the complement
+	 */
+	bool DS2482::Configure(BYTE config)
+	{
+		BYTE command[2];
+		BYTE readback;
+
+		if (config == this->config) return true;
+
+		command[0] = OW_DS2482_WRITE_CONFIG;
+		command[1] = (config & 0x0F) | ((~config & 0x0F) << 4);
+
+		++transactionCount;
+		if (!port.WriteRead(command, 2, &readback, 1) || readback != (config & 0x0F))
+		{
+			this->config = -1;
+			return false;
+		}
+
+		this->config = config;
+		return true;
+	}
+
+	/**
+	 * Send the command and read the status in the same transaction. Bit
+	 * and triplet commands are usually done by the time the read starts, so
+	 * they cost a single transaction. Bytes and resets read the status again
+	 * until the busy flag drops.
+	 */
+	BYTE DS2482::Wait(const BYTE* command, int len)
+	{
+		BYTE status;
+
+		++transactionCount;
+		if (!port.WriteRead(command, len, &status, 1)) return OW_DS2482_STATUS_1WB;
+
+		for (int polls = 0; status & OW_DS2482_STATUS_1WB; ++polls)
+		{
+			if (polls == OW_DS2482_POLLS) return status;
+
+			++pollCount;
+			++transactionCount;
+			if (!port.Read(&status, 1)) return OW_DS2482_STATUS_1WB;
+		}
+
+		return status;
+	}
+
+	BYTE DS2482::Run(BYTE command)
+	{
+		return Wait(&command, 1);
+	}
+
+	BYTE DS2482::Run(BYTE command, BYTE parameter)
+	{
+		BYTE message[2] = { command, parameter };
+
+		return Wait(message, 2);
+	}
+
+	bool DS2482::ReadData(BYTE& data)
+	{
+		BYTE command[2] = { OW_DS2482_SET_POINTER, OW_DS2482_REG_DATA };
+
+		++transactionCount;
+		return port.WriteRead(command, 2, &data, 1);
+	}
+
+	void DS2482::DelayUS(unsigned int us)
+	{
+		port.DelayUS(us);
+	}
+
+	void DS2482::ClearCounters(void)
+	{
+		transactionCount = 0;
+		pollCount = 0;
+		selectCount = 0;
+		selectSkipped = 0;
+	}
+
+
+	/**
+	 * DS2482Bus constructor
+	 *
+	 * @param[in] chip Bridge the bus is on
+	 * @param[in] channel DS2482-800 channel, 0 to 7, or OW_DS2482_NO_CHANNEL
+	 * for a DS2482-100
+	 * @param[in] busSpeed OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+	 */
+	DS2482Bus::DS2482Bus(DS2482& chip, int channel, unsigned int busSpeed)
+		: chip(chip)
+		, channel(channel)
+		, speed(busSpeed)
+	{
+	}
+
+	bool DS2482Bus::Prepare(void)
+	{
+		BYTE config = OW_DS2482_CONFIG_APU;
+
+		if (speed == OW_SPEED_OVERDRIVE) config |= OW_DS2482_CONFIG_1WS;
+
+		return chip.Select(channel) && chip.Configure(config);
+	}
+
+	int DS2482Bus::Reset(void)
+	{
+		if (!Prepare()) return 0;
+
+		BYTE status = chip.Run(OW_DS2482_1W_RESET);
+
+		if (status & (OW_DS2482_STATUS_1WB | OW_DS2482_STATUS_SD)) return 0;
+		return status & OW_DS2482_STATUS_PPD ? 1 : 0;
+	}
+
+	void DS2482Bus::WriteBit(BYTE bit)
+	{
+		if (!Prepare()) return;
+
+		chip.Run(OW_DS2482_1W_BIT, bit & 0x01 ? 0x80 : 0x00);
+	}
+
+	/**
+	 * A failed command reads as a released line
+	 */
+	BYTE DS2482Bus::ReadBit(void)
+	{
+		if (!Prepare()) return 1;
+
+		BYTE status = chip.Run(OW_DS2482_1W_BIT, 0x80);
+
+		if (status & OW_DS2482_STATUS_1WB) return 1;
+		return status & OW_DS2482_STATUS_SBR ? 1 : 0;
+	}
+
+	void DS2482Bus::WaitUS(unsigned int us)
+	{
+		chip.DelayUS(us);
+	}
+
+	/**
+	 * Takes effect with the next command, when the configuration is written
+	 */
+	void DS2482Bus::SetSpeed(unsigned int busSpeed)
+	{
+		speed = busSpeed;
+	}
+
+	unsigned int DS2482Bus::GetSpeed(void) const
+	{
+		return speed;
+	}
+
+	void DS2482Bus::WriteBytes(const BYTE* data, int len)
+	{
+		if (!Prepare()) return;
+
+		for (int i = 0; i < len; ++i) chip.Run(OW_DS2482_1W_WRITE, data[i]);
+	}
+
+	void DS2482Bus::ReadBytes(BYTE* data, int len)
+	{
+		if (!Prepare())
+		{
+			for (int i = 0; i < len; ++i) data[i] = 0xFF;
+			return;
+		}
+
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE status = chip.Run(OW_DS2482_1W_READ);
+
+			if ((status & OW_DS2482_STATUS_1WB) || !chip.ReadData(data[i])) data[i] = 0xFF;
+		}
+	}
+
+	/**
+	 * The bridge has no byte command that both writes and samples, so like
+	 * Application Note 3684 an 0xFF is a byte read and anything else is a
+	 * byte write that reads back as written. Slaves only drive the line
+	 * while the master sends all ones, so that holds for everything but
+	 * bit-level tricks, which need WriteBit()/ReadBit().
+	 */
+	void DS2482Bus::TouchBytes(BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			if (data[i] == 0xFF) ReadBytes(data + i, 1);
+			else WriteBytes(data + i, 1);
+		}
+	}
+
+	/**
+	 * One OW_DS2482_1W_TRIPLET, whose status bits are where the OW_TRIPLET_*
+	 * flags were taken from, shifted up by 5. A failed command reads as
+	 * nothing answering.
+	 */
+	BYTE DS2482Bus::Triplet(BYTE direction)
+	{
+		if (!Prepare()) return OW_TRIPLET_ID | OW_TRIPLET_COMP;
+
+		BYTE status = chip.Run(OW_DS2482_1W_TRIPLET, direction ? 0x80 : 0x00);
+
+		if (status & OW_DS2482_STATUS_1WB) return OW_TRIPLET_ID | OW_TRIPLET_COMP;
+		return (status >> 5) & (OW_TRIPLET_ID | OW_TRIPLET_COMP | OW_TRIPLET_DIR);
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,168 @@
+/**
+ * @file DS2482Bus.h
+ *
+ * DS2482 and DS2482Bus class prototypes. OneWire transport through a
+ * DS2482-100 or DS2482-800 I2C to 1-Wire bridge. Bytes go over with the
+ * bridge's byte commands and searches with its triplet command, so the I2C
+ * traffic is one command per byte or search bit rather than per time slot.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DS2482BUS_H
+#define STELLARIS_ONEWIRE_DS2482BUS_H
+
+
+#include "OneWireBus.h"
+#include "I2CPort.h"
+
+
+// Device commands
+#define OW_DS2482_DEVICE_RESET		0xF0
+#define OW_DS2482_SET_POINTER		0xE1
+#define OW_DS2482_WRITE_CONFIG		0xD2
+#define OW_DS2482_CHANNEL_SELECT	0xC3
+#define OW_DS2482_1W_RESET		0xB4
+#define OW_DS2482_1W_BIT		0x87
+#define OW_DS2482_1W_WRITE		0xA5
+#define OW_DS2482_1W_READ		0x96
+#define OW_DS2482_1W_TRIPLET		0x78
+
+// Read pointer codes for OW_DS2482_SET_POINTER
+#define OW_DS2482_REG_STATUS		0xF0
+#define OW_DS2482_REG_DATA		0xE1
+#define OW_DS2482_REG_CHANNEL		0xD2
+#define OW_DS2482_REG_CONFIG		0xC3
+
+// Status register
+#define OW_DS2482_STATUS_1WB		0x01	// 1-Wire busy
+#define OW_DS2482_STATUS_PPD		0x02	// Presence pulse detected
+#define OW_DS2482_STATUS_SD		0x04	// Short detected
+#define OW_DS2482_STATUS_LL		0x08	// Logic level of the line
+#define OW_DS2482_STATUS_RST		0x10	// Device reset since last config
+#define OW_DS2482_STATUS_SBR		0x20	// Single bit result
+#define OW_DS2482_STATUS_TSB		0x40	// Triplet second bit
+#define OW_DS2482_STATUS_DIR		0x80	// Triplet direction taken
+
+// Configuration register
+#define OW_DS2482_CONFIG_APU		0x01	// Active pullup
+#define OW_DS2482_CONFIG_SPU		0x04	// Strong pullup
+#define OW_DS2482_CONFIG_1WS		0x08	// Overdrive speed
+
+// Channels on a DS2482-800. A DS2482-100 has a single unnumbered one.
+#define OW_DS2482_CHANNELS		8
+#define OW_DS2482_NO_CHANNEL		-1
+
+// Status reads to wait for a 1-Wire command before giving up. A reset is
+// the longest at about 1.2ms, a few reads at 100kHz.
+#ifndef OW_DS2482_POLLS
+#define OW_DS2482_POLLS		20
+#endif // OW_DS2482_POLLS
+
+
+namespace OneWire
+{
+
+	/**
+	 * A DS2482 on an I2C port
+	 *
+	 * Keeps track of the channel selected and the configuration written, so
+	 * neither is sent again while it hasn't changed. Every channel in use
+	 * gets a DS2482Bus of its own on the same DS2482.
+	 */
+	class DS2482
+	{
+	public:
+		DS2482(I2CPort& port);
+
+		// Reset the bridge and configure it, returns false if there is no
+		// DS2482 answering
+		bool Detect(void);
+
+		// Select a DS2482-800 channel, does nothing if it already is
+		bool Select(int channel);
+
+		// Write the configuration register, does nothing if it already holds
+		// config. Takes the OW_DS2482_CONFIG_* bits.
+		bool Configure(BYTE config);
+
+		// Send a 1-Wire command and wait for it to finish. Returns the status
+		// register, with OW_DS2482_STATUS_1WB still set if it didn't.
+		BYTE Run(BYTE command);
+		BYTE Run(BYTE command, BYTE parameter);
+
+		// Read the data register, after OW_DS2482_1W_READ
+		bool ReadData(BYTE& data);
+
+		void DelayUS(unsigned int us);
+
+		// I2C traffic counters
+		unsigned long transactionCount;
+		unsigned long pollCount;
+		unsigned long selectCount;
+		unsigned long selectSkipped;
+		void ClearCounters(void);
+
+	private:
+		BYTE Wait(const BYTE* command, int len);
+
+		I2CPort& port;
+
+		// Cached register contents, -1 when unknown
+		int channel;
+		int config;
+	};
+
+
+	/**
+	 * OneWire transport on one channel of a DS2482
+	 */
+	class DS2482Bus : public OneWireBus
+	{
+	public:
+		DS2482Bus
+			( DS2482& chip
+			, int channel = OW_DS2482_NO_CHANNEL
+			, unsigned int busSpeed = OW_SPEED_STANDARD
+			);
+
+		// OneWireBus interface
+		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
+		void WaitUS(unsigned int us);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+		void WriteBytes(const BYTE* data, int len);
+		void ReadBytes(BYTE* data, int len);
+		void TouchBytes(BYTE* data, int len);
+		BYTE Triplet(BYTE direction);
+
+	private:
+		// Select this channel at this speed
+		bool Prepare(void);
+
+		DS2482& chip;
+		int channel;
+		unsigned int speed;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DS2482BUS_H
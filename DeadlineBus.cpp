@@ -0,0 +1,312 @@
+/**
+ * @file DeadlineBus.cpp
+ *
+ * DeadlineBus class methods, see DeadlineBus.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DeadlineBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Spread of a calibrated cost
+	 */
+	struct CostRange
+	{
+		CostRange() : least(~0UL), most(0), sum(0) {}
+
+		void Add(unsigned long cost)
+		{
+			if (cost < least) least = cost;
+			if (cost > most) most = cost;
+			sum += cost;
+		}
+
+		unsigned long Average(void) const
+		{
+			return sum / OW_CALIBRATION_ROUNDS;
+		}
+
+		// Furthest a single call strayed from the average
+		unsigned long Spread(void) const
+		{
+			unsigned long average = Average();
+			return most - average > average - least ? most - average : average - least;
+		}
+
+		unsigned long least;
+		unsigned long most;
+		unsigned long sum;
+	};
+
+
+	/**
+	 * DeadlineBus constructor. Calibrates straight away, so the bus should be
+	 * idle, see Calibrate().
+	 *
+	 * @param[in] line Pin and timer to drive
+	 * @param[in] busSpeed OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+	 */
+	DeadlineBus::DeadlineBus(DeadlineLine& line, unsigned int busSpeed)
+		: worstErrorNS(0)
+		, boundMisses(0)
+		, line(line)
+		, speed(busSpeed)
+		, next(0)
+		, clockCost(0)
+		, lowCost(0)
+		, releaseCost(0)
+		, sampleCost(0)
+		, boundTicks(0)
+		, lastTicks(0)
+		, totalTicks(0)
+	{
+		SetSpeed(busSpeed);
+		Calibrate();
+
+		lastTicks = line.Ticks();
+		next = lastTicks;
+	}
+
+	/**
+	 * Time each line operation OW_CALIBRATION_ROUNDS times. Each is then
+	 * issued its average cost ahead of its deadline. The error bound is the
+	 * furthest any one call strayed from its average, plus a timer read for
+	 * the polling loop and a tick of timer resolution.
+	 *
+	 * The low pulses this makes are as short as a write 1 slot, so run it
+	 * while the bus is idle, ahead of a reset.
+	 */
+	void DeadlineBus::Calibrate(void)
+	{
+		CostRange low, release, sample;
+
+		// Back to back timer reads, the quickest is the cost of one
+		clockCost = ~0UL;
+		for (int i = 0; i < OW_CALIBRATION_ROUNDS; ++i)
+		{
+			unsigned long a = line.Ticks();
+			unsigned long b = line.Ticks();
+
+			if (b - a < clockCost) clockCost = b - a;
+		}
+
+		for (int i = 0; i < OW_CALIBRATION_ROUNDS; ++i)
+		{
+			unsigned long a = line.Ticks();
+			line.Low();
+			unsigned long b = line.Ticks();
+			line.Release();
+			unsigned long c = line.Ticks();
+			line.Sample();
+			unsigned long d = line.Ticks();
+
+			low.Add(b - a > clockCost ? b - a - clockCost : 0);
+			release.Add(c - b > clockCost ? c - b - clockCost : 0);
+			sample.Add(d - c > clockCost ? d - c - clockCost : 0);
+		}
+
+		lowCost = low.Average();
+		releaseCost = release.Average();
+		sampleCost = sample.Average();
+
+		boundTicks = low.Spread();
+		if (release.Spread() > boundTicks) boundTicks = release.Spread();
+		if (sample.Spread() > boundTicks) boundTicks = sample.Spread();
+		boundTicks += clockCost + 1;
+	}
+
+	unsigned long DeadlineBus::ErrorBoundNS(void) const
+	{
+		return TicksToNS(boundTicks);
+	}
+
+	void DeadlineBus::ClearErrors(void)
+	{
+		worstErrorNS = 0;
+		boundMisses = 0;
+	}
+
+	/**
+	 * Convert the timing table to ticks, rounding up so no interval comes out
+	 * shorter than the table asks for
+	 */
+	void DeadlineBus::SetSpeed(unsigned int busSpeed)
+	{
+		const unsigned long* ns = TimingNS(busSpeed);
+		unsigned long long hz = line.TickHz();
+
+		speed = busSpeed;
+		for (int i = 0; i < OW_TIME_COUNT; ++i)
+		{
+			timing[i] = (unsigned long)((ns[i] * hz + 999999999ULL) / 1000000000ULL);
+		}
+
+		line.SetSpeed(busSpeed);
+	}
+
+	unsigned int DeadlineBus::GetSpeed(void) const
+	{
+		return speed;
+	}
+
+	/**
+	 * Timer time in nanoseconds, counting on past the timer's wrap as long as
+	 * this is called at least once per wrap
+	 */
+	unsigned long long DeadlineBus::NowNS(void) const
+	{
+		unsigned long ticks = line.Ticks();
+
+		totalTicks += ticks - lastTicks;
+		lastTicks = ticks;
+
+		return TicksToNS(totalTicks);
+	}
+
+	unsigned long long DeadlineBus::TicksToNS(unsigned long long ticks) const
+	{
+		unsigned long long hz = line.TickHz();
+		return ticks / hz * 1000000000ULL + ticks % hz * 1000000000ULL / hz;
+	}
+
+	/**
+	 * Slots run back to back off the previous slot's end. After a gap, such
+	 * as the caller doing something else, the next slot starts now.
+	 */
+	unsigned long DeadlineBus::Start(void)
+	{
+		unsigned long now = line.Ticks();
+
+		if ((long)(now - next) > 0) next = now;
+		return next;
+	}
+
+	void DeadlineBus::WaitUntil(unsigned long deadline)
+	{
+		while ((long)(line.Ticks() - deadline) < 0) {}
+	}
+
+	/**
+	 * Record how far an edge landed from its deadline. The line operation
+	 * takes effect as it returns, which is a timer read before now.
+	 *
+	 * @return Ticks the edge landed after the deadline, negative if early
+	 */
+	long DeadlineBus::Check(unsigned long deadline)
+	{
+		long error = (long)(line.Ticks() - clockCost - deadline);
+		unsigned long ticks = error < 0 ? -error : error;
+		unsigned long ns = TicksToNS(ticks);
+
+		if (ns > worstErrorNS) worstErrorNS = ns;
+		if (ticks > boundTicks) ++boundMisses;
+
+		return error;
+	}
+
+	/**
+	 * A falling edge that lands later than the error bound starts the slot
+	 * where it actually fell, so the rest of the slot moves with it rather
+	 * than the low pulse and the sample point coming up short.
+	 *
+	 * @return The slot start, the deadline or the late edge
+	 */
+	unsigned long DeadlineBus::Low(unsigned long deadline)
+	{
+		WaitUntil(deadline - lowCost);
+		line.Low();
+
+		long late = Check(deadline);
+		return late > (long)boundTicks ? deadline + late : deadline;
+	}
+
+	void DeadlineBus::Release(unsigned long deadline)
+	{
+		WaitUntil(deadline - releaseCost);
+		line.Release();
+		Check(deadline);
+	}
+
+	BYTE DeadlineBus::Sample(unsigned long deadline)
+	{
+		WaitUntil(deadline - sampleCost);
+		BYTE level = line.Sample();
+		Check(deadline);
+
+		return level;
+	}
+
+	/**
+	 * Reset the bus
+	 *
+	 * @return 1 if a presence pulse was seen
+	 */
+	int DeadlineBus::Reset(void)
+	{
+		unsigned long start = Low(Start() + timing[OW_TIME_G]);
+		unsigned long release = start + timing[OW_TIME_H];
+		unsigned long sample = release + timing[OW_TIME_I];
+
+		Release(release);
+		int presence = Sample(sample) == 0 ? 1 : 0;
+
+		next = sample + timing[OW_TIME_J];
+		return presence;
+	}
+
+	void DeadlineBus::WriteBit(BYTE bit)
+	{
+		unsigned long start = Low(Start());
+		unsigned long release = start + (bit & 0x01 ? timing[OW_TIME_A] : timing[OW_TIME_C]);
+
+		Release(release);
+
+		next = release + (bit & 0x01 ? timing[OW_TIME_B] : timing[OW_TIME_D]);
+	}
+
+	BYTE DeadlineBus::ReadBit(void)
+	{
+		unsigned long start = Low(Start());
+		unsigned long release = start + timing[OW_TIME_A];
+		unsigned long sample = release + timing[OW_TIME_E];
+
+		Release(release);
+		BYTE level = Sample(sample) & 0x01;
+
+		next = sample + timing[OW_TIME_F];
+		return level;
+	}
+
+	/**
+	 * Wait from the end of the last slot, or from now if that has passed
+	 */
+	void DeadlineBus::WaitUS(unsigned int us)
+	{
+		unsigned long long ticks = (us * (unsigned long long)line.TickHz() + 999999) / 1000000;
+
+		next = Start() + (unsigned long)ticks;
+		WaitUntil(next);
+	}
+
+} // Namespace OneWire
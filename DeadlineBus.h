@@ -0,0 +1,146 @@
+/**
+ * @file DeadlineBus.h
+ *
+ * DeadlineBus class prototype. A bit-banged transport that times every edge
+ * against an absolute deadline on a free-running timer, instead of stringing
+ * delay loops together. Time lost to calls and pin access within a slot is
+ * made up by the next wait rather than added on, so nothing accumulates over
+ * a byte or the 64 triplets of a search pass.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DEADLINEBUS_H
+#define STELLARIS_ONEWIRE_DEADLINEBUS_H
+
+
+#include "OneWireBus.h"
+#include "OneWireTiming.h"
+
+
+// Calls timed by Calibrate() for each kind of overhead
+#ifndef OW_CALIBRATION_ROUNDS
+#define OW_CALIBRATION_ROUNDS	64
+#endif // OW_CALIBRATION_ROUNDS
+
+
+namespace OneWire
+{
+
+	/**
+	 * Pin and free-running timer for DeadlineBus
+	 *
+	 * Ticks() counts up at TickHz() and may wrap, only differences of less
+	 * than half its range are ever used.
+	 */
+	class DeadlineLine
+	{
+	public:
+		virtual ~DeadlineLine() {}
+
+		// Line control
+		virtual void Low(void) = 0;
+		virtual void Release(void) = 0;
+		virtual BYTE Sample(void) = 0;
+
+		// Free-running timer
+		virtual unsigned long Ticks(void) = 0;
+		virtual unsigned long TickHz(void) const = 0;
+
+		// Bus speed change, for lines that have to know such as simulators
+		virtual void SetSpeed(unsigned int) {}
+	};
+
+
+	/**
+	 * OneWire transport timed by deadlines
+	 *
+	 * Each slot is laid out from its start time using the timing table, every
+	 * edge being issued early by the calibrated cost of getting it onto the
+	 * pin. A slot starts where the previous one was due to end, or now if
+	 * that has already passed. Calibrate() runs from the constructor, and can
+	 * be run again if the clock changes.
+	 */
+	class DeadlineBus : public OneWireBus
+	{
+	public:
+		DeadlineBus(DeadlineLine& line, unsigned int busSpeed = OW_SPEED_STANDARD);
+
+		// OneWireBus interface
+		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
+		void WaitUS(unsigned int us);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+		unsigned long long NowNS(void) const;
+
+		// Measure the overhead of the timer and of each line operation
+		void Calibrate(void);
+
+		// How far an edge can land from its deadline, from the calibration
+		unsigned long ErrorBoundNS(void) const;
+
+		// Furthest any edge has landed from its deadline so far, and the
+		// number of edges that missed the bound
+		unsigned long worstErrorNS;
+		unsigned long boundMisses;
+		void ClearErrors(void);
+
+	private:
+		// Where the next slot starts
+		unsigned long Start(void);
+
+		// Busy wait for a deadline
+		void WaitUntil(unsigned long deadline);
+
+		// Issue an edge or sample so it lands on the deadline, and check how
+		// close it came. Low() returns the time to run the rest of the slot
+		// from.
+		unsigned long Low(unsigned long deadline);
+		void Release(unsigned long deadline);
+		BYTE Sample(unsigned long deadline);
+		long Check(unsigned long deadline);
+
+		unsigned long long TicksToNS(unsigned long long ticks) const;
+
+		DeadlineLine& line;
+		unsigned int speed;
+
+		// Timing table of the current speed in ticks, rounded up
+		unsigned long timing[OW_TIME_COUNT];
+
+		// End of the last slot
+		unsigned long next;
+
+		// Calibrated costs in ticks of reading the timer and of each line
+		// operation, and the error bound
+		unsigned long clockCost;
+		unsigned long lowCost;
+		unsigned long releaseCost;
+		unsigned long sampleCost;
+		unsigned long boundTicks;
+
+		// NowNS() extends the timer past its wrap
+		mutable unsigned long lastTicks;
+		mutable unsigned long long totalTicks;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DEADLINEBUS_H
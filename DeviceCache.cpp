@@ -0,0 +1,304 @@
+/**
+ * @file DeviceCache.cpp
+ *
+ * Per device cache of readings
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "DeviceCache.h"
+#include "DS18X20.h"
+
+#include <string.h>
+
+
+namespace OneWire
+{
+
+	/**
+	 * Read a scratchpad and check it the way DS18X20 does: CRC, and not the
+	 * all-zero reading of a shorted bus
+	 */
+	bool FetchScratchpad(OneWireMaster& master, ROM rom, BYTE* data, void* context)
+	{
+		Transaction t;
+
+		(void)context;
+
+		// Read Scratchpad, common to most sensors
+		t.Match(rom).Command(OW_READ_SCRATCHPAD).Read(data, OW_CACHE_DATA_SIZE);
+
+		return master.Execute(t) == TRANSACTION_OK
+			&& CheckScratchpad(data, OW_CACHE_DATA_SIZE);
+	}
+
+	/**
+	 * DeviceCache constructor
+	 *
+	 * @param[in] master Master the devices are reached through
+	 * @param[in] fetch How to read a device, FetchScratchpad() by default
+	 * @param[in] context Passed to fetch untouched
+	 */
+	DeviceCache::DeviceCache(OneWireMaster& master, CacheFetch fetch, void* context)
+		: master(master)
+		, fetch(fetch)
+		, context(context)
+		, entryCount(0)
+		, pendingCount(0)
+		, familyCount(0)
+	{
+		ClearCounters();
+	}
+
+	/**
+	 * Set the freshness window of a family, 0 to always read
+	 */
+	void DeviceCache::SetFreshness(BYTE family, unsigned long ms)
+	{
+		for (unsigned int i = 0; i < familyCount; ++i)
+		{
+			if (families[i] != family) continue;
+
+			windows[i] = ms;
+			return;
+		}
+
+		if (familyCount == OW_CACHE_FAMILIES) return;
+
+		families[familyCount] = family;
+		windows[familyCount] = ms;
+		++familyCount;
+	}
+
+	unsigned long DeviceCache::GetFreshness(BYTE family) const
+	{
+		for (unsigned int i = 0; i < familyCount; ++i)
+		{
+			if (families[i] == family) return windows[i];
+		}
+
+		return OW_CACHE_DEFAULT_MS;
+	}
+
+	/**
+	 * Get a reading, from the cache if it is fresh enough
+	 *
+	 * @param[in] rom Device to read
+	 * @param[in] nowMS Free running millisecond clock, may wrap
+	 * @param[out] data OW_CACHE_DATA_SIZE bytes of reading
+	 * @return false if the device couldn't be read
+	 */
+	bool DeviceCache::Get(ROM rom, unsigned long nowMS, BYTE* data)
+	{
+		Entry* entry = Fresh(rom, nowMS);
+
+		if (entry)
+		{
+			++hits;
+		}
+		else
+		{
+			++misses;
+			entry = Fetch(rom, nowMS);
+			if (!entry) return false;
+		}
+
+		memcpy(data, entry->data, OW_CACHE_DATA_SIZE);
+		return true;
+	}
+
+	/**
+	 * Queue a request for a reading. The callback is run from Service(),
+	 * along with every other request for the same device.
+	 *
+	 * @return false if the request queue is full
+	 */
+	bool DeviceCache::Request(ROM rom, CacheCallback callback, void* context)
+	{
+		if (pendingCount == OW_CACHE_REQUESTS) return false;
+
+		pending[pendingCount].rom = rom;
+		pending[pendingCount].callback = callback;
+		pending[pendingCount].context = context;
+		++pendingCount;
+
+		return true;
+	}
+
+	/**
+	 * Answer every request queued when called. Each device is read from the
+	 * bus at most once, however many requests there are for it. Requests made
+	 * by the callbacks wait for the next call, so a callback that always asks
+	 * again can't keep Service() from returning.
+	 *
+	 * @param[in] nowMS Free running millisecond clock, may wrap
+	 * @return Number of bus reads done
+	 */
+	int DeviceCache::Service(unsigned long nowMS)
+	{
+		int reads = 0;
+		unsigned int remaining = pendingCount;
+
+		// The requests being served stay at the front of the queue
+		while (remaining)
+		{
+			ROM rom = pending[0].rom;
+			Entry* entry = Fresh(rom, nowMS);
+			bool first = true;
+
+			if (entry)
+			{
+				++hits;
+			}
+			else
+			{
+				++misses;
+				entry = Fetch(rom, nowMS);
+				++reads;
+			}
+
+			// Take every request for this device off the queue, keeping the
+			// others in order, before answering any of them: a callback may
+			// Request() again, which appends to the queue
+			Pending answered[OW_CACHE_REQUESTS];
+			unsigned int answeredCount = 0;
+			unsigned int kept = 0;
+			for (unsigned int i = 0; i < pendingCount; ++i)
+			{
+				if (i >= remaining || pending[i].rom != rom)
+				{
+					pending[kept++] = pending[i];
+					continue;
+				}
+
+				if (!first) ++coalesced;
+				first = false;
+
+				answered[answeredCount++] = pending[i];
+			}
+			pendingCount = kept;
+			remaining -= answeredCount;
+
+			// Callbacks may also Get() and refill or evict the entry, so
+			// hand them a copy of the reading
+			BYTE data[OW_CACHE_DATA_SIZE];
+			if (entry) memcpy(data, entry->data, OW_CACHE_DATA_SIZE);
+
+			for (unsigned int i = 0; i < answeredCount; ++i)
+			{
+				if (answered[i].callback)
+				{
+					answered[i].callback(rom, entry ? data : 0, entry != 0,
+						answered[i].context);
+				}
+			}
+		}
+
+		return reads;
+	}
+
+	void DeviceCache::Invalidate(ROM rom)
+	{
+		for (unsigned int i = 0; i < entryCount; ++i)
+		{
+			if (entries[i].rom == rom) entries[i].valid = false;
+		}
+	}
+
+	void DeviceCache::Clear(void)
+	{
+		entryCount = 0;
+	}
+
+	void DeviceCache::ClearCounters(void)
+	{
+		hits = 0;
+		misses = 0;
+		coalesced = 0;
+		evictions = 0;
+		failures = 0;
+	}
+
+	DeviceCache::Entry* DeviceCache::Fresh(ROM rom, unsigned long nowMS)
+	{
+		for (unsigned int i = 0; i < entryCount; ++i)
+		{
+			Entry& e = entries[i];
+
+			if (e.rom != rom) continue;
+			if (!e.valid) return 0;
+			if (nowMS - e.timeMS >= GetFreshness(FamilyCode(rom))) return 0;
+
+			return &e;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Read a device into its entry, taking over the oldest entry if it
+	 * doesn't have one yet. A failed read returns 0 and changes nothing.
+	 */
+	DeviceCache::Entry* DeviceCache::Fetch(ROM rom, unsigned long nowMS)
+	{
+		BYTE data[OW_CACHE_DATA_SIZE];
+		Entry* entry = 0;
+
+		// A failed read leaves whatever the cache had alone
+		if (!fetch(master, rom, data, context))
+		{
+			++failures;
+			return 0;
+		}
+
+		for (unsigned int i = 0; i < entryCount && !entry; ++i)
+		{
+			if (entries[i].rom == rom) entry = &entries[i];
+		}
+
+		if (!entry && entryCount < OW_CACHE_ENTRIES)
+		{
+			entry = &entries[entryCount++];
+		}
+		else if (!entry)
+		{
+			// Oldest goes, invalid ones first
+			entry = &entries[0];
+			for (unsigned int i = 1; i < entryCount; ++i)
+			{
+				Entry& e = entries[i];
+
+				if (!entry->valid) break;
+				if (!e.valid || nowMS - e.timeMS > nowMS - entry->timeMS) entry = &e;
+			}
+
+			if (entry->valid && nowMS - entry->timeMS < GetFreshness(FamilyCode(entry->rom)))
+				++evictions;
+		}
+
+		entry->rom = rom;
+		entry->timeMS = nowMS;
+		entry->valid = true;
+		memcpy(entry->data, data, OW_CACHE_DATA_SIZE);
+
+		return entry;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,154 @@
+/**
+ * @file DeviceCache.h
+ *
+ * DeviceCache class prototype. Keeps the last data read from each device, so
+ * repeated requests for the same reading don't each cost a bus transaction.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DEVICECACHE_H
+#define STELLARIS_ONEWIRE_DEVICECACHE_H
+
+
+#include "OneWireMaster.h"
+
+
+// Number of devices the cache holds, the oldest entry makes room for a new one
+#ifndef OW_CACHE_ENTRIES
+#define OW_CACHE_ENTRIES	32
+#endif // OW_CACHE_ENTRIES
+
+// Bytes of data kept per device, a DS18X20 scratchpad by default
+#ifndef OW_CACHE_DATA_SIZE
+#define OW_CACHE_DATA_SIZE	9
+#endif // OW_CACHE_DATA_SIZE
+
+// Number of asynchronous requests that can wait for Service() at once
+#ifndef OW_CACHE_REQUESTS
+#define OW_CACHE_REQUESTS	16
+#endif // OW_CACHE_REQUESTS
+
+// Number of families that can have their own freshness window
+#ifndef OW_CACHE_FAMILIES
+#define OW_CACHE_FAMILIES	8
+#endif // OW_CACHE_FAMILIES
+
+// Freshness window for families without one of their own, in ms
+#ifndef OW_CACHE_DEFAULT_MS
+#define OW_CACHE_DEFAULT_MS	1000
+#endif // OW_CACHE_DEFAULT_MS
+
+
+namespace OneWire
+{
+
+	/**
+	 * Reads OW_CACHE_DATA_SIZE bytes of fresh data from a device, returns
+	 * false if that failed
+	 */
+	typedef bool (*CacheFetch)(OneWireMaster& master, ROM rom, BYTE* data, void* context);
+
+	/**
+	 * Completion of a DeviceCache::Request()
+	 */
+	typedef void (*CacheCallback)(ROM rom, const BYTE* data, bool valid, void* context);
+
+	// Default fetch, a Read Scratchpad checked with CRC8 and rejected all zero
+	bool FetchScratchpad(OneWireMaster& master, ROM rom, BYTE* data, void* context);
+
+
+	/**
+	 * Per device cache of readings
+	 *
+	 * A reading is fresh for the window set for the device's family. Get()
+	 * answers from the cache while the reading is fresh and goes to the bus
+	 * when it isn't. Request() queues the question instead, and Service()
+	 * answers every queued request for the same device with a single read.
+	 */
+	class DeviceCache
+	{
+	public:
+		DeviceCache(OneWireMaster& master, CacheFetch fetch = FetchScratchpad, void* context = 0);
+
+		// How long readings of a family stay fresh
+		void SetFreshness(BYTE family, unsigned long ms);
+		unsigned long GetFreshness(BYTE family) const;
+
+		// Reading for rom, from the cache or the bus
+		bool Get(ROM rom, unsigned long nowMS, BYTE* data);
+
+		// Queue a request, returns false if the queue is full
+		bool Request(ROM rom, CacheCallback callback, void* context);
+
+		// Answer queued requests, returns the number of bus reads done.
+		// Callbacks may Request() again, those are answered in the same call
+		int Service(unsigned long nowMS);
+
+		// Forget one device, or everything
+		void Invalidate(ROM rom);
+		void Clear(void);
+
+		// Statistics
+		unsigned long hits;		// Answered from the cache
+		unsigned long misses;		// Had to go to the bus
+		unsigned long coalesced;	// Requests that shared another's read
+		unsigned long evictions;	// Fresh entries pushed out for room
+		unsigned long failures;		// Fetches that failed
+		void ClearCounters(void);
+
+	private:
+		struct Entry
+		{
+			ROM rom;
+			unsigned long timeMS;
+			bool valid;
+			BYTE data[OW_CACHE_DATA_SIZE];
+		};
+
+		struct Pending
+		{
+			ROM rom;
+			CacheCallback callback;
+			void* context;
+		};
+
+		// Entry for rom if it's fresh, 0 otherwise
+		Entry* Fresh(ROM rom, unsigned long nowMS);
+
+		// Read rom from the bus into its entry, 0 if that failed
+		Entry* Fetch(ROM rom, unsigned long nowMS);
+
+		OneWireMaster& master;
+		CacheFetch fetch;
+		void* context;
+
+		Entry entries[OW_CACHE_ENTRIES];
+		unsigned int entryCount;
+
+		Pending pending[OW_CACHE_REQUESTS];
+		unsigned int pendingCount;
+
+		BYTE families[OW_CACHE_FAMILIES];
+		unsigned long windows[OW_CACHE_FAMILIES];
+		unsigned int familyCount;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DEVICECACHE_H
@@ -0,0 +1,350 @@
+/**
+ * @file DeviceSnapshot.cpp
+ *
+ * DeviceSnapshot and WarmStart class methods, see DeviceSnapshot.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DeviceSnapshot.h"
+
+
+namespace OneWire
+{
+
+	static const BYTE magic[4] = {'O', 'W', 'D', 'T'};
+
+
+	DeviceSnapshot::DeviceSnapshot()
+		: count(0)
+	{
+	}
+
+	unsigned int DeviceSnapshot::Count(void) const
+	{
+		return count;
+	}
+
+	const SnapshotEntry& DeviceSnapshot::operator[](unsigned int index) const
+	{
+		return entries[index];
+	}
+
+	void DeviceSnapshot::Clear(void)
+	{
+		count = 0;
+	}
+
+	int DeviceSnapshot::IndexOf(ROM rom) const
+	{
+		ROM key = SortKey(rom);
+		unsigned int low = 0;
+		unsigned int high = count;
+
+		while (low < high)
+		{
+			unsigned int mid = low + (high - low) / 2;
+
+			if (SortKey(entries[mid].rom) < key) low = mid + 1;
+			else high = mid;
+		}
+
+		return low < count && entries[low].rom == rom ? (int)low : -1;
+	}
+
+	SnapshotEntry* DeviceSnapshot::Find(ROM rom)
+	{
+		int index = IndexOf(rom);
+		return index < 0 ? 0 : &entries[index];
+	}
+
+	const SnapshotEntry* DeviceSnapshot::Find(ROM rom) const
+	{
+		int index = IndexOf(rom);
+		return index < 0 ? 0 : &entries[index];
+	}
+
+	/**
+	 * Replace the contents with a device table. Both are in the same order,
+	 * so what is known about the old entries is picked up in a single walk.
+	 *
+	 * @param[in] devices Devices to keep
+	 * @param[in] speed Speed of devices that weren't in the snapshot
+	 */
+	void DeviceSnapshot::Capture(const DeviceTable& devices, unsigned int speed)
+	{
+		BYTE speeds[OW_MAX_NUM_DEVICES];
+		BYTE resolutions[OW_MAX_NUM_DEVICES];
+		unsigned int n = devices.Count() < OW_MAX_NUM_DEVICES
+			? devices.Count()
+			: OW_MAX_NUM_DEVICES;
+		unsigned int old = 0;
+
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			ROM key = SortKey(devices[i]);
+
+			while (old < count && SortKey(entries[old].rom) < key) ++old;
+
+			if (old < count && entries[old].rom == devices[i])
+			{
+				speeds[i] = entries[old].speed;
+				resolutions[i] = entries[old].resolution;
+			}
+			else
+			{
+				speeds[i] = speed;
+				resolutions[i] = 0;
+			}
+		}
+
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			entries[i].rom = devices[i];
+			entries[i].speed = speeds[i];
+			entries[i].resolution = resolutions[i];
+		}
+		count = n;
+	}
+
+	bool DeviceSnapshot::SetSpeed(ROM rom, unsigned int speed)
+	{
+		SnapshotEntry* entry = Find(rom);
+		if (!entry) return false;
+
+		entry->speed = speed;
+		return true;
+	}
+
+	bool DeviceSnapshot::SetResolution(ROM rom, int bits)
+	{
+		SnapshotEntry* entry = Find(rom);
+		if (!entry) return false;
+
+		entry->resolution = bits;
+		return true;
+	}
+
+	unsigned int DeviceSnapshot::Size(void) const
+	{
+		return OW_SNAPSHOT_BYTES(count);
+	}
+
+	/**
+	 * Serialize the snapshot, see OW_SNAPSHOT_BYTES for the layout
+	 *
+	 * @param[out] buffer Filled with the snapshot
+	 * @param[in] len Size of buffer
+	 * @return Bytes written, 0 if buffer is too small
+	 */
+	unsigned int DeviceSnapshot::Save(BYTE* buffer, unsigned int len) const
+	{
+		unsigned int size = Size();
+		BYTE* p = buffer;
+
+		if (len < size) return 0;
+
+		for (int i = 0; i < 4; ++i) *p++ = magic[i];
+		*p++ = OW_SNAPSHOT_VERSION;
+		*p++ = OW_SNAPSHOT_ENTRY;
+		*p++ = count & 0xFF;
+		*p++ = count >> 8;
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			UnpackROM(entries[i].rom, p);
+			p[8] = entries[i].speed;
+			p[9] = entries[i].resolution;
+			p += OW_SNAPSHOT_ENTRY;
+		}
+
+		unsigned short crc = CRC16Final(CRC16Update(CRC16Init(), buffer, p - buffer));
+		*p++ = crc & 0xFF;
+		*p++ = crc >> 8;
+
+		return size;
+	}
+
+	/**
+	 * Read a snapshot written by Save(). Besides the CRC, every ROM has to
+	 * pass its own CRC8 and the entries have to be in device table order.
+	 *
+	 * @param[in] buffer Snapshot, trailing bytes after it are ignored
+	 * @param[in] len Bytes available in buffer
+	 * @return true if the snapshot was loaded
+	 */
+	bool DeviceSnapshot::Load(const BYTE* buffer, unsigned int len)
+	{
+		count = 0;
+
+		if (len < OW_SNAPSHOT_BYTES(0)) return false;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			if (buffer[i] != magic[i]) return false;
+		}
+		if (buffer[4] != OW_SNAPSHOT_VERSION || buffer[5] != OW_SNAPSHOT_ENTRY) return false;
+
+		unsigned int n = buffer[6] | (buffer[7] << 8);
+		if (n > OW_MAX_NUM_DEVICES || len < OW_SNAPSHOT_BYTES(n)) return false;
+
+		if (CRC16Update(CRC16Init(), buffer, OW_SNAPSHOT_BYTES(n)) != OW_CRC16_RESIDUE)
+		{
+			return false;
+		}
+
+		const BYTE* p = buffer + OW_SNAPSHOT_HEADER;
+		for (unsigned int i = 0; i < n; ++i, p += OW_SNAPSHOT_ENTRY)
+		{
+			ROM rom = PackROM(p);
+
+			if (CRC8Update(CRC8Init(), p, 8) != 0) return false;
+			if (i && SortKey(rom) <= SortKey(entries[i - 1].rom)) return false;
+
+			entries[i].rom = rom;
+			entries[i].speed = p[8];
+			entries[i].resolution = p[9];
+		}
+
+		count = n;
+		return true;
+	}
+
+
+	/**
+	 * WarmStart constructor
+	 *
+	 * @param[in] master Master whose device table is restored
+	 * @param[in] handler Event callback for the background search, may be 0
+	 * @param[in] context Passed to the callback untouched
+	 */
+	WarmStart::WarmStart
+		( OneWireMaster& master
+		, DeviceEventHandler handler
+		, void* context
+		)
+		: verifyCount(0)
+		, passCount(0)
+		, master(master)
+		, handler(handler)
+		, context(context)
+		, done(false)
+	{
+	}
+
+	/**
+	 * Verify every snapshot device with VerifyAll(), one pass each. Those
+	 * passes also show where devices the snapshot doesn't have branch off
+	 * the known paths, and those are searched for and reported as added.
+	 * The background search is started over.
+	 *
+	 * @return Number of snapshot devices that answered, now in master.devices
+	 */
+	int WarmStart::Restore(const DeviceSnapshot& snapshot)
+	{
+		int present;
+
+		master.devices.Clear();
+		for (unsigned int i = 0; i < snapshot.Count(); ++i)
+		{
+			master.devices.Insert(snapshot[i].rom);
+		}
+
+		verifyCount += master.devices.Count();
+		present = master.VerifyAll(missing, found);
+
+		for (unsigned int i = 0; i < missing.Count(); ++i)
+		{
+			master.devices.Remove(missing[i]);
+		}
+
+		for (unsigned int i = 0; i < found.Count(); ++i)
+		{
+			if (!master.devices.Insert(found[i])) break;
+			if (handler) handler(found[i], true, context);
+		}
+
+		found.Clear();
+		state.Begin();
+		done = false;
+
+		return present;
+	}
+
+	/**
+	 * Run one pass of the background search. Other bus traffic can go on in
+	 * between, every pass starts with its own reset.
+	 *
+	 * @return Number of events delivered
+	 */
+	int WarmStart::Step(void)
+	{
+		if (done) return 0;
+
+		++passCount;
+
+		switch (master.SearchStep(state))
+		{
+		case SEARCH_FOUND:
+			found.Insert(state.rom);
+
+			if (master.devices.Contains(state.rom)) return 0;
+			if (!master.devices.Insert(state.rom)) return 0;
+
+			missing.Remove(state.rom);
+			if (handler) handler(state.rom, true, context);
+			return 1;
+
+		case SEARCH_DONE:
+			return Finish();
+
+		default:
+			// The state is left as it was, the next step runs the pass again
+			return 0;
+		}
+	}
+
+	bool WarmStart::Done(void) const
+	{
+		return done;
+	}
+
+	int WarmStart::Finish(void)
+	{
+		int events = 0;
+
+		done = true;
+
+		// Walking down so removing doesn't skip entries
+		for (unsigned int i = master.devices.Count(); i-- > 0; )
+		{
+			ROM rom = master.devices[i];
+
+			if (found.Contains(rom)) continue;
+
+			master.devices.Remove(rom);
+			missing.Insert(rom);
+			if (handler) handler(rom, false, context);
+			++events;
+		}
+
+		return events;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,164 @@
+/**
+ * @file DeviceSnapshot.h
+ *
+ * DeviceSnapshot and WarmStart class prototypes. A snapshot is the device
+ * table saved in a small CRC16 protected binary format, along with what is
+ * known about each device. At boot the devices in it are checked one by one
+ * with Verify(), which is far quicker than a search of the whole bus, and a
+ * search run a pass at a time in the background confirms the rest.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DEVICESNAPSHOT_H
+#define STELLARIS_ONEWIRE_DEVICESNAPSHOT_H
+
+
+#include "BusMonitor.h"
+
+
+// Snapshot format, all multi-byte fields little endian:
+//   0  'O' 'W' 'D' 'T'
+//   4  Format version
+//   5  Entry size in bytes
+//   6  Entry count, 2 bytes
+//   8  Entries: ROM in wire order (family code first), speed, resolution
+//   .. Inverted CRC16 of everything before it, as memory devices send it
+#define OW_SNAPSHOT_VERSION		1
+#define OW_SNAPSHOT_HEADER		8
+#define OW_SNAPSHOT_ENTRY		10
+#define OW_SNAPSHOT_BYTES(n)	(OW_SNAPSHOT_HEADER + (n) * OW_SNAPSHOT_ENTRY + 2)
+
+
+namespace OneWire
+{
+
+	/**
+	 * What a snapshot keeps about one device
+	 */
+	struct SnapshotEntry
+	{
+		ROM rom;
+
+		// Speed the device was last used at, OW_SPEED_*
+		BYTE speed;
+
+		// Thermometer resolution in bits, 0 if unknown or not a thermometer
+		BYTE resolution;
+	};
+
+
+	/**
+	 * Saved device table
+	 *
+	 * Entries are kept in device table order, so the family of a ROM is the
+	 * first byte of its entry and Find() is a binary search. The capacity is
+	 * the device table's.
+	 */
+	class DeviceSnapshot
+	{
+	public:
+		DeviceSnapshot();
+
+		// Contents
+		unsigned int Count(void) const;
+		const SnapshotEntry& operator[](unsigned int index) const;
+		SnapshotEntry* Find(ROM rom);
+		const SnapshotEntry* Find(ROM rom) const;
+		void Clear(void);
+
+		// Take every device of a table, keeping what is already known about
+		// those that were in the snapshot before. New ones are at speed.
+		void Capture(const DeviceTable& devices, unsigned int speed = OW_SPEED_STANDARD);
+
+		// Record what is known about one device, false if it isn't in the
+		// snapshot
+		bool SetSpeed(ROM rom, unsigned int speed);
+		bool SetResolution(ROM rom, int bits);
+
+		// Serialized size, see OW_SNAPSHOT_BYTES
+		unsigned int Size(void) const;
+
+		// Write the snapshot to a buffer, returns the bytes written or 0 if
+		// it doesn't fit
+		unsigned int Save(BYTE* buffer, unsigned int len) const;
+
+		// Read a snapshot back. Anything but an intact snapshot of this
+		// format, erased flash included, leaves it empty and returns false.
+		bool Load(const BYTE* buffer, unsigned int len);
+
+	private:
+		// Index of a ROM, or -1
+		int IndexOf(ROM rom) const;
+
+		SnapshotEntry entries[OW_MAX_NUM_DEVICES];
+		unsigned int count;
+	};
+
+
+	/**
+	 * Boot from a snapshot
+	 *
+	 * Restore() verifies each device in the snapshot and puts those that
+	 * answer in the master's device table, so they can be used right away,
+	 * along with any new devices the verification passes turn up. After that
+	 * every Step() runs one pass of a full search. Devices still unknown are
+	 * added as soon as a pass finds them, and once the search is complete
+	 * those it didn't find are removed. Both are reported through the
+	 * handler, as BusMonitor does.
+	 */
+	class WarmStart
+	{
+	public:
+		WarmStart(OneWireMaster& master, DeviceEventHandler handler, void* context);
+
+		// Verify the snapshot devices and load the master's device table
+		// with them, returns how many of them answered
+		int Restore(const DeviceSnapshot& snapshot);
+
+		// Run one search pass, returns the number of events delivered
+		int Step(void);
+
+		// Set once a whole search has confirmed the device table
+		bool Done(void) const;
+
+		// Snapshot devices that didn't answer their verification
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> missing;
+
+		// Work done so far
+		unsigned long verifyCount;
+		unsigned long passCount;
+
+	private:
+		// The search is complete, drop what it didn't find
+		int Finish(void);
+
+		OneWireMaster& master;
+		DeviceEventHandler handler;
+		void* context;
+
+		SearchState state;
+		bool done;
+
+		// Devices seen by the background search
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> found;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DEVICESNAPSHOT_H
@@ -0,0 +1,189 @@
+/**
+ * @file DeviceTable.cpp
+ *
+ * Fixed capacity sorted table of ROM IDs
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "DeviceTable.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * DeviceTable constructor
+	 *
+	 * @param[in] storage Space for capacity ROM IDs, owned by the caller
+	 * @param[in] capacity Maximum number of entries
+	 */
+	DeviceTable::DeviceTable(ROM* storage, unsigned int capacity)
+		: storage(storage)
+		, capacity(capacity)
+		, count(0)
+	{
+	}
+
+	void DeviceTable::Assign(const DeviceTable& other)
+	{
+		if (&other == this) return;
+
+		count = other.count < capacity ? other.count : capacity;
+		for (unsigned int i = 0; i < count; ++i) storage[i] = other.storage[i];
+	}
+
+	unsigned int DeviceTable::Count(void) const
+	{
+		return count;
+	}
+
+	unsigned int DeviceTable::Capacity(void) const
+	{
+		return capacity;
+	}
+
+	bool DeviceTable::Full(void) const
+	{
+		return count == capacity;
+	}
+
+	ROM DeviceTable::operator[](unsigned int index) const
+	{
+		return storage[index];
+	}
+
+	const ROM* DeviceTable::Begin(void) const
+	{
+		return storage;
+	}
+
+	const ROM* DeviceTable::End(void) const
+	{
+		return storage + count;
+	}
+
+	unsigned int DeviceTable::LowerBound(ROM key) const
+	{
+		unsigned int low = 0;
+		unsigned int high = count;
+
+		while (low < high)
+		{
+			unsigned int mid = low + (high - low) / 2;
+
+			if (SortKey(storage[mid]) < key) low = mid + 1;
+			else high = mid;
+		}
+
+		return low;
+	}
+
+	/**
+	 * Insert a ROM in sorted position
+	 *
+	 * @return false if the ROM is not present and there is no room for it
+	 */
+	bool DeviceTable::Insert(ROM rom)
+	{
+		unsigned int index = LowerBound(SortKey(rom));
+
+		if (index < count && storage[index] == rom) return true;
+		if (count == capacity) return false;
+
+		for (unsigned int i = count; i > index; --i) storage[i] = storage[i - 1];
+		storage[index] = rom;
+		++count;
+
+		return true;
+	}
+
+	/**
+	 * Remove a ROM
+	 *
+	 * @return false if the ROM was not in the table
+	 */
+	bool DeviceTable::Remove(ROM rom)
+	{
+		int index = Find(rom);
+
+		if (index < 0) return false;
+
+		--count;
+		for (unsigned int i = index; i < count; ++i) storage[i] = storage[i + 1];
+
+		return true;
+	}
+
+	void DeviceTable::Clear(void)
+	{
+		count = 0;
+	}
+
+	int DeviceTable::Find(ROM rom) const
+	{
+		unsigned int index = LowerBound(SortKey(rom));
+
+		if (index < count && storage[index] == rom) return index;
+		return -1;
+	}
+
+	bool DeviceTable::Contains(ROM rom) const
+	{
+		return Find(rom) >= 0;
+	}
+
+	/**
+	 * Locate every entry of one family
+	 *
+	 * @param[in] family Family code to look for
+	 * @param[out] first Index of the first entry of the family
+	 * @return Number of entries of the family
+	 */
+	unsigned int DeviceTable::FamilyRange(BYTE family, unsigned int& first) const
+	{
+		ROM key = (ROM)family << 56;
+
+		first = LowerBound(key);
+
+		// Upper bound is the start of the next family, or the end of the table
+		if (family == 0xFF) return count - first;
+		return LowerBound((ROM)(family + 1) << 56) - first;
+	}
+
+	/**
+	 * Check for an entry in a subtree of the search tree
+	 *
+	 * @param[in] prefix Path from the root, bit 0 first
+	 * @param[in] length Number of bits of prefix that have to match
+	 */
+	bool DeviceTable::ContainsPrefix(ROM prefix, int length) const
+	{
+		ROM mask = length >= 64 ? ~(ROM)0 : ((ROM)1 << length) - 1;
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (((storage[i] ^ prefix) & mask) == 0) return true;
+		}
+
+		return false;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,160 @@
+/**
+ * @file DeviceTable.h
+ *
+ * DeviceTable class prototype. A fixed capacity, sorted table of 64 bit ROM
+ * IDs, used to hold the results of a bus search without touching the heap.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DEVICETABLE_H
+#define STELLARIS_ONEWIRE_DEVICETABLE_H
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Pack 8 ROM bytes, family code first, into a ROM
+	 */
+	inline ROM PackROM(const BYTE* bytes)
+	{
+		ROM rom = 0;
+		for (int i = 7; i >= 0; --i) rom = (rom << 8) | bytes[i];
+		return rom;
+	}
+
+	/**
+	 * Unpack a ROM into 8 bytes, family code first
+	 */
+	inline void UnpackROM(ROM rom, BYTE* bytes)
+	{
+		for (int i = 0; i < 8; ++i, rom >>= 8) bytes[i] = rom & 0xFF;
+	}
+
+	inline BYTE FamilyCode(ROM rom)
+	{
+		return rom & 0xFF;
+	}
+
+	/**
+	 * DeviceTable sort key, the ROM rotated so the family code is the top
+	 * byte. Anything kept in table order compares these.
+	 */
+	inline ROM SortKey(ROM rom)
+	{
+		return (rom >> 8) | (rom << 56);
+	}
+
+
+	/**
+	 * Sorted table of ROM IDs
+	 *
+	 * Entries are kept ordered by family code and then by the rest of the ID, so
+	 * lookups are a binary search and all devices of one family sit next to
+	 * each other. The storage comes from StaticDeviceTable, which fixes the
+	 * capacity at compile time.
+	 */
+	class DeviceTable
+	{
+	public:
+		// Table contents, in sorted order
+		unsigned int Count(void) const;
+		unsigned int Capacity(void) const;
+		bool Full(void) const;
+		ROM operator[](unsigned int index) const;
+		const ROM* Begin(void) const;
+		const ROM* End(void) const;
+
+		// Add a ROM, returns false only if the table is full. Adding a ROM that
+		// is already present does nothing.
+		bool Insert(ROM rom);
+		bool Remove(ROM rom);
+		void Clear(void);
+
+		// Index of a ROM, or -1 if it is not in the table
+		int Find(ROM rom) const;
+		bool Contains(ROM rom) const;
+
+		// Entries of one family are [first, first + count)
+		unsigned int FamilyRange(BYTE family, unsigned int& first) const;
+
+		// Whether any entry starts with the first length bits of prefix, in
+		// search order. This is a linear scan.
+		bool ContainsPrefix(ROM prefix, int length) const;
+
+	protected:
+		DeviceTable(ROM* storage, unsigned int capacity);
+
+		// Copy another table's entries, up to our capacity
+		void Assign(const DeviceTable& other);
+
+	private:
+		// Not copyable on its own, the storage belongs to the derived class
+		DeviceTable(const DeviceTable&);
+		DeviceTable& operator=(const DeviceTable&);
+
+		// First index whose key is not less than key
+		unsigned int LowerBound(ROM key) const;
+
+		ROM* storage;
+		unsigned int capacity;
+		unsigned int count;
+	};
+
+
+	/**
+	 * DeviceTable with its storage built in
+	 */
+	template <unsigned int N>
+	class StaticDeviceTable : public DeviceTable
+	{
+	public:
+		StaticDeviceTable()
+			: DeviceTable(entries, N)
+		{
+		}
+
+		StaticDeviceTable(const StaticDeviceTable& other)
+			: DeviceTable(entries, N)
+		{
+			Assign(other);
+		}
+
+		StaticDeviceTable& operator=(const DeviceTable& other)
+		{
+			Assign(other);
+			return *this;
+		}
+
+		StaticDeviceTable& operator=(const StaticDeviceTable& other)
+		{
+			Assign(other);
+			return *this;
+		}
+
+	private:
+		ROM entries[N];
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DEVICETABLE_H
@@ -0,0 +1,312 @@
+/**
+ * @file GPIOBus.h
+ *
+ * GPIOBus class template. Bit-bangs a OneWire bus on a single Stellaris GPIO
+ * pin, using SysCtlDelay for slot timing. The delay loop counts are worked out
+ * at compile time for the CPU clock given as the template parameter.
+ *
+ * Based off of Petras Saduikis' mbed port of Jim Studt's
+ * Arduino OneWire library. Some pieces of this code have been taken from
+ * Dallas Semiconductor's sample code, bearing the copyright below.
+ * Additionally, though I believe very little of Petras' code remains, I have
+ * included his copyright block just in case.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+* OneWireCRC. This is a port to mbed of Jim Studt's Adruino One Wire
+* library. Please see additional copyrights below this one, including
+* references to other copyrights.
+*
+* Copyright (C) <2009> Petras Saduikis <petras@petras.co.uk>
+*
+* This file is part of OneWireCRC.
+*
+* OneWireCRC is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* OneWireCRC is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with OneWireCRC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//---------------------------------------------------------------------------
+// Copyright (C) 2000 Dallas Semiconductor Corporation, All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY,  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL DALLAS SEMICONDUCTOR BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Dallas Semiconductor
+// shall not be used except as stated in the Dallas Semiconductor
+// Branding Policy.
+//--------------------------------------------------------------------------
+
+#ifndef STELLARIS_ONEWIRE_GPIOBUS_H
+#define STELLARIS_ONEWIRE_GPIOBUS_H
+
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "utils/ustdlib.h"
+
+#include "stellaris-pins/DigitalIOPin.h"
+
+#include "OneWireBus.h"
+#include "OneWireTiming.h"
+
+
+// CPU clock the GPIOBus timing tables are built for by default. This has to
+// match what SysCtlClockSet() configures, or every slot will be off by the
+// same ratio.
+#ifndef OW_CPU_CLOCK_HZ
+#define OW_CPU_CLOCK_HZ	50000000
+#endif // OW_CPU_CLOCK_HZ
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWire transport on a Stellaris GPIO pin
+	 *
+	 * ClockHz is the CPU clock in Hz. Both speed tables are compile-time
+	 * constants, SetSpeed() just picks which one the slots index into.
+	 *
+	 * Slots are timed by counted delays with no timer behind them, so NowNS()
+	 * stays 0 and bus statistics only count. Use DeadlineBus for times.
+	 */
+	template <unsigned long ClockHz = OW_CPU_CLOCK_HZ>
+	class GPIOBus : public OneWireBus
+	{
+	public:
+		GPIOBus(unsigned int busSpeed);
+		GPIOBus
+			( unsigned int busSpeed
+			, unsigned long gpioPeriph
+			, unsigned long gpioPort
+			, unsigned char gpioPinmask
+			);
+
+		// OneWireBus interface
+		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
+		void WaitUS(unsigned int us);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+	private:
+		// Delay loop table, selected by the bus speed setting
+		const unsigned long* timing;
+
+		// GPIO port
+		DigitalIOPin GPIOPin;
+
+		// Wait for one of the timing table entries
+		void Delay(int index) const;
+
+		typedef DelayTable<ClockHz, OW_SPEED_STANDARD> standardTime;
+		typedef DelayTable<ClockHz, OW_SPEED_OVERDRIVE> overdriveTime;
+
+	};
+
+
+	/**
+	 * GPIOBus constructor
+	 *
+	 * @param[in] busSpeed Bus speed timing table to use. 0 for overdrive, 1 for
+	 * standard speed
+	 * @param[in] gpioPeriph Peripherial address of the GPIO port from sysctl.h
+	 * @param[in] gpioPort GPIO port from hw_memmap.h
+	 * @param[in] gpioPinmask GPIO pin from gpio.h
+	 */
+	template <unsigned long ClockHz>
+	GPIOBus<ClockHz>::GPIOBus
+		( unsigned int busSpeed
+		, unsigned long gpioPeriph
+		, unsigned long gpioPort
+		, unsigned char gpioPinmask
+		)
+		: GPIOPin(gpioPeriph, gpioPort, gpioPinmask)
+	{
+		// Set the pin to a 4mA open-drain weak pull up, per 1-wire spec.
+		this->GPIOPin.PullMode(GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+
+		SetSpeed(busSpeed);
+	}
+
+	/**
+	 * Same as four argument constructor, except this will default to using pin
+	 * A7 as the OneWire bus.
+	 *
+	 * @param[in] busSpeed Bus speed timing table to use. 0 for overdrive, 1 for
+	 * standard speed.
+	 */
+	template <unsigned long ClockHz>
+	GPIOBus<ClockHz>::GPIOBus(unsigned int busSpeed)
+		:GPIOPin(SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE, GPIO_PIN_7)
+	{
+		// Set the pin to a 4mA open-drain weak pull up, per 1-wire spec.
+		this->GPIOPin.PullMode(GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+
+		SetSpeed(busSpeed);
+	}
+
+	/**
+	 * Select the timing table used for all following slots
+	 *
+	 * @param[in] busSpeed OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+	 */
+	template <unsigned long ClockHz>
+	void GPIOBus<ClockHz>::SetSpeed(unsigned int busSpeed)
+	{
+		if (busSpeed == OW_SPEED_OVERDRIVE)
+			timing = overdriveTime::value;
+		else
+			timing = standardTime::value;
+	}
+
+	/**
+	 * Current bus speed, OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+	 */
+	template <unsigned long ClockHz>
+	unsigned int GPIOBus<ClockHz>::GetSpeed(void) const
+	{
+		return timing == overdriveTime::value ? OW_SPEED_OVERDRIVE : OW_SPEED_STANDARD;
+	}
+
+	/**
+	 * Wait for one of the pre-computed timing table entries. SysCtlDelay(0)
+	 * would wrap around and wait for ages, so zero entries are skipped.
+	 */
+	template <unsigned long ClockHz>
+	inline void GPIOBus<ClockHz>::Delay(int index) const
+	{
+		if (timing[index]) SysCtlDelay(timing[index]);
+	}
+
+	/**
+	 * Wait for specified number of microeconds
+	 *
+	 * The clock is a compile-time constant, so this is a single multiply by a
+	 * constant. SysCtlDelay uses 3 cycles per loop.
+	 */
+	template <unsigned long ClockHz>
+	void GPIOBus<ClockHz>::WaitUS(unsigned int us)
+	{
+		if (us == 0) return;
+		SysCtlDelay(DelayLoops(us * 1000ULL, ClockHz));
+	}
+
+	/**
+	 * Reset the OneWire bus for new commands. Based off of example code from
+	 * Dallas Semiconductor.
+	 *
+	 * Sends out the RESET signal across the OneWire pin and waits for the response
+	 * presence detect.
+	 *
+	 * @param[out] presence Returns 1 if presence detect was present, 0 otherwise
+	 */
+	template <unsigned long ClockHz>
+	int GPIOBus<ClockHz>::Reset(void)
+	{
+		BYTE result = 0;
+
+		Delay(OW_TIME_G);
+		GPIOPin.Output();
+		GPIOPin.Write(0);	// Bring bus low for reset
+		Delay(OW_TIME_H);	// Wait for reset duration
+		GPIOPin.Input();	// Bring bus to input mode
+		Delay(OW_TIME_I);	// Wait for presence detect
+		result = GPIOPin.Read();
+		result = result == 0 ? 1 : 0;
+		Delay(OW_TIME_J);	// Finish out presence detect, ready for commands
+
+		return result;
+	}
+
+	/**
+	 * Write a bit to the line.
+	 */
+	template <unsigned long ClockHz>
+	void GPIOBus<ClockHz>::WriteBit(BYTE bit)
+	{
+		bit = bit & 0x01; // Make sure we don't have something silly here
+
+		if (bit)	// '1' bit
+		{
+			GPIOPin.Output();	// Make sure we're in output
+			GPIOPin.Write(0);	// Bring bus low for reset
+			Delay(OW_TIME_A);	// Wait for spec duration
+			GPIOPin.Input();	// Release for pullup
+			Delay(OW_TIME_B);	// Wait for recovery time
+		}
+		else	// '0' bit
+		{
+			GPIOPin.Output();	// Set to output
+			GPIOPin.Write(0);	// Pull line low
+			Delay(OW_TIME_C);	// Wait for spec duration
+			GPIOPin.Input();	// Release for pullup
+			Delay(OW_TIME_D);	// Wait for recovery time
+		}
+	}
+
+	/**
+	 * Read a bit from the line
+	 */
+	template <unsigned long ClockHz>
+	BYTE GPIOBus<ClockHz>::ReadBit(void)
+	{
+		BYTE result;
+
+		GPIOPin.Output();	// Set to output
+		GPIOPin.Write(0);	// Pull line low
+		Delay(OW_TIME_A);	// Wait for control
+		GPIOPin.Input();	// Release for pullup
+		Delay(OW_TIME_E);	// Wait for signal from slaves
+		result = GPIOPin.Read() & 0x01;	// Read the value on the line
+		Delay(OW_TIME_F);	// Wait for bus to finish operation
+
+		return result;
+	}
+
+}
+#endif // STELLARIS_ONEWIRE_GPIOBUS_H
@@ -0,0 +1,91 @@
+/**
+ * @file GPIODeadlineLine.cpp
+ *
+ * GPIODeadlineLine class methods, see GPIODeadlineLine.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GPIODeadlineLine.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * GPIODeadlineLine constructor
+	 *
+	 * @param[in] gpioPeriph Peripherial address of the GPIO port from sysctl.h
+	 * @param[in] gpioPort GPIO port from hw_memmap.h
+	 * @param[in] gpioPinmask GPIO pin from gpio.h
+	 * @param[in] timerPeriph Peripherial address of the timer from sysctl.h
+	 * @param[in] timerBase Timer base address from hw_memmap.h
+	 */
+	GPIODeadlineLine::GPIODeadlineLine
+		( unsigned long gpioPeriph
+		, unsigned long gpioPort
+		, unsigned char gpioPinmask
+		, unsigned long timerPeriph
+		, unsigned long timerBase
+		)
+		: GPIOPin(gpioPeriph, gpioPort, gpioPinmask)
+		, timerBase(timerBase)
+		, clockHz(SysCtlClockGet())
+	{
+		// Set the pin to a 4mA open-drain weak pull up, per 1-wire spec.
+		this->GPIOPin.PullMode(GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+
+		SysCtlPeripheralEnable(timerPeriph);
+		TimerConfigure(timerBase, TIMER_CFG_PERIODIC);
+		TimerLoadSet(timerBase, TIMER_A, 0xFFFFFFFF);
+		TimerEnable(timerBase, TIMER_A);
+	}
+
+	GPIODeadlineLine::~GPIODeadlineLine()
+	{
+		TimerDisable(timerBase, TIMER_A);
+	}
+
+	void GPIODeadlineLine::Low(void)
+	{
+		GPIOPin.Output();
+		GPIOPin.Write(0);
+	}
+
+	void GPIODeadlineLine::Release(void)
+	{
+		GPIOPin.Input();
+	}
+
+	BYTE GPIODeadlineLine::Sample(void)
+	{
+		return GPIOPin.Read() & 0x01;
+	}
+
+	unsigned long GPIODeadlineLine::Ticks(void)
+	{
+		return ~TimerValueGet(timerBase, TIMER_A);
+	}
+
+	unsigned long GPIODeadlineLine::TickHz(void) const
+	{
+		return clockHz;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,77 @@
+/**
+ * @file GPIODeadlineLine.h
+ *
+ * GPIODeadlineLine class prototype. DeadlineLine on a Stellaris GPIO pin,
+ * timed by a general purpose timer left free running at the CPU clock.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_GPIODEADLINELINE_H
+#define STELLARIS_ONEWIRE_GPIODEADLINELINE_H
+
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+
+#include "stellaris-pins/DigitalIOPin.h"
+
+#include "DeadlineBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * DeadlineLine on a Stellaris GPIO pin and general purpose timer
+	 *
+	 * Timer A runs as a 32 bit periodic timer counting down from 0xFFFFFFFF,
+	 * Ticks() inverts it to count up. At 50MHz it wraps every 85 seconds.
+	 * The clock rate is read once, in the constructor.
+	 */
+	class GPIODeadlineLine : public DeadlineLine
+	{
+	public:
+		GPIODeadlineLine
+			( unsigned long gpioPeriph
+			, unsigned long gpioPort
+			, unsigned char gpioPinmask
+			, unsigned long timerPeriph
+			, unsigned long timerBase
+			);
+		~GPIODeadlineLine();
+
+		// DeadlineLine interface
+		void Low(void);
+		void Release(void);
+		BYTE Sample(void);
+		unsigned long Ticks(void);
+		unsigned long TickHz(void) const;
+
+	private:
+		DigitalIOPin GPIOPin;
+		unsigned long timerBase;
+		unsigned long clockHz;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_GPIODEADLINELINE_H
@@ -0,0 +1,170 @@
+/**
+ * @file GPIOPort.h
+ *
+ * GPIOPort class template. A OneWirePort on several pins of one Stellaris GPIO
+ * port, each pin its own bus, with every edge a single port register write.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_GPIOPORT_H
+#define STELLARIS_ONEWIRE_GPIOPORT_H
+
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+
+#include "MultiBusMaster.h"
+#include "OneWireTiming.h"
+
+
+// CPU clock the timing tables are built for by default, see GPIOBus.h
+#ifndef OW_CPU_CLOCK_HZ
+#define OW_CPU_CLOCK_HZ	50000000
+#endif // OW_CPU_CLOCK_HZ
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWirePort on a Stellaris GPIO port
+	 *
+	 * The pins are open-drain outputs with weak pull ups, so writing 0 pulls a
+	 * lane low, writing 1 lets it go and reading the data register gives the
+	 * level on the pins. Lane n is pin n of the port, whichever pins are in
+	 * the mask given to the constructor.
+	 */
+	template <unsigned long ClockHz = OW_CPU_CLOCK_HZ>
+	class GPIOPort : public OneWirePort
+	{
+	public:
+		GPIOPort
+			( unsigned int busSpeed
+			, unsigned long gpioPeriph
+			, unsigned long gpioPort
+			, unsigned char gpioPinmask
+			);
+
+		// OneWirePort interface
+		BYTE Lanes(void) const;
+		void Low(BYTE mask);
+		void Release(BYTE mask);
+		BYTE Read(void);
+		void Delay(int index);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+	private:
+		unsigned long port;
+		unsigned char pins;
+
+		// Delay loop table, selected by the bus speed setting
+		const unsigned long* timing;
+
+		typedef DelayTable<ClockHz, OW_SPEED_STANDARD> standardTime;
+		typedef DelayTable<ClockHz, OW_SPEED_OVERDRIVE> overdriveTime;
+	};
+
+
+	/**
+	 * GPIOPort constructor
+	 *
+	 * @param[in] busSpeed Bus speed timing table to use. 0 for overdrive, 1 for
+	 * standard speed
+	 * @param[in] gpioPeriph Peripherial address of the GPIO port from sysctl.h
+	 * @param[in] gpioPort GPIO port from hw_memmap.h
+	 * @param[in] gpioPinmask GPIO pins from gpio.h, one bus on each
+	 */
+	template <unsigned long ClockHz>
+	GPIOPort<ClockHz>::GPIOPort
+		( unsigned int busSpeed
+		, unsigned long gpioPeriph
+		, unsigned long gpioPort
+		, unsigned char gpioPinmask
+		)
+		: port(gpioPort)
+		, pins(gpioPinmask)
+	{
+		SysCtlPeripheralEnable(gpioPeriph);
+
+		// Released until a slot pulls them low
+		GPIOPinWrite(port, pins, 0xFF);
+		GPIOPinTypeGPIOOutputOD(port, pins);
+
+		// Set the pins to a 4mA open-drain weak pull up, per 1-wire spec.
+		GPIOPadConfigSet(port, pins, GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+
+		SetSpeed(busSpeed);
+	}
+
+	template <unsigned long ClockHz>
+	BYTE GPIOPort<ClockHz>::Lanes(void) const
+	{
+		return pins;
+	}
+
+	template <unsigned long ClockHz>
+	void GPIOPort<ClockHz>::Low(BYTE mask)
+	{
+		GPIOPinWrite(port, mask & pins, 0x00);
+	}
+
+	template <unsigned long ClockHz>
+	void GPIOPort<ClockHz>::Release(BYTE mask)
+	{
+		GPIOPinWrite(port, mask & pins, 0xFF);
+	}
+
+	template <unsigned long ClockHz>
+	BYTE GPIOPort<ClockHz>::Read(void)
+	{
+		// Pins not in the port are reported high, as if nothing was there
+		return (BYTE)GPIOPinRead(port, pins) | (BYTE)~pins;
+	}
+
+	/**
+	 * Wait for one of the pre-computed timing table entries. SysCtlDelay(0)
+	 * would wrap around and wait for ages, so zero entries are skipped.
+	 */
+	template <unsigned long ClockHz>
+	void GPIOPort<ClockHz>::Delay(int index)
+	{
+		if (timing[index]) SysCtlDelay(timing[index]);
+	}
+
+	template <unsigned long ClockHz>
+	void GPIOPort<ClockHz>::SetSpeed(unsigned int busSpeed)
+	{
+		if (busSpeed == OW_SPEED_OVERDRIVE)
+			timing = overdriveTime::value;
+		else
+			timing = standardTime::value;
+	}
+
+	template <unsigned long ClockHz>
+	unsigned int GPIOPort<ClockHz>::GetSpeed(void) const
+	{
+		return timing == overdriveTime::value ? OW_SPEED_OVERDRIVE : OW_SPEED_STANDARD;
+	}
+
+}
+#endif // STELLARIS_ONEWIRE_GPIOPORT_H
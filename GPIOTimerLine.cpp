@@ -0,0 +1,119 @@
+/**
+ * @file GPIOTimerLine.cpp
+ *
+ * AsyncEngine line on a Stellaris GPIO pin and general purpose timer
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "GPIOTimerLine.h"
+
+
+namespace OneWire
+{
+
+	GPIOTimerLine* GPIOTimerLine::instance = 0;
+
+
+	/**
+	 * GPIOTimerLine constructor
+	 *
+	 * @param[in] gpioPeriph Peripherial address of the GPIO port from sysctl.h
+	 * @param[in] gpioPort GPIO port from hw_memmap.h
+	 * @param[in] gpioPinmask GPIO pin from gpio.h
+	 * @param[in] timerPeriph Peripherial address of the timer from sysctl.h
+	 * @param[in] timerBase Timer base address from hw_memmap.h
+	 */
+	GPIOTimerLine::GPIOTimerLine
+		( unsigned long gpioPeriph
+		, unsigned long gpioPort
+		, unsigned char gpioPinmask
+		, unsigned long timerPeriph
+		, unsigned long timerBase
+		)
+		: GPIOPin(gpioPeriph, gpioPort, gpioPinmask)
+		, timerBase(timerBase)
+		, cyclesPerUS(SysCtlClockGet() / 1000000)
+	{
+		instance = this;
+
+		// Set the pin to a 4mA open-drain weak pull up, per 1-wire spec.
+		this->GPIOPin.PullMode(GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+
+		SysCtlPeripheralEnable(timerPeriph);
+		TimerConfigure(timerBase, TIMER_CFG_ONE_SHOT);
+		TimerIntRegister(timerBase, TIMER_A, TimerHandler);
+		TimerIntEnable(timerBase, TIMER_TIMA_TIMEOUT);
+	}
+
+	GPIOTimerLine::~GPIOTimerLine()
+	{
+		TimerIntDisable(timerBase, TIMER_TIMA_TIMEOUT);
+		TimerDisable(timerBase, TIMER_A);
+		instance = 0;
+	}
+
+	void GPIOTimerLine::Low(void)
+	{
+		GPIOPin.Output();
+		GPIOPin.Write(0);
+	}
+
+	void GPIOTimerLine::Release(void)
+	{
+		GPIOPin.Input();
+	}
+
+	BYTE GPIOTimerLine::Sample(void)
+	{
+		return GPIOPin.Read() & 0x01;
+	}
+
+	/**
+	 * Arm the one-shot timer. Timeouts under a microsecond still get one
+	 * cycle, so the interrupt always fires.
+	 */
+	void GPIOTimerLine::Schedule(unsigned long ns)
+	{
+		unsigned long cycles = (ns * cyclesPerUS) / 1000;
+
+		TimerLoadSet(timerBase, TIMER_A, cycles ? cycles : 1);
+		TimerEnable(timerBase, TIMER_A);
+	}
+
+	void GPIOTimerLine::EnterCritical(void)
+	{
+		TimerIntDisable(timerBase, TIMER_TIMA_TIMEOUT);
+	}
+
+	void GPIOTimerLine::ExitCritical(void)
+	{
+		TimerIntEnable(timerBase, TIMER_TIMA_TIMEOUT);
+	}
+
+	void GPIOTimerLine::TimerHandler(void)
+	{
+		if (!instance) return;
+
+		TimerIntClear(instance->timerBase, TIMER_TIMA_TIMEOUT);
+		instance->Fire();
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,83 @@
+/**
+ * @file GPIOTimerLine.h
+ *
+ * GPIOTimerLine class prototype. Runs an AsyncEngine on a Stellaris GPIO pin,
+ * timed by a general purpose timer in one-shot mode.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_GPIOTIMERLINE_H
+#define STELLARIS_ONEWIRE_GPIOTIMERLINE_H
+
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+
+#include "stellaris-pins/DigitalIOPin.h"
+
+#include "AsyncEngine.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWireLine on a Stellaris GPIO pin and general purpose timer
+	 *
+	 * Only one GPIOTimerLine can exist at a time, as the interrupt handler has
+	 * no other way of finding it. Either register TimerHandler() in the startup
+	 * vector table for the timer, or let the constructor do it at runtime.
+	 */
+	class GPIOTimerLine : public OneWireLine
+	{
+	public:
+		GPIOTimerLine
+			( unsigned long gpioPeriph
+			, unsigned long gpioPort
+			, unsigned char gpioPinmask
+			, unsigned long timerPeriph
+			, unsigned long timerBase
+			);
+		~GPIOTimerLine();
+
+		// OneWireLine interface
+		void Low(void);
+		void Release(void);
+		BYTE Sample(void);
+		void Schedule(unsigned long ns);
+		void EnterCritical(void);
+		void ExitCritical(void);
+
+		// Timer A timeout interrupt handler
+		static void TimerHandler(void);
+
+	private:
+		DigitalIOPin GPIOPin;
+		unsigned long timerBase;
+		unsigned long cyclesPerUS;
+
+		static GPIOTimerLine* instance;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_GPIOTIMERLINE_H
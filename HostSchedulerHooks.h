@@ -0,0 +1,66 @@
+/**
+ * @file HostSchedulerHooks.h
+ *
+ * HostSchedulerHooks class. SchedulerHooks for a hosted C++11 system, using
+ * std::mutex and the steady clock.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_HOSTSCHEDULERHOOKS_H
+#define STELLARIS_ONEWIRE_HOSTSCHEDULERHOOKS_H
+
+
+#include "BusScheduler.h"
+
+#include <chrono>
+#include <mutex>
+
+
+namespace OneWire
+{
+
+	/**
+	 * SchedulerHooks on std::mutex, for sharing a bus between std::threads
+	 */
+	class HostSchedulerHooks : public SchedulerHooks
+	{
+	public:
+		void Lock(void)
+		{
+			mutex.lock();
+		}
+
+		void Unlock(void)
+		{
+			mutex.unlock();
+		}
+
+		unsigned long long NowUS(void)
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>
+				(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	private:
+		std::mutex mutex;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_HOSTSCHEDULERHOOKS_H
@@ -0,0 +1,63 @@
+/**
+ * @file I2CPort.h
+ *
+ * I2CPort interface. Messages to and from one I2C slave, for bridge chips
+ * such as the DS2482. Implemented on Linux i2c-dev by LinuxI2CPort, or on a
+ * Stellaris I2C master by the application.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_I2CPORT_H
+#define STELLARIS_ONEWIRE_I2CPORT_H
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * I2C slave
+	 *
+	 * Every call is one I2C transaction, start to stop, and returns false if
+	 * the slave didn't acknowledge.
+	 */
+	class I2CPort
+	{
+	public:
+		virtual ~I2CPort() {}
+
+		virtual bool Write(const BYTE* data, int len) = 0;
+		virtual bool Read(BYTE* data, int len) = 0;
+
+		// Write then read with a repeated start, one transaction where the
+		// port can do it
+		virtual bool WriteRead(const BYTE* data, int len, BYTE* response, int responseLen)
+		{
+			return Write(data, len) && Read(response, responseLen);
+		}
+
+		// Wait for a number of microseconds
+		virtual void DelayUS(unsigned int) {}
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_I2CPORT_H
@@ -0,0 +1,128 @@
+/**
+ * @file LinuxI2CPort.cpp
+ *
+ * LinuxI2CPort implementation
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LinuxI2CPort.h"
+
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+
+namespace OneWire
+{
+
+	LinuxI2CPort::LinuxI2CPort(void)
+		: fd(-1)
+		, address(0)
+	{
+	}
+
+	LinuxI2CPort::~LinuxI2CPort()
+	{
+		Close();
+	}
+
+	/**
+	 * Open an i2c-dev adapter
+	 *
+	 * @param[in] path Adapter device, such as /dev/i2c-1
+	 * @param[in] address 7 bit slave address, 0x18 for a DS2482 with its
+	 * address pins low
+	 */
+	bool LinuxI2CPort::Open(const char* path, BYTE address)
+	{
+		Close();
+
+		fd = open(path, O_RDWR);
+		if (fd < 0) return false;
+
+		if (ioctl(fd, I2C_SLAVE, (long)address) < 0)
+		{
+			Close();
+			return false;
+		}
+
+		this->address = address;
+		return true;
+	}
+
+	void LinuxI2CPort::Close(void)
+	{
+		if (fd >= 0) close(fd);
+		fd = -1;
+	}
+
+	bool LinuxI2CPort::IsOpen(void) const
+	{
+		return fd >= 0;
+	}
+
+	bool LinuxI2CPort::Write(const BYTE* data, int len)
+	{
+		return fd >= 0 && write(fd, data, len) == len;
+	}
+
+	bool LinuxI2CPort::Read(BYTE* data, int len)
+	{
+		return fd >= 0 && read(fd, data, len) == len;
+	}
+
+	/**
+	 * Both messages in one I2C_RDWR call, joined by a repeated start
+	 */
+	bool LinuxI2CPort::WriteRead(const BYTE* data, int len, BYTE* response, int responseLen)
+	{
+		struct i2c_msg messages[2];
+		struct i2c_rdwr_ioctl_data transfer;
+
+		if (fd < 0) return false;
+
+		messages[0].addr = address;
+		messages[0].flags = 0;
+		messages[0].len = len;
+		messages[0].buf = const_cast<BYTE*>(data);
+		messages[1].addr = address;
+		messages[1].flags = I2C_M_RD;
+		messages[1].len = responseLen;
+		messages[1].buf = response;
+
+		transfer.msgs = messages;
+		transfer.nmsgs = 2;
+
+		return ioctl(fd, I2C_RDWR, &transfer) == 2;
+	}
+
+	void LinuxI2CPort::DelayUS(unsigned int us)
+	{
+		struct timespec ts;
+
+		ts.tv_sec = us / 1000000;
+		ts.tv_nsec = (us % 1000000) * 1000L;
+		nanosleep(&ts, 0);
+	}
+
+} // Namespace OneWire
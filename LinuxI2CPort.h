@@ -0,0 +1,63 @@
+/**
+ * @file LinuxI2CPort.h
+ *
+ * LinuxI2CPort class prototype. I2CPort on a Linux i2c-dev adapter, such as
+ * /dev/i2c-1 on a gateway board.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_LINUXI2CPORT_H
+#define STELLARIS_ONEWIRE_LINUXI2CPORT_H
+
+
+#include "I2CPort.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * I2CPort on /dev/i2c-N
+	 */
+	class LinuxI2CPort : public I2CPort
+	{
+	public:
+		LinuxI2CPort(void);
+		~LinuxI2CPort();
+
+		// Open the adapter and address the slave, returns false if either
+		// fails
+		bool Open(const char* path, BYTE address);
+		void Close(void);
+		bool IsOpen(void) const;
+
+		// I2CPort interface
+		bool Write(const BYTE* data, int len);
+		bool Read(BYTE* data, int len);
+		bool WriteRead(const BYTE* data, int len, BYTE* response, int responseLen);
+		void DelayUS(unsigned int us);
+
+	private:
+		int fd;
+		BYTE address;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_LINUXI2CPORT_H
@@ -0,0 +1,545 @@
+/**
+ * @file MemoryDevice.cpp
+ *
+ * MemoryDevice and MemoryProgrammer classes. Handlers for the DS2431 and
+ * DS28EC20 EEPROMs.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MemoryDevice.h"
+#include "OneWireTiming.h"
+
+#include <string.h>
+
+
+namespace OneWire
+{
+
+	bool IsMemoryDevice(ROM rom)
+	{
+		return MemoryPageSize(FamilyCode(rom)) != 0;
+	}
+
+	/**
+	 * Size of the data memory, not counting the protection and control
+	 * registers above it
+	 */
+	unsigned int MemorySize(BYTE family)
+	{
+		switch (family)
+		{
+		case OW_FAMILY_DS2431:
+			return 128;
+		case OW_FAMILY_DS28EC20:
+			return 2560;
+		default:
+			return 0;
+		}
+	}
+
+	/**
+	 * Size of the scratchpad, which is also the unit memory is written in
+	 */
+	unsigned int MemoryPageSize(BYTE family)
+	{
+		switch (family)
+		{
+		case OW_FAMILY_DS2431:
+			return 8;
+		case OW_FAMILY_DS28EC20:
+			return 32;
+		default:
+			return 0;
+		}
+	}
+
+	/**
+	 * Contents of the page at base after a write of len bytes of data at
+	 * address. A page the write covers is used straight out of data, one
+	 * it only partly covers is read from the device into page and the data
+	 * laid over it.
+	 *
+	 * @return The page contents, or 0 if the page had to be read and
+	 * couldn't be
+	 */
+	static const BYTE* PageImage
+		( MemoryDevice& device
+		, unsigned int base
+		, unsigned int address
+		, const BYTE* data
+		, unsigned int len
+		, BYTE* page
+		)
+	{
+		unsigned int pageSize = device.PageSize();
+		unsigned int from = address > base ? address : base;
+		unsigned int to = address + len < base + pageSize ? address + len : base + pageSize;
+
+		if (from == base && to == base + pageSize) return data + (base - address);
+
+		if (!device.Read(base, page, pageSize)) return 0;
+		memcpy(page + (from - base), data + (from - address), to - from);
+
+		return page;
+	}
+
+
+	/**
+	 * MemoryDevice constructor
+	 *
+	 * @param[in] master Master the device is reached through
+	 * @param[in] rom ROM ID of the device, the family code gives the size
+	 */
+	MemoryDevice::MemoryDevice(OneWireMaster& master, ROM rom)
+		: OneWireDevice(master, rom)
+		, size(MemorySize(FamilyCode(rom)))
+		, pageSize(MemoryPageSize(FamilyCode(rom)))
+	{
+	}
+
+	unsigned int MemoryDevice::Size(void) const
+	{
+		return size;
+	}
+
+	unsigned int MemoryDevice::PageSize(void) const
+	{
+		return pageSize;
+	}
+
+	/**
+	 * Read Memory into a buffer. The bytes go from the bus straight into
+	 * buffer. Read Memory has no CRC, so check the data some other way if it
+	 * matters.
+	 *
+	 * @param[in] address Where to start
+	 * @param[out] buffer len bytes
+	 * @param[in] len Number of bytes
+	 * @return false if the range is out of the memory or nobody answered
+	 */
+	bool MemoryDevice::Read(unsigned int address, BYTE* buffer, unsigned int len)
+	{
+		BYTE ta[2] = {(BYTE)(address & 0xFF), (BYTE)(address >> 8)};
+		Transaction t;
+
+		if (address + len > size) return false;
+
+		t.Match(rom).Command(OW_MEMORY_READ_MEMORY).Write(ta, 2).Read(buffer, len);
+
+		return master.Execute(t) == TRANSACTION_OK;
+	}
+
+	/**
+	 * Read Memory through a callback. The device keeps streaming for as long
+	 * as read slots come, so the whole range is one Read Memory however long
+	 * it is, passed on OW_MEMORY_CHUNK bytes at a time.
+	 *
+	 * @param[in] address Where to start
+	 * @param[in] len Number of bytes
+	 * @param[in] reader Called with every chunk, see MemoryReader
+	 * @param[in] context Passed on to reader
+	 * @return false if the range is out of the memory or nobody answered
+	 */
+	bool MemoryDevice::Read
+		( unsigned int address
+		, unsigned int len
+		, MemoryReader reader
+		, void* context
+		)
+	{
+		BYTE ta[2] = {(BYTE)(address & 0xFF), (BYTE)(address >> 8)};
+		BYTE chunk[OW_MEMORY_CHUNK];
+		Transaction start;
+		Transaction more;
+
+		if (address + len > size) return false;
+
+		start.Match(rom).Command(OW_MEMORY_READ_MEMORY).Write(ta, 2);
+		if (master.Execute(start) != TRANSACTION_OK) return false;
+
+		more.NoReset();
+		while (len)
+		{
+			unsigned int n = len < OW_MEMORY_CHUNK ? len : OW_MEMORY_CHUNK;
+
+			master.Execute(more.Read(chunk, n));
+			if (!reader(address, chunk, n, context)) break;
+
+			address += n;
+			len -= n;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Write a range, page by page. Every page is verified before it is
+	 * copied, and the copy is waited out.
+	 *
+	 * @param[in] address Where to start, needn't be page aligned
+	 * @param[in] data len bytes
+	 * @param[in] len Number of bytes
+	 * @return false if the range is out of the memory or a page failed
+	 */
+	bool MemoryDevice::Write(unsigned int address, const BYTE* data, unsigned int len)
+	{
+		BYTE buffer[OW_MEMORY_PAGE_MAX];
+
+		if (!pageSize || address + len > size) return false;
+
+		for (unsigned int base = address - address % pageSize; base < address + len; base += pageSize)
+		{
+			const BYTE* page = PageImage(*this, base, address, data, len, buffer);
+
+			if (!page) return false;
+			if (!WriteScratchpad(base, page)) return false;
+			if (!VerifyScratchpad(base, page)) return false;
+			if (!CopyScratchpad(base)) return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Fill the scratchpad with a page. The write runs to the end of the
+	 * scratchpad, so the device answers with the CRC16 of what it got.
+	 *
+	 * @param[in] address Page aligned address the page is for
+	 * @param[in] page PageSize() bytes
+	 * @return false if nobody answered or the CRC is wrong
+	 */
+	bool MemoryDevice::WriteScratchpad(unsigned int address, const BYTE* page)
+	{
+		BYTE buffer[2 + OW_MEMORY_PAGE_MAX];
+		BYTE crc[2];
+		Transaction t;
+
+		if (!pageSize) return false;
+
+		buffer[0] = address & 0xFF;
+		buffer[1] = address >> 8;
+		memcpy(buffer + 2, page, pageSize);
+
+		t.Match(rom).Command(OW_MEMORY_WRITE_SCRATCHPAD).Write(buffer, 2 + pageSize).Read(crc, 2).CheckCRC16();
+
+		return master.Execute(t) == TRANSACTION_OK;
+	}
+
+	/**
+	 * Read the scratchpad back and compare it with the page. The target
+	 * address and the E/S register have to show a whole page, which is
+	 * what Copy Scratchpad will ask for.
+	 *
+	 * @param[in] address Page aligned address the page is for
+	 * @param[in] page PageSize() bytes
+	 * @return false if nobody answered, the CRC is wrong or the scratchpad
+	 * doesn't hold the page
+	 */
+	bool MemoryDevice::VerifyScratchpad(unsigned int address, const BYTE* page)
+	{
+		BYTE buffer[3 + OW_MEMORY_PAGE_MAX + 2];
+		Transaction t;
+
+		if (!pageSize) return false;
+
+		t.Match(rom).Command(OW_MEMORY_READ_SCRATCHPAD).Read(buffer, 3 + pageSize + 2).CheckCRC16();
+		if (master.Execute(t) != TRANSACTION_OK) return false;
+
+		if (buffer[0] != (address & 0xFF) || buffer[1] != (address >> 8)) return false;
+		if (buffer[2] != pageSize - 1) return false;
+
+		return memcmp(buffer + 3, page, pageSize) == 0;
+	}
+
+	/**
+	 * Copy the scratchpad into memory. The device takes OW_MEMORY_PROGRAM_US
+	 * to program the page, then reads OW_MEMORY_COPY_DONE.
+	 *
+	 * @param[in] address Page aligned address, as written
+	 * @param[in] wait Wait for the copy and check it, rather than returning
+	 * as soon as it has started
+	 * @return false if nobody answered, or the copy didn't report success
+	 */
+	bool MemoryDevice::CopyScratchpad(unsigned int address, bool wait)
+	{
+		BYTE auth[3] = {(BYTE)(address & 0xFF), (BYTE)(address >> 8), (BYTE)(pageSize - 1)};
+		Transaction t;
+
+		t.Match(rom).Command(OW_MEMORY_COPY_SCRATCHPAD).Write(auth, 3);
+		if (master.Execute(t) != TRANSACTION_OK) return false;
+
+		if (!wait) return true;
+
+		master.WaitUS(OW_MEMORY_PROGRAM_US);
+		return master.ReadByte() == OW_MEMORY_COPY_DONE;
+	}
+
+
+	/**
+	 * Compares a streamed read against the image, see MemoryProgrammer::Visit()
+	 */
+	struct ImageCheck
+	{
+		unsigned int address;
+		const BYTE* data;
+		unsigned int read;
+		unsigned int bad;
+		bool match;
+	};
+
+	static bool CheckImage(unsigned int address, const BYTE* data, unsigned int len, void* context)
+	{
+		ImageCheck& check = *(ImageCheck*)context;
+		const BYTE* expect = check.data + (address - check.address);
+
+		check.read += len;
+
+		for (unsigned int i = 0; i < len; ++i)
+		{
+			if (data[i] != expect[i])
+			{
+				check.bad = address + i;
+				check.match = false;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * MemoryProgrammer constructor
+	 *
+	 * @param[in] master Master the devices are reached through
+	 */
+	MemoryProgrammer::MemoryProgrammer(OneWireMaster& master)
+		: overlap(false)
+		, pageCount(0)
+		, retryCount(0)
+		, waitNS(0)
+		, master(master)
+		, count(0)
+		, clockNS(0)
+	{
+	}
+
+	/**
+	 * Queue an image
+	 *
+	 * @param[in] rom Device to write, a DS2431 or DS28EC20
+	 * @param[in] address Where the image goes, needn't be page aligned
+	 * @param[in] data Image, must stay valid until Run() is done
+	 * @param[in] len Image size in bytes
+	 * @return false if the device isn't an EEPROM, the image doesn't fit or
+	 * the programmer is full
+	 */
+	bool MemoryProgrammer::Add(ROM rom, unsigned int address, const BYTE* data, unsigned int len)
+	{
+		BYTE family = FamilyCode(rom);
+
+		if (count >= OW_MAX_MEMORY_DEVICES) return false;
+		if (!MemoryPageSize(family) || !len || address + len > MemorySize(family)) return false;
+
+		this->rom[count] = rom;
+		this->address[count] = address;
+		this->data[count] = data;
+		this->length[count] = len;
+		done[count] = false;
+		++count;
+
+		return true;
+	}
+
+	unsigned int MemoryProgrammer::Count(void) const
+	{
+		return count;
+	}
+
+	void MemoryProgrammer::Clear(void)
+	{
+		count = 0;
+	}
+
+	/**
+	 * Write every queued image, round robin, until each device is either
+	 * done or has used up its OW_MEMORY_RETRIES
+	 *
+	 * @return Number of devices written and verified, see done[]
+	 */
+	int MemoryProgrammer::Run(void)
+	{
+		int written = 0;
+		bool busy = true;
+
+		clockNS = 0;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			state[i] = JOB_WRITE;
+			next[i] = address[i] - address[i] % MemoryPageSize(FamilyCode(rom[i]));
+			failures[i] = 0;
+			readyNS[i] = 0;
+			done[i] = false;
+		}
+
+		while (busy)
+		{
+			busy = false;
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				if (state[i] != JOB_WRITE && state[i] != JOB_CHECK) continue;
+
+				Visit(i);
+				busy = true;
+			}
+		}
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			done[i] = state[i] == JOB_DONE;
+			if (done[i]) ++written;
+		}
+
+		return written;
+	}
+
+	/**
+	 * Write the next page of device index, or read its image back once they
+	 * are all written. A failure costs one of the device's retries and is
+	 * tried again on the next round.
+	 */
+	void MemoryProgrammer::Visit(unsigned int index)
+	{
+		MemoryDevice device(master, rom[index]);
+		unsigned int pageSize = device.PageSize();
+		BYTE buffer[OW_MEMORY_PAGE_MAX];
+		const BYTE* page;
+		bool ok;
+
+		WaitReady(index);
+
+		if (state[index] == JOB_CHECK)
+		{
+			ImageCheck check = {address[index], data[index], 0, 0, true};
+
+			ok = device.Read(address[index], length[index], CheckImage, &check);
+			if (ok) Elapse(12 + check.read);
+
+			if (ok && check.match)
+			{
+				state[index] = JOB_DONE;
+				return;
+			}
+
+			// Write again from the first page that didn't take
+			if (ok)
+			{
+				next[index] = check.bad - check.bad % pageSize;
+				state[index] = JOB_WRITE;
+			}
+		}
+		else
+		{
+			page = PageImage(device, next[index], address[index], data[index], length[index], buffer);
+			if (page == buffer) Elapse(12 + pageSize);
+
+			ok = page && device.WriteScratchpad(next[index], page);
+			if (ok)
+			{
+				Elapse(14 + pageSize);
+				ok = device.VerifyScratchpad(next[index], page);
+			}
+			if (ok)
+			{
+				Elapse(15 + pageSize);
+				ok = device.CopyScratchpad(next[index], !overlap);
+			}
+
+			if (ok)
+			{
+				++pageCount;
+				next[index] += pageSize;
+
+				if (overlap)
+				{
+					Elapse(13);
+					readyNS[index] = clockNS + OW_MEMORY_PROGRAM_US * 1000ULL;
+				}
+				else
+				{
+					// Waited out by the copy
+					Elapse(14);
+					clockNS += OW_MEMORY_PROGRAM_US * 1000ULL;
+					waitNS += OW_MEMORY_PROGRAM_US * 1000ULL;
+				}
+
+				if (next[index] >= address[index] + length[index])
+					state[index] = overlap ? JOB_CHECK : JOB_DONE;
+				return;
+			}
+		}
+
+		if (++failures[index] > OW_MEMORY_RETRIES)
+		{
+			state[index] = JOB_FAILED;
+			return;
+		}
+
+		++retryCount;
+	}
+
+	/**
+	 * Wait out whatever is left of the programming time of device index
+	 */
+	void MemoryProgrammer::WaitReady(unsigned int index)
+	{
+		unsigned long long left;
+		unsigned int us;
+
+		if (readyNS[index] <= clockNS) return;
+
+		left = readyNS[index] - clockNS;
+		us = (unsigned int)((left + 999) / 1000);
+
+		master.WaitUS(us);
+		clockNS += us * 1000ULL;
+		waitNS += us * 1000ULL;
+	}
+
+	/**
+	 * Move the clock on by a reset and bytes bytes. Slots are counted at
+	 * the shortest a slot can nominally be, so the clock never runs ahead
+	 * of the bus.
+	 */
+	void MemoryProgrammer::Elapse(unsigned int bytes)
+	{
+		const unsigned long* timing = TimingNS(master.GetSpeed());
+		unsigned long slot = timing[OW_TIME_A] + timing[OW_TIME_B];
+
+		if (timing[OW_TIME_C] + timing[OW_TIME_D] < slot)
+			slot = timing[OW_TIME_C] + timing[OW_TIME_D];
+		if (timing[OW_TIME_A] + timing[OW_TIME_E] + timing[OW_TIME_F] < slot)
+			slot = timing[OW_TIME_A] + timing[OW_TIME_E] + timing[OW_TIME_F];
+
+		clockNS += timing[OW_TIME_G] + timing[OW_TIME_H] + timing[OW_TIME_I] + timing[OW_TIME_J];
+		clockNS += bytes * 8ULL * slot;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,219 @@
+/**
+ * @file MemoryDevice.h
+ *
+ * MemoryDevice and MemoryProgrammer class prototypes. Handlers for the
+ * DS2431 and DS28EC20 EEPROMs: streaming reads, verified page writes, and
+ * bulk programming of a whole bus of them.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_MEMORYDEVICE_H
+#define STELLARIS_ONEWIRE_MEMORYDEVICE_H
+
+
+#include "OneWireDevice.h"
+
+
+// Family codes
+#define OW_FAMILY_DS2431	0x2D
+#define OW_FAMILY_DS28EC20	0x43
+
+// Memory function commands
+#define OW_MEMORY_WRITE_SCRATCHPAD	0x0F
+#define OW_MEMORY_READ_SCRATCHPAD	0xAA
+#define OW_MEMORY_COPY_SCRATCHPAD	0x55
+#define OW_MEMORY_READ_MEMORY		0xF0
+
+// Pattern read after a successful Copy Scratchpad
+#define OW_MEMORY_COPY_DONE		0xAA
+
+// Authorization accepted and partial byte flags of the E/S register
+#define OW_MEMORY_ES_AA			0x80
+#define OW_MEMORY_ES_PF			0x20
+
+// Largest scratchpad of the supported parts, the DS28EC20's
+#define OW_MEMORY_PAGE_MAX		32
+
+// Programming time after a Copy Scratchpad, tPROG
+#ifndef OW_MEMORY_PROGRAM_US
+#define OW_MEMORY_PROGRAM_US	10000
+#endif // OW_MEMORY_PROGRAM_US
+
+// Buffer the callback form of MemoryDevice::Read() streams through
+#ifndef OW_MEMORY_CHUNK
+#define OW_MEMORY_CHUNK			32
+#endif // OW_MEMORY_CHUNK
+
+// Failed pages and read backs MemoryProgrammer repeats for a device before
+// giving up on it
+#ifndef OW_MEMORY_RETRIES
+#define OW_MEMORY_RETRIES		3
+#endif // OW_MEMORY_RETRIES
+
+// Number of devices a MemoryProgrammer can hold
+#ifndef OW_MAX_MEMORY_DEVICES
+#define OW_MAX_MEMORY_DEVICES	OW_MAX_NUM_DEVICES
+#endif // OW_MAX_MEMORY_DEVICES
+
+
+namespace OneWire
+{
+
+	// Whether a ROM belongs to one of the supported EEPROMs
+	bool IsMemoryDevice(ROM rom);
+
+	// Size of the data memory and of the scratchpad, 0 for other families
+	unsigned int MemorySize(BYTE family);
+	unsigned int MemoryPageSize(BYTE family);
+
+	/**
+	 * Called with every chunk of a streamed read, address being where data
+	 * starts in the device's memory. Return false to stop the read early.
+	 */
+	typedef bool (*MemoryReader)
+		( unsigned int address
+		, const BYTE* data
+		, unsigned int len
+		, void* context
+		);
+
+
+	/**
+	 * A single DS2431 or DS28EC20
+	 *
+	 * Memory is written a page at a time through the scratchpad: Write
+	 * Scratchpad, Read Scratchpad to check it, then Copy Scratchpad, after
+	 * which the device is busy programming for OW_MEMORY_PROGRAM_US. Both
+	 * scratchpad transfers are checked with the device's CRC16. Writes that
+	 * don't cover whole pages read the rest of the page first.
+	 */
+	class MemoryDevice : public OneWireDevice
+	{
+	public:
+		MemoryDevice(OneWireMaster& master, ROM rom);
+
+		// Geometry, in bytes
+		unsigned int Size(void) const;
+		unsigned int PageSize(void) const;
+
+		// Read Memory straight into buffer
+		bool Read(unsigned int address, BYTE* buffer, unsigned int len);
+
+		// Same, handing the data to reader OW_MEMORY_CHUNK bytes at a time
+		bool Read
+			( unsigned int address
+			, unsigned int len
+			, MemoryReader reader
+			, void* context
+			);
+
+		// Write and verify any range, waiting out every page
+		bool Write(unsigned int address, const BYTE* data, unsigned int len);
+
+		// The steps of a page write, address being page aligned. Without
+		// wait, CopyScratchpad() returns as soon as programming starts.
+		bool WriteScratchpad(unsigned int address, const BYTE* page);
+		bool VerifyScratchpad(unsigned int address, const BYTE* page);
+		bool CopyScratchpad(unsigned int address, bool wait = true);
+
+	private:
+		unsigned int size;
+		unsigned int pageSize;
+	};
+
+
+	/**
+	 * Bulk programming of many EEPROMs
+	 *
+	 * Every device gets its own image, and the pages are sent round robin:
+	 * one page to each device in turn. With overlap set, a device programs
+	 * while the others are being written, and is only waited for if the
+	 * round comes back to it before its OW_MEMORY_PROGRAM_US is up. Copies
+	 * are then checked by reading every image back at the end.
+	 *
+	 * overlap is off by default. The datasheets ask for the line to stay
+	 * high while programming, which parasite powered parts on a plain
+	 * pullup can't count on with other traffic going on. Turn it on where
+	 * the pullup keeps the devices fed, or where they sit on separate
+	 * segments.
+	 *
+	 * Time is kept from the nominal length of the slots sent, which real
+	 * slots can only exceed, so no transport clock is needed.
+	 */
+	class MemoryProgrammer
+	{
+	public:
+		MemoryProgrammer(OneWireMaster& master);
+
+		// Queue an image for a device, data is used in place
+		bool Add(ROM rom, unsigned int address, const BYTE* data, unsigned int len);
+		unsigned int Count(void) const;
+		void Clear(void);
+
+		// Program everything, returns the number of devices fully written
+		int Run(void);
+
+		// Overlap programming with traffic to other devices
+		bool overlap;
+
+		// Results, entry i being device i
+		ROM rom[OW_MAX_MEMORY_DEVICES];
+		bool done[OW_MAX_MEMORY_DEVICES];
+
+		// Pages written, pages repeated, and time spent waiting on programming
+		unsigned long pageCount;
+		unsigned long retryCount;
+		unsigned long long waitNS;
+
+	private:
+		enum JobState
+		{
+			JOB_WRITE,		// Pages left to write
+			JOB_CHECK,		// Written, to be read back
+			JOB_DONE,
+			JOB_FAILED
+		};
+
+		// One visit to device index, a page or the final read back
+		void Visit(unsigned int index);
+
+		// Wait until device index has finished programming
+		void WaitReady(unsigned int index);
+
+		// Count bytes sent in a transaction into the nominal clock
+		void Elapse(unsigned int bytes);
+
+		OneWireMaster& master;
+		unsigned int count;
+
+		JobState state[OW_MAX_MEMORY_DEVICES];
+		unsigned int address[OW_MAX_MEMORY_DEVICES];
+		const BYTE* data[OW_MAX_MEMORY_DEVICES];
+		unsigned int length[OW_MAX_MEMORY_DEVICES];
+		unsigned int next[OW_MAX_MEMORY_DEVICES];
+		unsigned int failures[OW_MAX_MEMORY_DEVICES];
+		unsigned long long readyNS[OW_MAX_MEMORY_DEVICES];
+
+		// Nominal bus time since Run() started
+		unsigned long long clockNS;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_MEMORYDEVICE_H
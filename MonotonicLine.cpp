@@ -0,0 +1,84 @@
+/**
+ * @file MonotonicLine.cpp
+ *
+ * MonotonicLine class methods, see MonotonicLine.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MonotonicLine.h"
+
+#include <time.h>
+
+
+namespace OneWire
+{
+
+	MonotonicLine::MonotonicLine(SimulatedBus& bus)
+		: bus(bus)
+		, synced(0)
+	{
+		synced = Ticks();
+	}
+
+	unsigned long MonotonicLine::Ticks(void)
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+	}
+
+	unsigned long MonotonicLine::TickHz(void) const
+	{
+		return 1000000000UL;
+	}
+
+	void MonotonicLine::Sync(void)
+	{
+		unsigned long now = Ticks();
+
+		bus.Advance(now - synced);
+		synced = now;
+	}
+
+	void MonotonicLine::Low(void)
+	{
+		Sync();
+		bus.LineLow();
+	}
+
+	void MonotonicLine::Release(void)
+	{
+		Sync();
+		bus.LineRelease();
+	}
+
+	BYTE MonotonicLine::Sample(void)
+	{
+		Sync();
+		return bus.LineLevel();
+	}
+
+	void MonotonicLine::SetSpeed(unsigned int busSpeed)
+	{
+		bus.SetSpeed(busSpeed);
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,67 @@
+/**
+ * @file MonotonicLine.h
+ *
+ * MonotonicLine class prototype. A DeadlineLine for the Linux backend, timed
+ * by the monotonic clock and driving a SimulatedBus in real time, so the
+ * deadline scheduling can be tried out against host timing jitter.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_MONOTONICLINE_H
+#define STELLARIS_ONEWIRE_MONOTONICLINE_H
+
+
+#include "DeadlineBus.h"
+#include "SimulatedBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * DeadlineLine on CLOCK_MONOTONIC and a SimulatedBus edge level line
+	 *
+	 * Ticks are nanoseconds. Before every line operation the simulated bus
+	 * clock is moved on by the real time since the last one, so the devices
+	 * see the slots with whatever timing the host actually managed.
+	 */
+	class MonotonicLine : public DeadlineLine
+	{
+	public:
+		MonotonicLine(SimulatedBus& bus);
+
+		// DeadlineLine interface
+		void Low(void);
+		void Release(void);
+		BYTE Sample(void);
+		unsigned long Ticks(void);
+		unsigned long TickHz(void) const;
+		void SetSpeed(unsigned int busSpeed);
+
+	private:
+		// Catch the simulated bus up with real time
+		void Sync(void);
+
+		SimulatedBus& bus;
+		unsigned long synced;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_MONOTONICLINE_H
@@ -0,0 +1,338 @@
+/**
+ * @file MultiBusMaster.cpp
+ *
+ * Lockstep OneWire master for several buses on one GPIO port
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "MultiBusMaster.h"
+#include "OneWireMaster.h"
+#include "OneWireTiming.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * MultiBusMaster constructor
+	 *
+	 * @param[in] port Port the buses are connected to
+	 */
+	MultiBusMaster::MultiBusMaster(OneWirePort& port)
+		: port(port)
+		, active(port.Lanes())
+		, complete(0)
+	{
+	}
+
+	/**
+	 * Select the lanes following operations run on
+	 *
+	 * @param[in] mask Lane mask, limited to the lanes the port has
+	 */
+	void MultiBusMaster::SetActive(BYTE mask)
+	{
+		active = mask & port.Lanes();
+	}
+
+	BYTE MultiBusMaster::GetActive(void) const
+	{
+		return active;
+	}
+
+	/**
+	 * Reset every active lane
+	 *
+	 * @return Mask of the lanes that answered with a presence pulse
+	 */
+	BYTE MultiBusMaster::Reset(void)
+	{
+		BYTE level;
+
+		port.Delay(OW_TIME_G);
+		port.Low(active);
+		port.Delay(OW_TIME_H);
+		port.Release(active);
+		port.Delay(OW_TIME_I);
+		level = port.Read();
+		port.Delay(OW_TIME_J);
+
+		return ~level & active;
+	}
+
+	/**
+	 * One time slot on every active lane
+	 *
+	 * All lanes go low together. Lanes writing 1 are let go after the write 1
+	 * low time and sampled, lanes writing 0 are held to the end of the read
+	 * slot, which is still inside the write 0 low time window, then all of
+	 * them recover together.
+	 *
+	 * @param[in] bits Bit n is written to lane n
+	 * @return Level sampled on each lane
+	 */
+	BYTE MultiBusMaster::TouchBits(BYTE bits)
+	{
+		BYTE level;
+
+		bits &= active;
+
+		port.Low(active);
+		port.Delay(OW_TIME_A);
+		port.Release(bits);
+		port.Delay(OW_TIME_E);
+		level = port.Read();
+		port.Delay(OW_TIME_F);
+		port.Release(active);
+		port.Delay(OW_TIME_D);
+
+		return level & active;
+	}
+
+	/**
+	 * Write the same byte to every active lane
+	 */
+	void MultiBusMaster::WriteByte(BYTE data)
+	{
+		for (int bit = 0; bit < 8; ++bit)
+		{
+			TouchBits((data >> bit) & 0x01 ? 0xFF : 0x00);
+		}
+	}
+
+	/**
+	 * Touch a block of bytes on every lane, each lane with its own data
+	 *
+	 * @param[in,out] data data[n] is the buffer for lane n, or 0
+	 * @param[in] len Number of bytes in every buffer
+	 */
+	void MultiBusMaster::Block(BYTE* const* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE in[OW_PORT_LANES] = {0};
+
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				BYTE out = 0;
+
+				// Gather bit 'bit' of every lane's byte into one port value
+				for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+				{
+					BYTE b = data[lane] ? data[lane][i] : 0xFF;
+					out |= ((b >> bit) & 0x01) << lane;
+				}
+
+				BYTE level = TouchBits(out);
+
+				for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+				{
+					in[lane] |= ((level >> lane) & 0x01) << bit;
+				}
+			}
+
+			for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+			{
+				if (data[lane]) data[lane][i] = in[lane];
+			}
+		}
+	}
+
+	void MultiBusMaster::SkipROM(void)
+	{
+		WriteByte(OW_SKIP_ROM);
+	}
+
+	/**
+	 * Search every active lane in parallel
+	 *
+	 * Each lane follows its own path through its own ROM tree. Lanes drop out
+	 * as they finish, the others carry on without them.
+	 *
+	 * @param[out] tables tables[n] receives the devices on lane n, or is 0 to
+	 * leave the lane out
+	 * @return Total number of devices found
+	 */
+	int MultiBusMaster::Search(DeviceTable* const* tables)
+	{
+		SearchState states[OW_PORT_LANES];
+		SearchResult results[OW_PORT_LANES];
+		int retries[OW_PORT_LANES] = {0};
+		BYTE saved = active;
+		BYTE searching = 0;
+		BYTE seen = 0;
+		int total = 0;
+
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (!tables[lane] || !(saved & (1 << lane))) continue;
+
+			tables[lane]->Clear();
+			states[lane].Begin();
+			searching |= 1 << lane;
+		}
+
+		complete = 0;
+
+		while (searching)
+		{
+			// Lanes that found their last device on the previous pass are done
+			for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+			{
+				if (!(searching & (1 << lane)) || !states[lane].lastDevice) continue;
+
+				complete |= 1 << lane;
+				searching &= ~(1 << lane);
+			}
+			if (!searching) break;
+
+			BYTE presence = SearchPass(states, searching, results);
+
+			for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+			{
+				BYTE bit = 1 << lane;
+				if (!(searching & bit)) continue;
+
+				if (presence & bit) seen |= bit;
+
+				if (results[lane] == SEARCH_ERROR)
+				{
+					if (++retries[lane] <= OW_SEARCH_RETRIES) continue;
+
+					// Nobody answered a single reset, there is nothing on the
+					// lane
+					if (!(seen & bit)) complete |= bit;
+					searching &= ~bit;
+					continue;
+				}
+
+				retries[lane] = 0;
+
+				if (results[lane] == SEARCH_DONE)
+				{
+					complete |= bit;
+					searching &= ~bit;
+					continue;
+				}
+
+				// A full table means the bus is misbehaving, or is just too big
+				if (!tables[lane]->Insert(states[lane].rom))
+				{
+					searching &= ~bit;
+					continue;
+				}
+
+				++total;
+			}
+		}
+
+		active = saved;
+		return total;
+	}
+
+	BYTE MultiBusMaster::SearchComplete(void) const
+	{
+		return complete;
+	}
+
+	/**
+	 * One search pass on several lanes, the lockstep version of
+	 * OneWireBus::SearchPass()
+	 *
+	 * @param[in,out] states Search state of every lane
+	 * @param[in] mask Lanes to run the pass on
+	 * @param[out] results Outcome of the pass on every lane in mask
+	 * @return Lanes that answered the reset
+	 */
+	BYTE MultiBusMaster::SearchPass
+		( SearchState* states
+		, BYTE mask
+		, SearchResult* results
+		)
+	{
+		ROM preferred[OW_PORT_LANES];
+		ROM taken[OW_PORT_LANES] = {0};
+		ROM discrepancies[OW_PORT_LANES] = {0};
+		ROM errors[OW_PORT_LANES] = {0};
+		BYTE presence;
+
+		active = mask;
+		presence = Reset();
+
+		// Lanes without a presence pulse sit the pass out
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			results[lane] = SEARCH_ERROR;
+			if (mask & (1 << lane)) preferred[lane] = states[lane].Preferred();
+		}
+
+		active = presence;
+		if (!active) return presence;
+
+		WriteByte(OW_SEARCH_ROM);
+
+		for (int bit = 0; bit < 64; ++bit)
+		{
+			ROM m = (ROM)1 << bit;
+			BYTE id = TouchBits(0xFF);
+			BYTE comp = TouchBits(0xFF);
+			BYTE direction = 0;
+
+			for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+			{
+				BYTE l = 1 << lane;
+				if (!(active & l)) continue;
+
+				bool i = id & l;
+				bool c = comp & l;
+				bool d = i;
+
+				// Same as OneWireBus::Triplet(), both or neither answering
+				// means the preferred direction
+				if (i == c)
+				{
+					if (i) errors[lane] |= m;
+					else discrepancies[lane] |= m;
+					d = preferred[lane] & m;
+				}
+
+				if (d)
+				{
+					taken[lane] |= m;
+					direction |= l;
+				}
+			}
+
+			TouchBits(direction);
+		}
+
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (!(active & (1 << lane))) continue;
+
+			results[lane] = states[lane].Finish
+				(taken[lane], discrepancies[lane], errors[lane]);
+		}
+
+		return presence;
+	}
+
+} // Namespace OneWire
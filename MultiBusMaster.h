@@ -0,0 +1,123 @@
+/**
+ * @file MultiBusMaster.h
+ *
+ * MultiBusMaster class prototype. Runs up to 8 OneWire buses on the pins of
+ * one GPIO port in lockstep, so every time slot is shared by all of them.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_MULTIBUSMASTER_H
+#define STELLARIS_ONEWIRE_MULTIBUSMASTER_H
+
+
+#include "OneWireBus.h"
+#include "OneWireSearch.h"
+#include "DeviceTable.h"
+
+
+// Number of buses a OneWirePort can carry, one per bit of a port register
+#define OW_PORT_LANES	8
+
+
+namespace OneWire
+{
+
+	/**
+	 * Up to 8 OneWire buses, called lanes, on the pins of one port
+	 *
+	 * Every call takes a lane mask, bit n for lane n, and is expected to act
+	 * on all of those lanes with a single register access.
+	 */
+	class OneWirePort
+	{
+	public:
+		virtual ~OneWirePort() {}
+
+		// Lanes that have a bus connected
+		virtual BYTE Lanes(void) const = 0;
+
+		// Pull the lanes in mask low, or let them go
+		virtual void Low(BYTE mask) = 0;
+		virtual void Release(BYTE mask) = 0;
+
+		// Level of every lane, 1 for high
+		virtual BYTE Read(void) = 0;
+
+		// Wait for a slot timing, a TimingIndex, at the current speed
+		virtual void Delay(int index) = 0;
+
+		// Bus speed of every lane, OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+		virtual void SetSpeed(unsigned int busSpeed) = 0;
+		virtual unsigned int GetSpeed(void) const = 0;
+	};
+
+
+	/**
+	 * OneWire master for all the lanes of a OneWirePort at once
+	 *
+	 * Data is bit-sliced: each slot drives bit n of the port from lane n's
+	 * data, so a byte on 8 buses takes as long as a byte on one. Lanes not in
+	 * the active mask are left alone.
+	 */
+	class MultiBusMaster
+	{
+	public:
+		MultiBusMaster(OneWirePort& port);
+
+		// Lanes taking part in the following operations, all by default
+		void SetActive(BYTE mask);
+		BYTE GetActive(void) const;
+
+		// Reset every active lane, returns the lanes with a presence pulse
+		BYTE Reset(void);
+
+		// One time slot on every active lane. Bit n of bits is written to lane
+		// n, returns the levels sampled, so 1 bits double as read slots.
+		BYTE TouchBits(BYTE bits);
+
+		// Same byte to every active lane, such as a Skip ROM
+		void WriteByte(BYTE data);
+
+		// Touch len bytes on every lane, data[n] is lane n's buffer. Bytes are
+		// replaced with what was read, set them to 0xFF to read. Lanes with a
+		// null buffer only see read slots.
+		void Block(BYTE* const* data, int len);
+
+		// Skip ROM on every active lane
+		void SkipROM(void);
+
+		// Search every active lane at once into tables[n]. Lanes with a null
+		// table are left out. Returns the total number of devices found.
+		int Search(DeviceTable* const* tables);
+
+		// Lanes whose last Search() walked the whole bus
+		BYTE SearchComplete(void) const;
+
+	private:
+		// One search pass on every lane in mask, per lane state
+		BYTE SearchPass(SearchState* states, BYTE mask, SearchResult* results);
+
+		OneWirePort& port;
+		BYTE active;
+		BYTE complete;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_MULTIBUSMASTER_H
@@ -0,0 +1,115 @@
+/**
+ * @file OneWireBus.cpp
+ *
+ * Default implementations of the composite OneWireBus operations, built from
+ * the single bit slots. Transports with hardware support override them.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	void OneWireBus::WriteBytes(const BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE b = data[i];
+			for (int bit = 0; bit < 8; ++bit, b >>= 1) WriteBit(b & 0x01);
+		}
+	}
+
+	void OneWireBus::ReadBytes(BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE b = 0;
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				if (ReadBit()) b |= 1 << bit;
+			}
+			data[i] = b;
+		}
+	}
+
+	void OneWireBus::TouchBytes(BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE b = data[i];
+			BYTE result = 0;
+
+			for (int bit = 0; bit < 8; ++bit, b >>= 1)
+			{
+				// A 1 is a read slot, a 0 just a write
+				if (b & 0x01)
+				{
+					if (ReadBit()) result |= 1 << bit;
+				}
+				else WriteBit(0);
+			}
+			data[i] = result;
+		}
+	}
+
+	BYTE OneWireBus::Triplet(BYTE direction)
+	{
+		BYTE id = ReadBit();
+		BYTE comp = ReadBit();
+
+		// Only one answer present, that is the way to go
+		if (id != comp) direction = id;
+
+		WriteBit(direction);
+
+		return (id ? OW_TRIPLET_ID : 0)
+			| (comp ? OW_TRIPLET_COMP : 0)
+			| (direction ? OW_TRIPLET_DIR : 0);
+	}
+
+	void OneWireBus::SearchPass
+		( ROM preferred
+		, ROM& taken
+		, ROM& discrepancies
+		, ROM& errors
+		)
+	{
+		taken = 0;
+		discrepancies = 0;
+		errors = 0;
+
+		for (int i = 0; i < 64; ++i)
+		{
+			ROM mask = (ROM)1 << i;
+			BYTE result = Triplet((preferred & mask) ? 1 : 0);
+
+			if (result & OW_TRIPLET_DIR) taken |= mask;
+
+			if (!(result & (OW_TRIPLET_ID | OW_TRIPLET_COMP)))
+				discrepancies |= mask;
+			else if ((result & OW_TRIPLET_ID) && (result & OW_TRIPLET_COMP))
+				errors |= mask;
+		}
+	}
+
+} // Namespace OneWire
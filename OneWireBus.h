@@ -0,0 +1,113 @@
+/**
+ * @file OneWireBus.h
+ *
+ * OneWireBus transport interface. Everything OneWireMaster needs from the
+ * physical layer is funneled through this class, so the bus can be bit-banged
+ * on a Stellaris pin, simulated on a host machine, or driven through a bridge
+ * chip without the master caring which.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_BUS_H
+#define STELLARIS_ONEWIRE_BUS_H
+
+
+#include <stdint.h>
+
+
+// OneWire bus speed settings
+#define OW_SPEED_OVERDRIVE	0
+#define OW_SPEED_STANDARD	1
+
+// Triplet() result flags, laid out like the DS2482 status register bits
+#define OW_TRIPLET_ID		0x01	// First bit read, the ID bit
+#define OW_TRIPLET_COMP		0x02	// Second bit read, the complement
+#define OW_TRIPLET_DIR		0x04	// Direction written
+
+
+namespace OneWire
+{
+
+	typedef unsigned char BYTE;
+
+	/**
+	 * A ROM ID packed into 64 bits in wire order: the family code is the low
+	 * byte and bit n is the n-th bit sent during a search.
+	 */
+	typedef uint64_t ROM;
+
+
+	/**
+	 * OneWire transport, the bit-level primitives of the bus
+	 *
+	 * Implementations are responsible for their own slot timing, using the
+	 * speed set through SetSpeed().
+	 */
+	class OneWireBus
+	{
+	public:
+		virtual ~OneWireBus() {}
+
+		// Reset the bus, returns 1 if a presence pulse was detected
+		virtual int Reset(void) = 0;
+
+		// Single bit time slots
+		virtual void WriteBit(BYTE bit) = 0;
+		virtual BYTE ReadBit(void) = 0;
+
+		// Wait for a number of microseconds
+		virtual void WaitUS(unsigned int us) = 0;
+
+		// Bus speed, OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+		virtual void SetSpeed(unsigned int busSpeed) = 0;
+		virtual unsigned int GetSpeed(void) const = 0;
+
+		// Free running time in nanoseconds, for statistics. Transports
+		// without a clock return 0.
+		virtual unsigned long long NowNS(void) const { return 0; }
+
+		// Whole bytes, least significant bit first. Transports that can move
+		// bytes in one go, such as bridge chips, override these.
+		virtual void WriteBytes(const BYTE* data, int len);
+		virtual void ReadBytes(BYTE* data, int len);
+
+		// Write every byte, sampling the 1 bits as read slots, and replace
+		// it with what was read
+		virtual void TouchBytes(BYTE* data, int len);
+
+		// Search triplet: read the ID bit and its complement, then write the
+		// direction. If only one of the two was present that is the direction
+		// taken, otherwise direction is. Returns OW_TRIPLET_* flags.
+		virtual BYTE Triplet(BYTE direction);
+
+		// The 64 triplets of a search pass, after the search command. preferred
+		// gives the direction to take at every discrepancy. On return taken is
+		// the path followed, discrepancies has the bits where both ID and
+		// complement read 0 and errors the bits where both read 1.
+		virtual void SearchPass
+			( ROM preferred
+			, ROM& taken
+			, ROM& discrepancies
+			, ROM& errors
+			);
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_BUS_H
@@ -0,0 +1,98 @@
+/**
+ * @file OneWireCRC.cpp
+ *
+ * OneWire CRC8 and CRC16 over blocks of data
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OneWireCRC.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Run a block of data through a CRC8
+	 *
+	 * @param[in] crc CRC so far, CRC8Init() to start
+	 * @param[in] data Bytes to add
+	 * @param[in] len Number of bytes
+	 * @return Updated CRC
+	 */
+	BYTE CRC8Update(BYTE crc, const BYTE* data, unsigned int len)
+	{
+	#if ONEWIRE_CRC8_CALCULATION_METHOD == 8
+		return CRC8Slice8(crc, data, len);
+	#elif ONEWIRE_CRC8_CALCULATION_METHOD == 4
+		return CRC8Slice4(crc, data, len);
+	#elif ONEWIRE_CRC8_CALCULATION_METHOD
+		return CRC8Table(crc, data, len);
+	#else
+		return CRC8Bitwise(crc, data, len);
+	#endif
+	}
+
+	BYTE CRC8Bitwise(BYTE crc, const BYTE* data, unsigned int len)
+	{
+		for (unsigned int i = 0; i < len; ++i)
+		{
+			BYTE inbyte = data[i];
+			for (int j = 0; j < 8; ++j)
+			{
+				BYTE mix = (crc ^ inbyte) & 0x01;
+				crc >>= 1;
+				if (mix) crc ^= 0x8C;
+				inbyte >>= 1;
+			}
+		}
+
+		return crc;
+	}
+
+	BYTE CRC8Table(BYTE crc, const BYTE* data, unsigned int len)
+	{
+		for (unsigned int i = 0; i < len; ++i)
+		{
+			crc = CRCTable::crc8[crc ^ data[i]];
+		}
+
+		return crc;
+	}
+
+	/**
+	 * Run a block of data through a CRC16
+	 *
+	 * @param[in] crc CRC so far, CRC16Init() to start
+	 * @param[in] data Bytes to add
+	 * @param[in] len Number of bytes
+	 * @return Updated CRC
+	 */
+	unsigned short CRC16Update(unsigned short crc, const BYTE* data, unsigned int len)
+	{
+		for (unsigned int i = 0; i < len; ++i)
+		{
+			crc = CRC16Update(crc, data[i]);
+		}
+
+		return crc;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,193 @@
+/**
+ * @file OneWireCRC.h
+ *
+ * OneWire CRC8 and CRC16, as described in Maxim Application Note 27. Both
+ * come as a streaming init/update/final interface so a CRC can be run over
+ * data as it comes off the bus, rather than over a buffer afterwards. The
+ * lookup tables are generated at compile time.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_CRC_H
+#define STELLARIS_ONEWIRE_CRC_H
+
+
+#include "OneWireBus.h"
+
+
+// The Dallas Semiconductor example code for OneWire CRC checking provides two
+// methods for computing the CRC of a line of data, and two more are added here
+// for long blocks. This define selects the one CRC8Update() uses on buffers:
+//   0 - bit by bit, no table at all, the smallest and slowest
+//   1 - one 256 byte table lookup per byte
+//   4 - slice-by-4, four 256 byte tables, four bytes per step
+//   8 - slice-by-8, eight 256 byte tables, eight bytes per step
+// Single bytes always use method 0 or 1, whichever is closer. Each table is a
+// separate object: method 1 needs the 256 byte one, slice-by-4 three more and
+// slice-by-8 another four. The slice tables are only referenced from
+// OneWireCRCSlice.cpp, which a static library only links in for methods 4
+// and 8; a build that links every object file directly can leave that file
+// out for methods 0 and 1.
+#ifndef ONEWIRE_CRC8_CALCULATION_METHOD
+#define ONEWIRE_CRC8_CALCULATION_METHOD	1
+#endif // ONEWIRE_CRC8_CALCULATION_METHOD
+
+// Running a CRC16 over data followed by the inverted CRC the device sent,
+// low byte first, leaves this value
+#define OW_CRC16_RESIDUE	0xB001
+
+
+namespace OneWire
+{
+
+	/**
+	 * Shift bits bits of data through a CRC8, X^8 + X^5 + X^4 + 1 reflected
+	 */
+	constexpr BYTE CRC8Shift(BYTE crc, int bits)
+	{
+		return bits == 0 ? crc
+			: CRC8Shift((BYTE)((crc & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1), bits - 1);
+	}
+
+	/**
+	 * Slice table entry: CRC8 state n after it is followed by slice zero bytes
+	 */
+	constexpr BYTE CRC8Entry(int slice, BYTE n)
+	{
+		return slice == 0 ? CRC8Shift(n, 8) : CRC8Shift(CRC8Entry(slice - 1, n), 8);
+	}
+
+	/**
+	 * Same for CRC16, X^16 + X^15 + X^2 + 1 reflected
+	 */
+	constexpr unsigned short CRC16Shift(unsigned short crc, int bits)
+	{
+		return bits == 0 ? crc
+			: CRC16Shift((unsigned short)((crc & 0x01) ? (crc >> 1) ^ 0xA001 : crc >> 1), bits - 1);
+	}
+
+	// Compile-time list of table indices
+	template <unsigned... I> struct CRCIndices {};
+	template <unsigned N, unsigned... I>
+	struct MakeCRCIndices : MakeCRCIndices<N - 1, N - 1, I...> {};
+	template <unsigned... I>
+	struct MakeCRCIndices<0, I...> { typedef CRCIndices<I...> type; };
+
+	/**
+	 * CRC lookup tables. crc8 is the classic byte table, slice row k
+	 * advances it by k more zero bytes, which is what slice-by-N combines:
+	 * slice4 holds rows 1 to 3 and slice8 rows 4 to 7.
+	 */
+	template <typename Indices> struct CRCTables;
+
+	template <unsigned... I>
+	struct CRCTables< CRCIndices<I...> >
+	{
+		static constexpr BYTE crc8[256] = { CRC8Entry(0, I)... };
+
+		static constexpr BYTE slice4[3][256] =
+			{ { CRC8Entry(1, I)... }
+			, { CRC8Entry(2, I)... }
+			, { CRC8Entry(3, I)... }
+			};
+
+		static constexpr BYTE slice8[4][256] =
+			{ { CRC8Entry(4, I)... }
+			, { CRC8Entry(5, I)... }
+			, { CRC8Entry(6, I)... }
+			, { CRC8Entry(7, I)... }
+			};
+
+		static constexpr unsigned short crc16[256] = { CRC16Shift(I, 8)... };
+	};
+
+	template <unsigned... I>
+	constexpr BYTE CRCTables< CRCIndices<I...> >::crc8[256];
+
+	template <unsigned... I>
+	constexpr BYTE CRCTables< CRCIndices<I...> >::slice4[3][256];
+
+	template <unsigned... I>
+	constexpr BYTE CRCTables< CRCIndices<I...> >::slice8[4][256];
+
+	template <unsigned... I>
+	constexpr unsigned short CRCTables< CRCIndices<I...> >::crc16[256];
+
+	typedef CRCTables<MakeCRCIndices<256>::type> CRCTable;
+
+	// The table generator has to agree with the Dallas sample code table
+	static_assert(CRC8Entry(0, 1) == 94 && CRC8Entry(0, 255) == 53,
+		"CRC8 table generator is broken");
+	static_assert(CRC16Shift(1, 8) == 0xC0C1 && CRC16Shift(255, 8) == 0x4040,
+		"CRC16 table generator is broken");
+
+
+	// CRC8, as used for ROM IDs and scratchpads. A block followed by its CRC
+	// byte comes out as 0.
+	inline BYTE CRC8Init(void)
+	{
+		return 0;
+	}
+
+	inline BYTE CRC8Update(BYTE crc, BYTE data)
+	{
+	#if ONEWIRE_CRC8_CALCULATION_METHOD
+		return CRCTable::crc8[crc ^ data];
+	#else
+		return CRC8Shift(crc ^ data, 8);
+	#endif
+	}
+
+	BYTE CRC8Update(BYTE crc, const BYTE* data, unsigned int len);
+
+	inline BYTE CRC8Final(BYTE crc)
+	{
+		return crc;
+	}
+
+	// Every CRC8 method, whatever ONEWIRE_CRC8_CALCULATION_METHOD selects, so
+	// they can be compared against each other
+	BYTE CRC8Bitwise(BYTE crc, const BYTE* data, unsigned int len);
+	BYTE CRC8Table(BYTE crc, const BYTE* data, unsigned int len);
+	BYTE CRC8Slice4(BYTE crc, const BYTE* data, unsigned int len);
+	BYTE CRC8Slice8(BYTE crc, const BYTE* data, unsigned int len);
+
+
+	// CRC16, as used by memory and counter devices. Devices send the inverted
+	// CRC, which is what CRC16Final() gives.
+	inline unsigned short CRC16Init(void)
+	{
+		return 0;
+	}
+
+	inline unsigned short CRC16Update(unsigned short crc, BYTE data)
+	{
+		return (crc >> 8) ^ CRCTable::crc16[(crc ^ data) & 0xFF];
+	}
+
+	unsigned short CRC16Update(unsigned short crc, const BYTE* data, unsigned int len);
+
+	inline unsigned short CRC16Final(unsigned short crc)
+	{
+		return ~crc;
+	}
+
+}
+#endif // STELLARIS_ONEWIRE_CRC_H
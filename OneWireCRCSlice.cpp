@@ -0,0 +1,73 @@
+/**
+ * @file OneWireCRCSlice.cpp
+ *
+ * Slice-by-4 and slice-by-8 CRC8, kept apart from OneWireCRC.cpp so their
+ * tables are only linked into builds that use them
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OneWireCRC.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Four bytes per step. Only the first byte is chained through the CRC,
+	 * the other three are looked up independently, so the loads overlap.
+	 */
+	BYTE CRC8Slice4(BYTE crc, const BYTE* data, unsigned int len)
+	{
+		const BYTE* t0 = CRCTable::crc8;
+		const BYTE (*t)[256] = CRCTable::slice4;
+
+		for (; len >= 4; len -= 4, data += 4)
+		{
+			crc = t[2][crc ^ data[0]]
+				^ t[1][data[1]]
+				^ t[0][data[2]]
+				^ t0[data[3]];
+		}
+
+		return CRC8Table(crc, data, len);
+	}
+
+	BYTE CRC8Slice8(BYTE crc, const BYTE* data, unsigned int len)
+	{
+		const BYTE* t0 = CRCTable::crc8;
+		const BYTE (*t)[256] = CRCTable::slice4;
+		const BYTE (*u)[256] = CRCTable::slice8;
+
+		for (; len >= 8; len -= 8, data += 8)
+		{
+			crc = u[3][crc ^ data[0]]
+				^ u[2][data[1]]
+				^ u[1][data[2]]
+				^ u[0][data[3]]
+				^ t[2][data[4]]
+				^ t[1][data[5]]
+				^ t[0][data[6]]
+				^ t0[data[7]];
+		}
+
+		return CRC8Slice4(crc, data, len);
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,67 @@
+/**
+ * @file OneWireDevice.cpp
+ *
+ * Base class for OneWire device handlers
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OneWireDevice.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWireDevice constructor
+	 *
+	 * @param[in] master Master the device is reached through
+	 * @param[in] rom ROM ID of the device
+	 */
+	OneWireDevice::OneWireDevice(OneWireMaster& master, ROM rom)
+		: master(master)
+		, rom(rom)
+	{
+	}
+
+	ROM OneWireDevice::GetROM(void) const
+	{
+		return rom;
+	}
+
+	BYTE OneWireDevice::GetFamily(void) const
+	{
+		return FamilyCode(rom);
+	}
+
+	bool OneWireDevice::Present(void)
+	{
+		return master.Verify(rom);
+	}
+
+	bool OneWireDevice::Select(void)
+	{
+		if (!master.Reset()) return false;
+
+		master.MatchROM(rom);
+		return true;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,64 @@
+/**
+ * @file OneWireDevice.h
+ *
+ * OneWireDevice class prototype. Base for the device handler classes, tying a
+ * ROM ID to the master it is reached through.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_DEVICE_H
+#define STELLARIS_ONEWIRE_DEVICE_H
+
+
+#include "OneWireMaster.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * A single device on the bus
+	 *
+	 * Derive from this for a new device type, and build its operations from
+	 * Select() or from Transactions addressed with Match(rom).
+	 */
+	class OneWireDevice
+	{
+	public:
+		OneWireDevice(OneWireMaster& master, ROM rom);
+		virtual ~OneWireDevice() {}
+
+		// Identity
+		ROM GetROM(void) const;
+		BYTE GetFamily(void) const;
+
+		// Whether the device is on the bus, see OneWireMaster::Verify()
+		bool Present(void);
+
+	protected:
+		// Reset the bus and address this device, false if nobody answered
+		bool Select(void);
+
+		OneWireMaster& master;
+		ROM rom;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_DEVICE_H
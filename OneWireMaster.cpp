@@ -77,123 +77,74 @@
 
 
 #include "OneWireMaster.h"
+#include "OneWireTiming.h"
 
 
-namespace OneWire
-{
+// Statistics bookkeeping, compiled out with OW_STATISTICS
+#if OW_STATISTICS
+#define OW_STAT(...) __VA_ARGS__
+#else
+#define OW_STAT(...)
+#endif // OW_STATISTICS
 
-	/**
-	 * Timing array for overdrive bus speed values
-	 *
-	 * This array contains the datasheet recommended timings in MS/uS values
-	 */
-	const int OneWireMaster::standardTime[10] = {6, 64, 60, 10, 9, 55, 0, 480, 70, 410};
 
-	/**
-	 * Timing array for standard bus speed values
-	 *
-	 * This array contains the datasheet recommended timings in MS/uS values
-	 */
-	const int OneWireMaster::overdriveTime[10] = {1.5, 7.5, 7.5, 2.5, 0.75, 7, 2.5, 70, 8.5, 40};
+namespace OneWire
+{
 
+#if OW_STATISTICS
+	// Timing table durations of a reset and of the slots
+	static unsigned long long ResetNS(const unsigned long* timing)
+	{
+		return timing[OW_TIME_G] + timing[OW_TIME_H] + timing[OW_TIME_I] + timing[OW_TIME_J];
+	}
 
-	/**
-	 * OneWireMaster constructor
-	 * 
-	 * @param[in] gpio_periph Peripherial address of the GPIO port from sysctl.h
-	 * @param[in] gpio_port GPIO port from hw_memmap.h
-	 * @param[in] gpio_pinmask GPIO pin from gpio.h
-	 * @param[in] bus_speed Bus speed timing table to use. 0 for overdrive, 1 for
-	 * standard speed
-	 * 
-	 * Please note that while overdrive support is present the Stellaris is not
-	 * capable of generating a precise enough clock (sub-uS range) to garuntee
-	 * reliable operation. YMMV.
-	 */
-	OneWireMaster::OneWireMaster
-		( unsigned int busSpeed
-		, unsigned long gpioPeriph
-		, unsigned long gpioPort
-		, unsigned char gpioPinmask
-		)
-		: GPIOPin(gpioPeriph, gpioPort, gpioPinmask)
+	static unsigned long long WriteNS(const unsigned long* timing, BYTE bit)
 	{
-		// Set the pin to a 4mA open-drain weak pull up, per 1-wire spec.
-		this->GPIOPin.PullMode(GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+		return bit & 0x01
+			? timing[OW_TIME_A] + timing[OW_TIME_B]
+			: timing[OW_TIME_C] + timing[OW_TIME_D];
+	}
 
-		if (busSpeed == 0)
-			timing = overdriveTime;
-		else
-			timing = standardTime;
+	static unsigned long long ReadNS(const unsigned long* timing)
+	{
+		return timing[OW_TIME_A] + timing[OW_TIME_E] + timing[OW_TIME_F];
 	}
+#endif // OW_STATISTICS
 
 	/**
-	 * Same as two argument constructor, except this will default to using pin 
-	 * A2 as the OneWire bus.
+	 * OneWireMaster constructor
 	 *
-	 * @param[in] busSpeed Bus speed timing table to use. 0 for overdrive, 1 for
-	 * standard speed.
-	 * 
-	 * Please note that while overdrive support is present the Stellaris is not
-	 * capable of generating a precise enough clock (sub-uS range) to garuntee
-	 * reliable operation. YMMV.
+	 * @param[in] bus Transport used for all bus operations. The master does not
+	 * take ownership, the transport must outlive it.
 	 */
-	OneWireMaster::OneWireMaster(unsigned int busSpeed)
-		:GPIOPin(SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE, GPIO_PIN_7)
+	OneWireMaster::OneWireMaster(OneWireBus& bus)
+		: bus(bus)
 	{
-		// Set the pin to a 4mA open-drain weak pull up, per 1-wire spec.
-		this->GPIOPin.PullMode(GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
-
-		if (busSpeed == 0)
-			timing = overdriveTime;
-		else
-			timing = standardTime;
 	}
 
 	/**
-	 * Wait for specified number of microeconds
-	 *
-	 * Note that the use of SysCtlClockGet() may cause some small clock drift, as
-	 * that operation takes a finite amount of time to perform. It would be better
-	 * to use the provided commented out portion if you already know the response
-	 * value for SysCtlClockGet. 
-	 *
-	 * Note that the division by 3 is due to SysCtlDelay using 3 operations for
-	 * it's wait loop, therefore any clock speed must be divided by 3.
+	 * Wait for specified number of microeconds, see the transport for accuracy
 	 */
 	void OneWireMaster::WaitUS(unsigned int us)
 	{
-		if (us <= 0) return;
-		SysCtlDelay((us / 3) * (SysCtlClockGet() / 1000000 ));
-		// Alternative with pre-set clock:
-		// SysCtlDelay((us / 3) * (CLOCKSPEEDVALUE / 1000000 ));
+		bus.WaitUS(us);
 	}
 
 	/**
-	 * Reset the OneWire bus for new commands. Based off of example code from
-	 * Dallas Semiconductor.
+	 * Reset the OneWire bus for new commands.
 	 *
-	 * Sends out the RESET signal across the OneWire pin and waits for the response
-	 * presence detect.
-	 * 
 	 * @param[out] presence Returns 1 if presence detect was present, 0 otherwise
 	 */
 	int OneWireMaster::Reset(void)
 	{
-		BYTE result = 0;
+		OW_STAT(unsigned long long start = bus.NowNS());
+		int presence = bus.Reset();
 
-		WaitUS(timing[6]);	
-		GPIOPin.Output();
-		GPIOPin.Write(0);	// Bring bus low for reset
-		WaitUS(timing[7]);	// Wait for reset duration
-		GPIOPin.Input();	// Bring bus to input mode
-		WaitUS(timing[8]);	// Wait for presence detect
-		result = GPIOPin.Read();
-		result = result == 0 ? 1 : 0;
-		//result = GPIOPin.Read() == 0 ? 1 : 0; // See if there is a presence detect
-		WaitUS(timing[9]);	// Finish out presence detect, ready for commands
+		OW_STAT(++stats.resets);
+		OW_STAT(if (!presence) ++stats.presenceFailures);
+		OW_STAT(Measure(STATS_RESET, start, ResetNS(TimingNS(bus.GetSpeed())), 1));
 
-		return result;
+		return presence;
 	}
 
 	/**
@@ -201,24 +152,10 @@ namespace OneWire
 	 */
 	void OneWireMaster::WriteBit(BYTE bit)
 	{
-		bit = bit & 0x01; // Make sure we don't have something silly here
+		OW_STAT(unsigned long long start = bus.NowNS());
+		bus.WriteBit(bit);
 
-		if (bit)	// '1' bit
-		{
-			GPIOPin.Output();	// Make sure we're in output
-			GPIOPin.Write(0);	// Bring bus low for reset
-			WaitUS(timing[0]);	// Wait for spec duration
-			GPIOPin.Input();	// Release for pullup
-			WaitUS(timing[1]);	// Wait for recovery time
-		}
-		else	// '0' bit
-		{
-			GPIOPin.Output();	// Set to output
-			GPIOPin.Write(0);	// Pull line low
-			WaitUS(timing[2]);	// Wait for spec duration
-			GPIOPin.Input();	// Release for pullup
-			WaitUS(timing[3]);	// Wait for recovery time
-		}
+		OW_STAT(Measure(STATS_BIT, start, WriteNS(TimingNS(bus.GetSpeed()), bit), 1));
 	}
 
 	/**
@@ -226,50 +163,61 @@ namespace OneWire
 	 */
 	BYTE OneWireMaster::ReadBit(void)
 	{
-		BYTE result;
+		OW_STAT(unsigned long long start = bus.NowNS());
+		BYTE result = bus.ReadBit();
 
-		GPIOPin.Output();	// Set to output
-		GPIOPin.Write(0);	// Pull line low
-		WaitUS(timing[0]);	// Wait for control
-		GPIOPin.Input();	// Release for pullup
-		WaitUS(timing[4]);	// Wait for signal from slaves
-		result = GPIOPin.Read() & 0x01;	// Read the value on the line
-		WaitUS(timing[5]);	// Wait for bus to finish operation
+		OW_STAT(Measure(STATS_BIT, start, ReadNS(TimingNS(bus.GetSpeed())), 1));
 
 		return result;
 	}
 
 	/**
-	 * Write a byte out to the line. This is a batch operation of WriteBit.
+	 * Write a byte out to the line. The transport turns it into bit slots,
+	 * or hands it to a bridge chip whole.
 	 */
 	void OneWireMaster::WriteByte(BYTE data)
 	{
-		// Loop through the byte, least significant bit first.
-		for (int i = 0; i < 8; ++i)
-		{
-			WriteBit(data & 0x01);
+		OW_STAT(unsigned long long start = bus.NowNS());
+		bus.WriteBytes(&data, 1);
 
-			// Shift byte for next bit
-			data >>= 1;
-		}
+		OW_STAT(Measure(STATS_BYTE, start, Traffic(&data, 1, false), 8));
 	}
 
 	/**
-	 * Read a byte from the line. This is a batch operation of ReadBit.
+	 * Read a byte from the line
 	 */
 	BYTE OneWireMaster::ReadByte(void)
 	{
-		BYTE result = 0;
+		BYTE result;
 
-		for (int i = 0; i < 8; ++i)
-		{
-			// Shift result
-			result >>= 1;
+		OW_STAT(unsigned long long start = bus.NowNS());
+		bus.ReadBytes(&result, 1);
 
-			// If result is one, set MS bit
-			if (ReadBit()) result |= 0x80;
-		}
+		OW_STAT(Measure(STATS_BYTE, start, Traffic(0, 1, false), 8));
+		return result;
+	}
 
+	/**
+	 * Read a byte and add it to a running CRC8
+	 *
+	 * @param[in,out] crc8 CRC so far, see CRC8Init()
+	 */
+	BYTE OneWireMaster::ReadByte(BYTE& crc8)
+	{
+		BYTE result = ReadByte();
+		crc8 = CRC8Update(crc8, result);
+		return result;
+	}
+
+	/**
+	 * Read a byte and add it to a running CRC16
+	 *
+	 * @param[in,out] crc16 CRC so far, see CRC16Init()
+	 */
+	BYTE OneWireMaster::ReadByte(unsigned short& crc16)
+	{
+		BYTE result = ReadByte();
+		crc16 = CRC16Update(crc16, result);
 		return result;
 	}
 
@@ -279,37 +227,48 @@ namespace OneWire
 	 */
 	int OneWireMaster::TouchByte(BYTE data)
 	{
-		int result = 0;
-	
-		for (int loop = 0; loop < 8; loop++)
-		{
-			// shift the result to get it ready for the next bit
-			result >>= 1;
-		
-			// If sending a '1' then read a bit else write a '0'
-			if (data & 0x01)
-			{
-				if (ReadBit()) result |= 0x80;
-			}
-			else WriteBit(0);
-		
-			// shift the data byte for the next bit
-			data >>= 1;
-		}
-	
-		return result;
+		OW_STAT(unsigned long long start = bus.NowNS());
+		OW_STAT(unsigned long long nominal = Traffic(&data, 1, true));
+		bus.TouchBytes(&data, 1);
+
+		OW_STAT(Measure(STATS_BYTE, start, nominal, 8));
+		return data;
 	}
 
 	/**
 	 * Not seen this one used either, but it is for writing a block of OneWire data
-	 * byes and returning the sampled results in the same buffer.
+	 * byes and returning the sampled results in the same buffer. The block goes
+	 * to the transport in one piece, so a bridge chip can send it in one write.
 	 */
 	void OneWireMaster::Block(BYTE* data, int data_len)
 	{
-		for (int loop = 0; loop < data_len; loop++)
-		{
-			data[loop] = TouchByte(data[loop]);
-		}
+		OW_STAT(unsigned long long start = bus.NowNS());
+		OW_STAT(unsigned long long nominal = Traffic(data, data_len, true));
+		bus.TouchBytes(data, data_len);
+
+		OW_STAT(Measure(STATS_BLOCK, start, nominal, data_len * 8));
+	}
+
+	/**
+	 * Block(), with the bytes read added to a running CRC8
+	 *
+	 * @param[in,out] crc8 CRC so far, see CRC8Init()
+	 */
+	void OneWireMaster::Block(BYTE* data, int data_len, BYTE& crc8)
+	{
+		Block(data, data_len);
+		crc8 = CRC8Update(crc8, data, data_len);
+	}
+
+	/**
+	 * Block() with a running CRC16
+	 *
+	 * @param[in,out] crc16 CRC so far, see CRC16Init()
+	 */
+	void OneWireMaster::Block(BYTE* data, int data_len, unsigned short& crc16)
+	{
+		Block(data, data_len);
+		crc16 = CRC16Update(crc16, data, data_len);
 	}
 
 	/**
@@ -324,22 +283,51 @@ namespace OneWire
 	 */
 	int OneWireMaster::SkipOverdrive()
 	{
-		timing = standardTime;		// Make sure we're on standard timings
+		bus.SetSpeed(OW_SPEED_STANDARD);	// Make sure we're on standard timings
 		if (!Reset()) return 0;		// If nothing shows up, fail out
 		WriteByte(OW_OVERDRIVE_SKIP);	// Run Overdrive Skip command
-		timing = overdriveTime;		// Set to ovedrive timings
+		bus.SetSpeed(OW_SPEED_OVERDRIVE);	// Set to ovedrive timings
 		return Reset();				// Return result of overdrive presence
 	}
 
+	/**
+	 * Change the slot timing of the bus. Devices only follow with an
+	 * Overdrive Skip or Match, or drop back on a standard speed reset.
+	 */
+	void OneWireMaster::SetSpeed(unsigned int busSpeed)
+	{
+		bus.SetSpeed(busSpeed);
+	}
+
+	unsigned int OneWireMaster::GetSpeed(void) const
+	{
+		return bus.GetSpeed();
+	}
+
 	/**
 	 * Perform a ROM select operation
 	 */
-	void OneWireMaster::MatchROM(std::vector<BYTE> rom)
+	void OneWireMaster::MatchROM(const std::vector<BYTE>& rom)
 	{
-		WriteByte(OW_MATCH_ROM);	// Perform Match Rom command
+		BYTE select[9] = {OW_MATCH_ROM};	// Perform Match Rom command
 
 		// Write out the address
-		for (int i = 0; i < 8; ++i) WriteByte(rom[i]);
+		for (int i = 0; i < 8; ++i) select[i + 1] = rom[i];
+		bus.WriteBytes(select, 9);
+		OW_STAT(Traffic(select, 9, false));
+	}
+
+	/**
+	 * Perform a ROM select operation on a packed ROM ID
+	 */
+	void OneWireMaster::MatchROM(ROM rom)
+	{
+		BYTE select[9] = {OW_MATCH_ROM};	// Perform Match Rom command
+
+		// Write out the address, family code first
+		UnpackROM(rom, select + 1);
+		bus.WriteBytes(select, 9);
+		OW_STAT(Traffic(select, 9, false));
 	}
 
 	/**
@@ -351,226 +339,514 @@ namespace OneWire
 	}
 
 	/**
-	 * Perform a ROM search and populate the Addresses 2D vector with addresses of
-	 * found devices. The primary vector is a list of addresses, the secondary is
-	 * the bytes of the address itself. The return value is used to determine if
-	 * something went wrong during the search process. If this is 0, something bad
-	 * happened. Anything else indicates the number of returned addresses.
+	 * Run a transaction: reset, ROM command, function command, payload and
+	 * read, then the CRC check. Bytes go straight between the bus and the
+	 * caller's buffers, a whole section at a time.
+	 *
+	 * @param[in] transaction What to do, see Transaction
+	 * @return TRANSACTION_OK, or what went wrong
+	 */
+	TransactionResult OneWireMaster::Execute(const Transaction& transaction)
+	{
+		OW_STAT(unsigned long long start = bus.NowNS());
+		TransactionResult result = Perform(transaction);
+
+		OW_STAT(if (result == TRANSACTION_CRC_ERROR) ++stats.crcFailures);
+		OW_STAT(Measure(STATS_TRANSACTION, start, 0, 0));
+
+		return result;
+	}
+
+	TransactionResult OneWireMaster::Perform(const Transaction& transaction)
+	{
+		const Transaction& t = transaction;
+		BYTE select[10];
+		int selectLength = 0;
+
+		// Overdrive Match is sent at standard speed, the ROM at overdrive
+		if (t.select == SELECT_OVERDRIVE_MATCH) bus.SetSpeed(OW_SPEED_STANDARD);
+
+		if (t.reset && !Reset()) return TRANSACTION_NO_PRESENCE;
+
+		switch (t.select)
+		{
+		case SELECT_SKIP:
+			select[selectLength++] = OW_SKIP_ROM;
+			break;
+		case SELECT_MATCH:
+			select[selectLength++] = OW_MATCH_ROM;
+			UnpackROM(t.rom, select + selectLength);
+			selectLength += 8;
+			break;
+		case SELECT_RESUME:
+			select[selectLength++] = OW_RESUME;
+			break;
+		case SELECT_OVERDRIVE_MATCH:
+			WriteByte(OW_OVERDRIVE_MATCH);
+			bus.SetSpeed(OW_SPEED_OVERDRIVE);
+			UnpackROM(t.rom, select);
+			selectLength = 8;
+			break;
+		default:
+			break;
+		}
+
+		// The function command rides along with the ROM command
+		if (t.hasCommand) select[selectLength++] = t.command;
+		if (selectLength) bus.WriteBytes(select, selectLength);
+
+		if (t.writeLength) bus.WriteBytes(t.write, t.writeLength);
+		if (t.readLength) bus.ReadBytes(t.read, t.readLength);
+
+		OW_STAT(Traffic(select, selectLength, false));
+		OW_STAT(Traffic(t.write, t.writeLength, false));
+		OW_STAT(Traffic(0, t.readLength, false));
+
+		if (t.crc == CRC_8)
+		{
+			if (CRC8Update(CRC8Init(), t.read, t.readLength) != 0)
+				return TRANSACTION_CRC_ERROR;
+		}
+		else if (t.crc == CRC_16)
+		{
+			unsigned short crc = CRC16Init();
+
+			if (t.hasCommand) crc = CRC16Update(crc, t.command);
+			crc = CRC16Update(crc, t.write, t.writeLength);
+			crc = CRC16Update(crc, t.read, t.readLength);
+
+			if (crc != OW_CRC16_RESIDUE) return TRANSACTION_CRC_ERROR;
+		}
+
+		return TRANSACTION_OK;
+	}
+
+	/**
+	 * Perform a ROM search and populate the device table with addresses of
+	 * found devices. The table is cleared first, so it only ever holds the
+	 * result of the latest search.
 	 *
-	 * This makes use of the seacrh algorithm described by Dallas Semiconductor.
+	 * Passes that come back with a bad ROM are repeated up to
+	 * OW_SEARCH_RETRIES times before giving up, and giving up keeps every
+	 * device found so far. The return value is the number of devices in the
+	 * table, check SearchComplete() to see if that is all of them.
 	 */
 	int OneWireMaster::Search(void)
 	{
+		SearchResult result;
+
+		this->devices.Clear();
+		this->searchState.Begin();
+
+		while ((result = SearchStep(this->searchState)) == SEARCH_FOUND)
+		{
+			// A full table means the bus is misbehaving, or is just too big
+			if (!this->devices.Insert(this->searchState.rom)) break;
+		}
+
+		return this->devices.Count();
+	}
+
+	/**
+	 * Whether the last Search() walked the whole bus, rather than stopping on
+	 * repeated errors or a full device table.
+	 */
+	bool OneWireMaster::SearchComplete(void) const
+	{
+		return this->searchState.lastDevice;
+	}
+
+	/**
+	 * Find the first device on the bus
+	 *
+	 * @param[out] rom ROM ID of the device found
+	 * @return false if there are no devices, or the search failed
+	 */
+	bool OneWireMaster::SearchFirst(ROM& rom)
+	{
+		this->searchState.Begin();
+		return SearchNext(rom);
+	}
+
+	/**
+	 * Find the next device on the bus. A failed call can simply be repeated, it
+	 * picks up at the same point.
+	 *
+	 * @param[out] rom ROM ID of the device found
+	 * @return false if there are no more devices, or the search failed
+	 */
+	bool OneWireMaster::SearchNext(ROM& rom)
+	{
+		if (SearchStep(this->searchState) != SEARCH_FOUND) return false;
+
+		rom = this->searchState.rom;
+		return true;
+	}
+
+	/**
+	 * Run one search pass from a caller owned state. This is what the other
+	 * search functions are built on, and lets several searches be interleaved.
+	 *
+	 * @param[in,out] state Search position, advanced on success
+	 * @return SEARCH_FOUND with the device in state.rom, SEARCH_DONE when
+	 * there are no more, or SEARCH_ERROR if OW_SEARCH_RETRIES attempts at the
+	 * pass all failed
+	 */
+	SearchResult OneWireMaster::SearchStep(SearchState& state)
+	{
+		SearchResult result = SEARCH_ERROR;
+		ROM taken, discrepancies, errors;
+		bool presence = false;
+
+		if (state.lastDevice) return SEARCH_DONE;
+
+		for (int attempt = 0; attempt <= OW_SEARCH_RETRIES; ++attempt)
+		{
+			OW_STAT(if (attempt) ++stats.searchRestarts);
+			OW_STAT(unsigned long long start = bus.NowNS());
+
+			if (!Reset()) continue;
+			presence = true;
 
-		// Set up variables before we start talking to the line, avoiding
-		// any weird timing issues
-		unsigned char bit, bitComp, buffNum;
-		std::vector<unsigned char> device;	// Container for device address
-		std::vector<unsigned char> stack;	// Container depth-first search stack
+			// Run the search ROM command
+			WriteByte(state.alarm ? OW_ALARM_SEARCH : OW_SEARCH_ROM);
+			bus.SearchPass(state.Preferred(), taken, discrepancies, errors);
 
-		int safeCount = 0;	// Make sure we don't blow the heap with infinite devices
+			result = state.Finish(taken, discrepancies, errors);
 
-		while (true)
+			// Both bits reading 1 is a device gone missing mid pass, anything
+			// else failing is a bad ROM
+			OW_STAT(++stats.searchPasses);
+			OW_STAT(if (result == SEARCH_ERROR && !errors) ++stats.crcFailures);
+			OW_STAT(Measure(STATS_SEARCH, start, SearchNS(taken), 64 * 3 + 9));
+
+			if (result != SEARCH_ERROR) return result;
+		}
+
+		// Nobody answered a single reset, there is nothing on the bus
+		if (!presence)
 		{
-			device.clear();
-			buffNum = 0;
+			state.lastDevice = true;
+			return SEARCH_DONE;
+		}
 
-			this->Reset();
+		return result;
+	}
 
-			//this->WaitUS(1000);
 
-			this->WriteByte(OW_SEARCH_ROM);	// Run the search ROM command
-			this->WaitUS(100);
+#if OW_STATISTICS
+	/**
+	 * Timing table duration of a search pass down the path taken, reset and
+	 * search command included
+	 */
+	unsigned long long OneWireMaster::SearchNS(ROM taken)
+	{
+		const unsigned long* timing = TimingNS(bus.GetSpeed());
+		unsigned long long ns = ResetNS(timing);
 
-			for (int i = 0; i < 64; ++i)
-			{
-				//this->WaitUS(100);
+		// 0xF0 and 0xEC both have four 1 bits
+		for (int i = 0; i < 8; ++i) ns += WriteNS(timing, i < 4 ? 1 : 0);
+		for (int i = 0; i < 64; ++i)
+		{
+			ns += 2 * ReadNS(timing) + WriteNS(timing, (BYTE)(taken >> i));
+		}
 
-				bit = this->ReadBit();
-				bitComp = this->ReadBit();
+		return ns;
+	}
+#endif // OW_STATISTICS
 
-				if ((bit == 1) && (bitComp == 1))
-				{
-					// Both values are 1, indicating that something went wrong, we should have
-					// gotten at least some signal. We're either down the wrong path, or there's nothing
-					// on the line. Either way, hang up.
-					return 0; // Something bad happened
-				}
-				else if (bit != bitComp)
-				{
-					// Two different values, meaning this single value is the one to take
+	/**
+	 * Refresh the device table entries of one family only. Entries of other
+	 * families are left alone, and only the family's part of the ROM tree is
+	 * walked.
+	 *
+	 * @return Number of devices of the family found
+	 */
+	int OneWireMaster::SearchFamily(BYTE family)
+	{
+		unsigned int first;
+		unsigned int count = this->devices.FamilyRange(family, first);
+		int found = 0;
 
-					this->WriteBit(bit);
-					buffNum >>= 1;
-					bit <<= 7;
-					buffNum |= bit;
+		// Drop the old entries, they are contiguous
+		while (count--) this->devices.Remove(this->devices[first]);
 
-				}
-				else if ((bit == 0) && (bitComp == 0))
-				{
-					if (stack.size() == 0)
-					{
-						// Nothing here yet, start it up
-						stack.push_back(i);
-						this->WriteBit(0);
-						buffNum >>= 1;
-					}
-					else
-					{
-						// Two different numbers. See if it's in the stack already
-						if (i == stack.back())
-						{
-							// We've been down these roads, time to choose a new one
-							stack.pop_back();
-							this->WriteBit(1);
-							buffNum >>= 1;
-							buffNum |= 0x80;
-						}
-						else if (i > stack.back())
-						{
-							// New decision to make, choose 0
-							stack.push_back(i);
-							this->WriteBit(0);
-							buffNum >>= 1;
-						}
-						else if (i < stack.back())
-						{
-							// Still going down a road, continue 0
-							this->WriteBit(0);
-							buffNum >>= 1;
-						}
-					}
-				}
+		this->searchState.BeginFamily(family);
+		while (SearchStep(this->searchState) == SEARCH_FOUND)
+		{
+			if (!this->devices.Insert(this->searchState.rom)) break;
+			++found;
+		}
 
-				if ((i % 8) == 7)	// End of a byte, add it to the vector for the device
-				{
-					device.push_back(buffNum);
-					buffNum = 0;
-				}
+		return found;
+	}
 
-			}
+	/**
+	 * Find every device with an active alarm condition. The main device table
+	 * is not touched.
+	 *
+	 * @param[out] alarms Table to fill, cleared first
+	 * @return Number of devices in alarm
+	 */
+	int OneWireMaster::AlarmSearch(DeviceTable& alarms)
+	{
+		SearchState state;
+
+		alarms.Clear();
+
+		state.Begin(true);
+		while (SearchStep(state) == SEARCH_FOUND)
+		{
+			if (!alarms.Insert(state.rom)) break;
+		}
+
+		return alarms.Count();
+	}
+
+	/**
+	 * Find the first device with an active alarm condition
+	 */
+	bool OneWireMaster::AlarmFirst(ROM& rom)
+	{
+		this->searchState.Begin(true);
+		return SearchNext(rom);
+	}
+
+	bool OneWireMaster::AlarmNext(ROM& rom)
+	{
+		return SearchNext(rom);
+	}
+
+	/**
+	 * Find the first device of a family
+	 */
+	bool OneWireMaster::FamilyFirst(BYTE family, ROM& rom)
+	{
+		this->searchState.BeginFamily(family);
+		return SearchNext(rom);
+	}
+
+	bool OneWireMaster::FamilyNext(ROM& rom)
+	{
+		return SearchNext(rom);
+	}
+
+
+	/**
+	 * Check that a device is on the bus. This is a single search pass forced
+	 * down the device's own path, 64 triplets, which only completes if the
+	 * device answered every bit.
+	 *
+	 * @return true if the device is present
+	 */
+	bool OneWireMaster::Verify(ROM rom)
+	{
+		SearchState state;
+
+		state.BeginPrefix(rom, 64);
+		return SearchStep(state) == SEARCH_FOUND;
+	}
 
-			// Sort into human format
-			std::reverse(device.begin(), device.end());
+	/**
+	 * Whether a table entry not known to be missing starts with the first
+	 * length bits of prefix
+	 */
+	static bool KnownPrefix
+		( const DeviceTable& devices
+		, const DeviceTable& missing
+		, ROM prefix
+		, int length
+		)
+	{
+		ROM mask = length >= 64 ? ~(ROM)0 : ((ROM)1 << length) - 1;
 
-			// Store the new device address in the table
-			this->devices.push_back(device);
+		for (const ROM* rom = devices.Begin(); rom != devices.End(); ++rom)
+		{
+			if (((*rom ^ prefix) & mask) == 0 && !missing.Contains(*rom)) return true;
+		}
 
-			++safeCount;
+		return false;
+	}
 
-			if (stack.size() <= 0)
-				break;
+	/**
+	 * Verify every device in the device table, and look for devices that are
+	 * not in it.
+	 *
+	 * Each verification pass also shows every branch point along the device's
+	 * path. A branch leading to a part of the tree where the table has no
+	 * devices means something new was plugged in, and only that part of the
+	 * tree is searched. Missing devices don't count as being there, and the
+	 * part of the tree below a missing device's last branch point, which only
+	 * ever held that device, is searched as well: a device that took its
+	 * place is found there.
+	 *
+	 * @param[out] missing Table devices that did not answer, cleared first
+	 * @param[out] added Devices found that are not in the table, cleared first
+	 * @return Number of table devices present
+	 */
+	int OneWireMaster::VerifyAll(DeviceTable& missing, DeviceTable& added)
+	{
+		SearchState state;
+		int present = 0;
+
+		missing.Clear();
+		added.Clear();
 
-			if (safeCount > OW_MAX_NUM_DEVICES)
+		for (unsigned int i = 0; i < this->devices.Count(); ++i)
+		{
+			ROM rom = this->devices[i];
+
+			state.BeginPrefix(rom, 64);
+			if (SearchStep(state) != SEARCH_FOUND)
 			{
-				return 0;
+				int length = 0;
+
+				missing.Insert(rom);
+				for (int bit = 63; bit >= 0 && !length; --bit)
+				{
+					ROM mask = (ROM)1 << bit;
+					ROM sibling = (rom & (mask - 1)) | (~rom & mask);
+
+					if (KnownPrefix(this->devices, missing, sibling, bit + 1)) length = bit + 1;
+				}
+
+				SearchSubtree(rom, length, added);
+				continue;
 			}
+			++present;
+
+			// Look down the other side of every branch on the way
+			for (int bit = 0; bit < 64; ++bit)
+			{
+				ROM mask = (ROM)1 << bit;
+				ROM sibling = (rom & (mask - 1)) | (~rom & mask);
 
+				if (!(state.branches & mask)) continue;
+				if (KnownPrefix(this->devices, missing, sibling, bit + 1)) continue;
+				if (added.ContainsPrefix(sibling, bit + 1)) continue;
+
+				SearchSubtree(sibling, bit + 1, added);
+			}
 		}
 
-		return this->devices.size();
+		return present;
 	}
 
+	/**
+	 * Search the part of the tree under prefix for devices that aren't in the
+	 * device table
+	 *
+	 * @param[in] prefix Path to the subtree, bit 0 first
+	 * @param[in] length Number of bits in the path, 0 for the whole bus
+	 * @param[in,out] added Where new devices go, stops when it is full
+	 */
+	void OneWireMaster::SearchSubtree(ROM prefix, int length, DeviceTable& added)
+	{
+		SearchState subtree;
 
-	// The 1-Wire CRC scheme is described in Maxim Application Note 27:
-	// "Understanding and Using Cyclic Redundancy Checks with Maxim iButton Products"
-	//
-
-	#if ONEWIRE_CRC8_CALCULATION_METHOD
-	//
-	// Compute a Dallas Semiconductor 8 bit CRC. These show up in the ROM
-	// and the registers.  (note: this might better be done without the
-	// table, it would probably be smaller and certainly fast enough
-	// compared to all those delayMicrosecond() calls.  But I got
-	// confused, so I use this table from the examples.)  
-	//
-	BYTE OneWireMaster::CRC8(BYTE* addr, BYTE len)
-	{
-		// This table comes from Dallas sample code where it is freely reusable, 
-		// though Copyright (C) 2000 Dallas Semiconductor Corporation
-		static BYTE dscrc_table[] = 
+		subtree.BeginPrefix(prefix, length);
+		while (SearchStep(subtree) == SEARCH_FOUND)
 		{
-			  0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,
-			157,195, 33,127,252,162, 64, 30, 95,  1,227,189, 62, 96,130,220,
-			 35,125,159,193, 66, 28,254,160,225,191, 93,  3,128,222, 60, 98,
-			190,224,  2, 92,223,129, 99, 61,124, 34,192,158, 29, 67,161,255,
-			 70, 24,250,164, 39,121,155,197,132,218, 56,102,229,187, 89,  7,
-			219,133,103, 57,186,228,  6, 88, 25, 71,165,251,120, 38,196,154,
-			101, 59,217,135,  4, 90,184,230,167,249, 27, 69,198,152,122, 36,
-			248,166, 68, 26,153,199, 37,123, 58,100,134,216, 91,  5,231,185,
-			140,210, 48,110,237,179, 81, 15, 78, 16,242,172, 47,113,147,205,
-			 17, 79,173,243,112, 46,204,146,211,141,111, 49,178,236, 14, 80,
-			175,241, 19, 77,206,144,114, 44,109, 51,209,143, 12, 82,176,238,
-			 50,108,142,208, 83, 13,239,177,240,174, 76, 18,145,207, 45,115,
-			202,148,118, 40,171,245, 23, 73,  8, 86,180,234,105, 55,213,139,
-			 87,  9,235,181, 54,104,138,212,149,203, 41,119,244,170, 72, 22,
-			233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,
-			116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53
-		};
-
-		BYTE i;
-		BYTE crc = 0;
-	
-		for (i = 0; i < len; i++)
-		{
-			crc  = dscrc_table[crc ^ addr[i] ];
+			if (this->devices.Contains(subtree.rom)) continue;
+			if (!added.Insert(subtree.rom)) break;
 		}
-	
-		return crc;
-	}
-	#else
-	//
-	// Compute a Dallas Semiconductor 8 bit CRC directly. 
-	//
-	BYTE OneWireMaster::CRC8(BYTE* addr, BYTE len)
-	{
-		BYTE i, j;
-		BYTE crc = 0;
-	
-		for (i = 0; i < len; i++) 
+	}
+
+
+	// The 1-Wire CRC scheme is described in Maxim Application Note 27:
+	// "Understanding and Using Cyclic Redundancy Checks with Maxim iButton Products"
+	// The work is done in OneWireCRC, these are kept for existing callers.
+
+	/**
+	 * Compute a Dallas Semiconductor 8 bit CRC. These show up in the ROM and
+	 * the registers.
+	 */
+	BYTE OneWireMaster::CRC8(const BYTE* addr, BYTE len)
+	{
+		return CRC8Final(CRC8Update(CRC8Init(), addr, len));
+	}
+
+	/**
+	 * Compute a Dallas Semiconductor 16 bit CRC, as used by memory devices.
+	 * This is the CRC itself, devices send it inverted.
+	 */
+	unsigned short OneWireMaster::CRC16(const BYTE* data, unsigned short len)
+	{
+		return CRC16Update(CRC16Init(), data, len);
+	}
+
+	/**
+	 * Copy the statistics out, see OneWireStats
+	 *
+	 * @param[out] snapshot Filled in with the counters so far
+	 * @return false if statistics are compiled out, snapshot is left alone
+	 */
+	bool OneWireMaster::Statistics(OneWireStats& snapshot) const
+	{
+#if OW_STATISTICS
+		snapshot = stats;
+		return true;
+#else
+		(void)snapshot;
+		return false;
+#endif // OW_STATISTICS
+	}
+
+	void OneWireMaster::ClearStatistics(void)
+	{
+		OW_STAT(stats.Clear());
+	}
+
+#if OW_STATISTICS
+	/**
+	 * Count bytes moved through the bus
+	 *
+	 * @param[in] data Bytes sent, 0 if all of them are reads
+	 * @param[in] touch 0xFF bytes in data are reads, as in Block()
+	 * @return Timing table duration of their slots
+	 */
+	unsigned long long OneWireMaster::Traffic(const BYTE* data, int len, bool touch)
+	{
+		const unsigned long* timing = TimingNS(bus.GetSpeed());
+		unsigned long long ns = 0;
+
+		for (int i = 0; i < len; ++i)
 		{
-			BYTE inbyte = addr[i];
-			for (j = 0; j < 8; j++) 
+			if (!data || (touch && data[i] == 0xFF))
 			{
-				BYTE mix = (crc ^ inbyte) & 0x01;
-				crc >>= 1;
-				if (mix) crc ^= 0x8C;
-				inbyte >>= 1;
+				++stats.bytesIn;
+				ns += 8 * ReadNS(timing);
+				continue;
 			}
+
+			++stats.bytesOut;
+			for (int bit = 0; bit < 8; ++bit) ns += WriteNS(timing, data[i] >> bit);
 		}
-	
-		return crc;
-	}
-	#endif
 
+		return ns;
+	}
 
-	//
-	// Compute a Dallas Semiconductor 16 bit CRC. I have never seen one of
-	// these, but here it is.
-	//
-	unsigned short OneWireMaster::CRC16(unsigned short* data, unsigned short len)
+	/**
+	 * Record an operation's time, and how far its slots ran over the timing
+	 * table on average. A transport without a clock reports 0 for both.
+	 */
+	void OneWireMaster::Measure
+		( StatsOperation operation
+		, unsigned long long start
+		, unsigned long long nominalNS
+		, unsigned int slots
+		)
 	{
-		static short oddparity[16] = { 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 };
+		unsigned long long elapsed = bus.NowNS() - start;
+
+		stats.Record(operation, elapsed);
 
-		unsigned short i;
-		unsigned short crc = 0;
-	
-		for ( i = 0; i < len; i++) 
+		if (slots && elapsed > nominalNS)
 		{
-			unsigned short cdata = data[len];
-	
-			cdata = (cdata ^ (crc & 0xff)) & 0xff;
-			crc >>= 8;
-	
-			if (oddparity[cdata & 0xf] ^ oddparity[cdata >> 4]) crc ^= 0xc001;
-	
-			cdata <<= 6;
-			crc ^= cdata;
-			cdata <<= 1;
-			crc ^= cdata;
+			unsigned long long overrun = (elapsed - nominalNS) / slots;
+			if (overrun > stats.worstMeanOverrunNS) stats.worstMeanOverrunNS = overrun;
 		}
-	
-		return crc;
 	}
+#endif // OW_STATISTICS
 
 } // Namespace OneWire
@@ -80,40 +80,29 @@
 #define STELLARIS_ONEWIRE_LIBRARY_CHAPMAN_H
 
 
-#include "inc/hw_types.h"
-#include "inc/hw_memmap.h"
-#include "driverlib/gpio.h"
-#include "driverlib/sysctl.h"
-#include "utils/ustdlib.h"
-
-#include "stellaris-pins/DigitalIOPin.h"
+#include "OneWireBus.h"
+#include "DeviceTable.h"
+#include "OneWireSearch.h"
+#include "OneWireCRC.h"
+#include "OneWireStats.h"
+#include "Transaction.h"
 
 #include <vector>
 
-// Maximum number of allowed devices during a search. Default is 50. This is to
-// limit the occurance of memory overflow attacks via the bus. 
-//
-// Actually, it's more to limit the Stellaris from freaking out when it 
-// encouters a poorly wired OneWire bus, a bus held low will result in a stream 
-// of 0s pumped to the device table. Keep it something sensible to avoid 
-// blowing the stack
+// Capacity of the device table, which bounds the number of devices a search
+// will record. Default is 50. The table is a fixed size array inside the
+// master, so this is also its memory footprint: 8 bytes per device. Keep it
+// sensible for the RAM at hand; a poorly wired bus can't overrun it.
+#ifndef OW_MAX_NUM_DEVICES
 #define OW_MAX_NUM_DEVICES 50
+#endif // OW_MAX_NUM_DEVICES
 
-// The Dallas Semiconductor example code for OneWire CRC checking provides two
-// methods for computing the CRC of a line of data. This define allows you to
-// select which one you would prefer for your code base. Method 0 uses math to
-// compute the value, leading to slightly smaller code size but slightly longer
-// computation time. Method 1 uses a lookup table, with slightly larger code
-// size but smaller computation time. Set the method you'd like to use in this
-// define here and the other will be omitted.
-#ifndef ONEWIRE_CRC8_CALCULATION_METHOD
-#define ONEWIRE_CRC8_CALCULATION_METHOD	1
-#endif // ONEWIRE_CRC8_CALCULATION_METHOD
-
+// Number of times a search pass is repeated when it comes back with a bad
+// ROM. Only the failed pass is repeated, everything found so far is kept.
+#ifndef OW_SEARCH_RETRIES
+#define OW_SEARCH_RETRIES 3
+#endif // OW_SEARCH_RETRIES
 
-// OneWire bus speed settings
-#define OW_SPEED_OVERDRIVE	0
-#define OW_SPEED_STANDARD	1
 
 // Standard One Wire command codes
 // Used on most OneWire Devices, read the datasheet for more information
@@ -123,65 +112,108 @@
 #define OW_ALARM_SEARCH		0xEC
 #define OW_SKIP_ROM			0xCC
 #define OW_OVERDRIVE_SKIP	0x3C
+#define OW_OVERDRIVE_MATCH	0x69
+#define OW_RESUME			0xA5
 
 
 
 namespace OneWire
 {
 
-	typedef unsigned char BYTE;
-
-
 	/**
 	 * OneWire Master generic operations
 	 */
 	class OneWireMaster
 	{
 	public:
-		OneWireMaster(unsigned int busSpeed);
-		OneWireMaster
-			( unsigned int busSpeed
-			, unsigned long gpioPeriph
-			, unsigned long gpioPort
-			, unsigned char gpioPinmask
-			);
+		OneWireMaster(OneWireBus& bus);
 
 		// Standard bus functions
 		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
 		BYTE ReadByte(void);
 		void WriteByte(BYTE data);
 		int TouchByte(BYTE data);
 		void Block(BYTE* data, int data_len);
+
+		// Same, running a CRC over the bytes read as they come in
+		BYTE ReadByte(BYTE& crc8);
+		BYTE ReadByte(unsigned short& crc16);
+		void Block(BYTE* data, int data_len, BYTE& crc8);
+		void Block(BYTE* data, int data_len, unsigned short& crc16);
 	
 		// Wait timer
 		void WaitUS(unsigned int us);
 
 		// Address search/select functions
 		int Search(void);
-		void MatchROM(std::vector<BYTE> rom);
+		bool SearchComplete(void) const;
+		bool SearchFirst(ROM& rom);
+		bool SearchNext(ROM& rom);
+		SearchResult SearchStep(SearchState& state);
+
+		// Targeted searches, only walking part of the ROM tree
+		int SearchFamily(BYTE family);
+		int AlarmSearch(DeviceTable& alarms);
+		bool AlarmFirst(ROM& rom);
+		bool AlarmNext(ROM& rom);
+		bool FamilyFirst(BYTE family, ROM& rom);
+		bool FamilyNext(ROM& rom);
+
+		// Presence checks of known devices
+		bool Verify(ROM rom);
+		int VerifyAll(DeviceTable& missing, DeviceTable& added);
+		void MatchROM(const std::vector<BYTE>& rom);
+		void MatchROM(ROM rom);
 		void SkipROM(void);
 		int SkipOverdrive(void);
 
+		// Bus speed, OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+		// Run a whole device access, see Transaction
+		TransactionResult Execute(const Transaction& transaction);
+
 		// CRC check functions
-		static BYTE CRC8(BYTE* address, BYTE length);
-		static unsigned short CRC16(unsigned short* data, unsigned short length);
+		static BYTE CRC8(const BYTE* address, BYTE length);
+		static unsigned short CRC16(const BYTE* data, unsigned short length);
+
+		// Copy of the bus statistics, false if OW_STATISTICS is off
+		bool Statistics(OneWireStats& snapshot) const;
+		void ClearStatistics(void);
 
-		// Container for device addresses
-		std::vector<std::vector<BYTE> > devices;
+		// Container for device addresses, filled by Search()
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> devices;
 	private:
-		// Timing values array, populated based on the bus speed setting
-		const int* timing;
+		// Bus transport
+		OneWireBus& bus;
 
-		// GPIO port
-		DigitalIOPin GPIOPin;
+		// Position of Search(), SearchFirst() and SearchNext()
+		SearchState searchState;
 
-		// read/write single bits to the bus
-		void WriteBit(BYTE bit);
-		BYTE ReadBit(void);
+		TransactionResult Perform(const Transaction& transaction);
+
+		// VerifyAll() search of part of the tree for devices not in the table
+		void SearchSubtree(ROM prefix, int length, DeviceTable& added);
+
+#if OW_STATISTICS
+		// Count bytes moved, returns how long their slots should take
+		unsigned long long Traffic(const BYTE* data, int len, bool touch);
+
+		unsigned long long SearchNS(ROM taken);
+
+		// Record an operation started at start, and any overrun of its slots
+		void Measure
+			( StatsOperation operation
+			, unsigned long long start
+			, unsigned long long nominalNS
+			, unsigned int slots
+			);
 
-		// Timing functions/constants
-		static const int standardTime[10];
-		static const int overdriveTime[10];
+		OneWireStats stats;
+#endif // OW_STATISTICS
 
 	};
 
@@ -0,0 +1,174 @@
+/**
+ * @file OneWireSearch.cpp
+ *
+ * ROM search state, last discrepancy method from Maxim Application Note 187
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OneWireSearch.h"
+#include "OneWireMaster.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Mask of the lowest bits bits of a ROM
+	 */
+	static ROM LowMask(int bits)
+	{
+		if (bits <= 0) return 0;
+		if (bits >= 64) return ~(ROM)0;
+		return ((ROM)1 << bits) - 1;
+	}
+
+
+	SearchState::SearchState()
+		: rom(0)
+		, lastDiscrepancy(0)
+		, lastFamilyDiscrepancy(0)
+		, lastDevice(false)
+		, prefixLength(0)
+		, alarm(false)
+		, branches(0)
+	{
+	}
+
+	void SearchState::Begin(bool alarm)
+	{
+		BeginPrefix(0, 0, alarm);
+	}
+
+	/**
+	 * @param[in] prefix Bits every device found has to start with
+	 * @param[in] length Number of bits of prefix to use, 0 to 64
+	 * @param[in] alarm Alarm Search rather than Search ROM
+	 */
+	void SearchState::BeginPrefix(ROM prefix, int length, bool alarm)
+	{
+		rom = prefix & LowMask(length);
+		lastDiscrepancy = 0;
+		lastFamilyDiscrepancy = 0;
+		lastDevice = false;
+		prefixLength = length;
+		this->alarm = alarm;
+		branches = 0;
+	}
+
+	/**
+	 * The family code is the first 8 bits sent, so this fixes those and stops
+	 * as soon as the family runs out instead of walking the rest of the bus.
+	 */
+	void SearchState::BeginFamily(BYTE family, bool alarm)
+	{
+		BeginPrefix(family, 8, alarm);
+	}
+
+	/**
+	 * Resume the search at the last branch point inside the family code, so
+	 * the next device found is of a different family.
+	 */
+	void SearchState::SkipFamily(void)
+	{
+		lastDiscrepancy = lastFamilyDiscrepancy;
+		lastFamilyDiscrepancy = 0;
+
+		if (lastDiscrepancy == 0) lastDevice = true;
+	}
+
+	/**
+	 * Follow the last ROM up to the last discrepancy, take 1 there and 0 at
+	 * every discrepancy after it. Prefix bits are always followed.
+	 */
+	ROM SearchState::Preferred(void) const
+	{
+		int keep = lastDiscrepancy > 0 ? lastDiscrepancy - 1 : 0;
+		if (keep < prefixLength) keep = prefixLength;
+
+		ROM preferred = rom & LowMask(keep);
+		if (lastDiscrepancy > prefixLength) preferred |= (ROM)1 << (lastDiscrepancy - 1);
+
+		return preferred;
+	}
+
+	/**
+	 * Apply the result of a search pass
+	 *
+	 * A pass with bits nobody answered, or a ROM that fails its CRC, is an
+	 * error and leaves the state untouched. A pass that strays from the prefix
+	 * means there is nothing left under it. So does an alarm search nobody
+	 * answers from the first bit: no device is alarming, the usual result of
+	 * polling, and not worth a retry.
+	 */
+	SearchResult SearchState::Finish(ROM taken, ROM discrepancies, ROM errors)
+	{
+		BYTE bytes[8];
+		int lastZero = 0;
+
+		if (alarm && (errors & 0x01))
+		{
+			lastDevice = true;
+			return SEARCH_DONE;
+		}
+
+		if (errors) return SEARCH_ERROR;
+
+		if ((taken ^ rom) & LowMask(prefixLength))
+		{
+			lastDevice = true;
+			return SEARCH_DONE;
+		}
+
+		// An all zero ROM passes the CRC, but is really a bus held low
+		UnpackROM(taken, bytes);
+		if (taken == 0 || OneWireMaster::CRC8(bytes, 8) != 0) return SEARCH_ERROR;
+
+		// Last branch point past the prefix where we went down the 0 side
+		for (int n = 64; n > prefixLength; --n)
+		{
+			ROM mask = (ROM)1 << (n - 1);
+			if ((discrepancies & mask) && !(taken & mask))
+			{
+				lastZero = n;
+				break;
+			}
+		}
+
+		lastFamilyDiscrepancy = 0;
+		for (int n = 8; n > prefixLength; --n)
+		{
+			ROM mask = (ROM)1 << (n - 1);
+			if ((discrepancies & mask) && !(taken & mask))
+			{
+				lastFamilyDiscrepancy = n;
+				break;
+			}
+		}
+
+		rom = taken;
+		branches = discrepancies;
+		lastDiscrepancy = lastZero;
+		if (lastDiscrepancy == 0) lastDevice = true;
+
+		return SEARCH_FOUND;
+	}
+
+} // Namespace OneWire
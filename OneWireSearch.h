@@ -0,0 +1,101 @@
+/**
+ * @file OneWireSearch.h
+ *
+ * SearchState prototype. Holds the position of a ROM search between passes,
+ * following the last discrepancy method of Maxim Application Note 187. The
+ * state is a handful of integers no matter how many devices are on the bus.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SEARCH_H
+#define STELLARIS_ONEWIRE_SEARCH_H
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Outcome of a search pass
+	 */
+	enum SearchResult
+	{
+		SEARCH_DONE,	// No more devices
+		SEARCH_FOUND,	// Found a device, it is in SearchState::rom
+		SEARCH_ERROR	// Pass failed, the state is as it was before it
+	};
+
+
+	/**
+	 * Position of a ROM search
+	 *
+	 * Every pass walks one path of the ROM tree. Preferred() gives the path to
+	 * try next, Finish() takes what the bus answered and moves the state on, or
+	 * leaves it alone if the answer was not a valid ROM so the same pass can be
+	 * run again.
+	 */
+	struct SearchState
+	{
+		SearchState();
+
+		// Start over, from the first device on the bus. With alarm set only
+		// devices with an active alarm condition take part.
+		void Begin(bool alarm = false);
+
+		// Start over, only walking devices whose first length bits match
+		// prefix. Used for family and single device searches.
+		void BeginPrefix(ROM prefix, int length, bool alarm = false);
+
+		// Start over, only walking devices of one family
+		void BeginFamily(BYTE family, bool alarm = false);
+
+		// Jump past the rest of the family of the last device found
+		void SkipFamily(void);
+
+		// Directions to take at discrepancies on the next pass
+		ROM Preferred(void) const;
+
+		// Apply the result of a pass, see OneWireBus::SearchPass()
+		SearchResult Finish(ROM taken, ROM discrepancies, ROM errors);
+
+		// Last ROM found
+		ROM rom;
+
+		// Bit number (1-64) of the last branch where 0 was taken, 0 for none
+		int lastDiscrepancy;
+		int lastFamilyDiscrepancy;
+
+		// Set once the last device has been found
+		bool lastDevice;
+
+		// Number of leading bits of rom every pass is forced to follow
+		int prefixLength;
+
+		// Alarm Search rather than Search ROM
+		bool alarm;
+
+		// Discrepancies seen on the last successful pass
+		ROM branches;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SEARCH_H
@@ -0,0 +1,74 @@
+/**
+ * @file OneWireStats.cpp
+ *
+ * OneWireStats implementation
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OneWireStats.h"
+
+
+namespace OneWire
+{
+
+	OneWireStats::OneWireStats(void)
+	{
+		Clear();
+	}
+
+	void OneWireStats::Clear(void)
+	{
+		resets = 0;
+		presenceFailures = 0;
+		bytesOut = 0;
+		bytesIn = 0;
+		crcFailures = 0;
+		searchPasses = 0;
+		searchRestarts = 0;
+		worstMeanOverrunNS = 0;
+
+		for (int i = 0; i < STATS_OPERATIONS; ++i)
+		{
+			operations[i].count = 0;
+			operations[i].totalNS = 0;
+			operations[i].maxNS = 0;
+			for (int n = 0; n < OW_STATS_BUCKETS; ++n) operations[i].histogram[n] = 0;
+		}
+	}
+
+	void OneWireStats::Record(StatsOperation operation, unsigned long long ns)
+	{
+		OperationStats& op = operations[operation];
+		unsigned long long us = ns / 1000;
+		int bucket = 0;
+
+		++op.count;
+		op.totalNS += ns;
+		if (ns > op.maxNS) op.maxNS = ns;
+
+		while (us && bucket < OW_STATS_BUCKETS - 1)
+		{
+			us >>= 1;
+			++bucket;
+		}
+		++op.histogram[bucket];
+	}
+
+} // Namespace OneWire
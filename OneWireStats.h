@@ -0,0 +1,118 @@
+/**
+ * @file OneWireStats.h
+ *
+ * OneWireStats structure. Counters and timing histograms kept by
+ * OneWireMaster for every bus operation, to see how a bus behaves in the
+ * field: a cable run going bad shows up as presence failures, CRC failures
+ * and search restarts climbing, and slots running long, well before sensors
+ * stop answering.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_STATS_H
+#define STELLARIS_ONEWIRE_STATS_H
+
+
+#include "OneWireBus.h"
+
+
+// Set to 1 to have OneWireMaster keep statistics. At 0 none of the counting
+// is compiled in and OneWireMaster::Statistics() always returns false.
+#ifndef OW_STATISTICS
+#define OW_STATISTICS 0
+#endif // OW_STATISTICS
+
+// Histogram buckets per operation. Bucket n counts operations that took
+// under 2^n microseconds and at least 2^(n-1), the last one everything
+// longer.
+#ifndef OW_STATS_BUCKETS
+#define OW_STATS_BUCKETS 16
+#endif // OW_STATS_BUCKETS
+
+
+namespace OneWire
+{
+
+	// Operations timed by OneWireStats. Times nest, a search pass includes
+	// its reset and a transaction its reset and bytes.
+	enum StatsOperation
+	{
+		STATS_RESET = 0,
+		STATS_BIT,
+		STATS_BYTE,
+		STATS_BLOCK,
+		STATS_SEARCH,
+		STATS_TRANSACTION,
+		STATS_OPERATIONS
+	};
+
+	/**
+	 * Timing of one kind of operation
+	 */
+	struct OperationStats
+	{
+		unsigned long count;
+		unsigned long long totalNS;
+		unsigned long long maxNS;
+		unsigned long histogram[OW_STATS_BUCKETS];
+	};
+
+	/**
+	 * Bus statistics
+	 *
+	 * Times come from the transport's NowNS(), they stay 0 on transports
+	 * without a clock while the counters still work. GPIOBus is one of
+	 * those; DeadlineBus, or SimulatedBus on a host, gives real times.
+	 */
+	struct OneWireStats
+	{
+		OneWireStats(void);
+
+		// Resets, and those nothing answered
+		unsigned long resets;
+		unsigned long presenceFailures;
+
+		// Bytes written and read
+		unsigned long bytesOut;
+		unsigned long bytesIn;
+
+		// Transactions and search passes that failed their CRC
+		unsigned long crcFailures;
+
+		// Search passes run, and those that had to be run again
+		unsigned long searchPasses;
+		unsigned long searchRestarts;
+
+		// Worst average overrun: how far an operation ran past its timing
+		// table duration, divided by its slots. Only one slot operations give
+		// a single slot's overrun, a block that is late in one slot shows up
+		// spread over all of them.
+		unsigned long long worstMeanOverrunNS;
+
+		OperationStats operations[STATS_OPERATIONS];
+
+		void Clear(void);
+
+		// Add one operation that took ns
+		void Record(StatsOperation operation, unsigned long long ns);
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_STATS_H
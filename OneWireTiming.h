@@ -0,0 +1,122 @@
+/**
+ * @file OneWireTiming.h
+ *
+ * OneWire slot timings shared by the transports. Values are the datasheet
+ * recommended ones from Maxim Application Note 126, in nanoseconds so the
+ * fractional overdrive timings survive. The delay loop tables derived from
+ * them are worked out at compile time for a given CPU clock.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_TIMING_H
+#define STELLARIS_ONEWIRE_TIMING_H
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	// Index into the timing tables, lettered as in Application Note 126
+	enum TimingIndex
+	{
+		OW_TIME_A = 0,	// Write 1 / read low time
+		OW_TIME_B,		// Write 1 recovery
+		OW_TIME_C,		// Write 0 low time
+		OW_TIME_D,		// Write 0 recovery
+		OW_TIME_E,		// Read release to sample
+		OW_TIME_F,		// Read sample to end of slot
+		OW_TIME_G,		// Delay before reset
+		OW_TIME_H,		// Reset low time
+		OW_TIME_I,		// Reset release to presence sample
+		OW_TIME_J,		// Presence sample to end of reset
+		OW_TIME_COUNT
+	};
+
+	// Standard speed slot timings in nanoseconds
+	constexpr unsigned long StandardTimingNS[OW_TIME_COUNT] =
+		{6000, 64000, 60000, 10000, 9000, 55000, 0, 480000, 70000, 410000};
+
+	// Overdrive speed slot timings in nanoseconds. A and E are 1us, the
+	// values AN126 recommends; earlier versions of this library used 1.5us
+	// and 0.75us, which put the read sample later in the slot.
+	constexpr unsigned long OverdriveTimingNS[OW_TIME_COUNT] =
+		{1000, 7500, 7500, 2500, 1000, 7000, 2500, 70000, 8500, 40000};
+
+	/**
+	 * Nanosecond timing table for a bus speed
+	 */
+	inline const unsigned long* TimingNS(unsigned int busSpeed)
+	{
+		return busSpeed == OW_SPEED_OVERDRIVE ? OverdriveTimingNS : StandardTimingNS;
+	}
+
+	/**
+	 * Number of SysCtlDelay loops, 3 cycles each, covering ns nanoseconds at
+	 * clockHz. Rounds up, so a delay is never shorter than asked for.
+	 */
+	constexpr unsigned long DelayLoops(unsigned long long ns, unsigned long clockHz)
+	{
+		return (unsigned long)((ns * clockHz + 2999999999ULL) / 3000000000ULL);
+	}
+
+	/**
+	 * Delay loop counts for every slot timing at one clock and bus speed
+	 *
+	 * Everything here is a compile-time constant, so a transport indexing into
+	 * value[] does no timing arithmetic at all while generating slots.
+	 */
+	template <unsigned long ClockHz, unsigned int Speed>
+	struct DelayTable
+	{
+		static constexpr unsigned long NS(int index)
+		{
+			return Speed == OW_SPEED_OVERDRIVE
+				? OverdriveTimingNS[index]
+				: StandardTimingNS[index];
+		}
+
+		static constexpr unsigned long value[OW_TIME_COUNT] =
+			{ DelayLoops(NS(OW_TIME_A), ClockHz)
+			, DelayLoops(NS(OW_TIME_B), ClockHz)
+			, DelayLoops(NS(OW_TIME_C), ClockHz)
+			, DelayLoops(NS(OW_TIME_D), ClockHz)
+			, DelayLoops(NS(OW_TIME_E), ClockHz)
+			, DelayLoops(NS(OW_TIME_F), ClockHz)
+			, DelayLoops(NS(OW_TIME_G), ClockHz)
+			, DelayLoops(NS(OW_TIME_H), ClockHz)
+			, DelayLoops(NS(OW_TIME_I), ClockHz)
+			, DelayLoops(NS(OW_TIME_J), ClockHz)
+			};
+
+		// Overdrive write 1/read low time must stay under 2us, anything that
+		// can't resolve that is no use for overdrive
+		static_assert(Speed != OW_SPEED_OVERDRIVE
+			|| DelayLoops(OverdriveTimingNS[OW_TIME_A], ClockHz) * 3000000000ULL
+				< 2ULL * ClockHz * 1000,
+			"CPU clock too slow for overdrive slot timing");
+	};
+
+	template <unsigned long ClockHz, unsigned int Speed>
+	constexpr unsigned long DelayTable<ClockHz, Speed>::value[OW_TIME_COUNT];
+
+}
+#endif // STELLARIS_ONEWIRE_TIMING_H
@@ -0,0 +1,175 @@
+/**
+ * @file PosixSerialPort.cpp
+ *
+ * PosixSerialPort implementation.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PosixSerialPort.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+
+namespace OneWire
+{
+
+	/**
+	 * termios constant for a line rate, B0 if there isn't one
+	 */
+	static speed_t BaudConstant(unsigned long baud)
+	{
+		switch (baud)
+		{
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+		default: return B0;
+		}
+	}
+
+	PosixSerialPort::PosixSerialPort(void)
+		: timeoutMS(OW_SERIAL_TIMEOUT_MS)
+		, fd(-1)
+	{
+	}
+
+	PosixSerialPort::~PosixSerialPort()
+	{
+		Close();
+	}
+
+	/**
+	 * Open a tty in raw mode
+	 *
+	 * @param[in] path Device path, such as /dev/ttyUSB0
+	 * @param[in] baud Line rate in bits per second
+	 */
+	bool PosixSerialPort::Open(const char* path, unsigned long baud)
+	{
+		Close();
+
+		fd = open(path, O_RDWR | O_NOCTTY);
+		if (fd < 0) return false;
+
+		struct termios tio;
+		if (tcgetattr(fd, &tio) != 0)
+		{
+			Close();
+			return false;
+		}
+
+		cfmakeraw(&tio);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tio);
+
+		SetBaud(baud);
+		Flush();
+		return true;
+	}
+
+	void PosixSerialPort::Close(void)
+	{
+		if (fd >= 0) close(fd);
+		fd = -1;
+	}
+
+	bool PosixSerialPort::IsOpen(void) const
+	{
+		return fd >= 0;
+	}
+
+	void PosixSerialPort::Write(const BYTE* data, int len)
+	{
+		while (len > 0 && fd >= 0)
+		{
+			ssize_t written = write(fd, data, len);
+			if (written < 0) return;
+
+			data += written;
+			len -= written;
+		}
+	}
+
+	/**
+	 * Read exactly len bytes. The timeout runs from the last byte received,
+	 * so long blocks at slow rates don't time out part way through.
+	 */
+	bool PosixSerialPort::Read(BYTE* data, int len)
+	{
+		while (len > 0)
+		{
+			if (fd < 0) return false;
+
+			struct pollfd pfd = { fd, POLLIN, 0 };
+			if (poll(&pfd, 1, timeoutMS) <= 0) return false;
+
+			ssize_t got = read(fd, data, len);
+			if (got <= 0) return false;
+
+			data += got;
+			len -= got;
+		}
+
+		return true;
+	}
+
+	void PosixSerialPort::Flush(void)
+	{
+		if (fd >= 0) tcflush(fd, TCIFLUSH);
+	}
+
+	void PosixSerialPort::Break(void)
+	{
+		if (fd >= 0) tcsendbreak(fd, 0);
+	}
+
+	void PosixSerialPort::SetBaud(unsigned long baud)
+	{
+		speed_t speed = BaudConstant(baud);
+		struct termios tio;
+
+		if (fd < 0 || speed == B0 || tcgetattr(fd, &tio) != 0) return;
+
+		// Let anything queued at the old rate go out first
+		tcdrain(fd);
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+	void PosixSerialPort::DelayUS(unsigned int us)
+	{
+		struct timespec ts;
+
+		ts.tv_sec = us / 1000000;
+		ts.tv_nsec = (us % 1000000) * 1000L;
+		nanosleep(&ts, 0);
+	}
+
+} // Namespace OneWire
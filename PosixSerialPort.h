@@ -0,0 +1,73 @@
+/**
+ * @file PosixSerialPort.h
+ *
+ * PosixSerialPort class prototype. SerialPort on a Linux tty device through
+ * termios, for running the bridge transports on a host machine against real
+ * hardware on a USB serial adapter or against an emulator's pty.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_POSIXSERIALPORT_H
+#define STELLARIS_ONEWIRE_POSIXSERIALPORT_H
+
+
+#include "SerialPort.h"
+
+
+// How long Read() waits for the bytes asked for, in milliseconds
+#ifndef OW_SERIAL_TIMEOUT_MS
+#define OW_SERIAL_TIMEOUT_MS	500
+#endif // OW_SERIAL_TIMEOUT_MS
+
+
+namespace OneWire
+{
+
+	/**
+	 * SerialPort on a POSIX tty, raw 8N1
+	 */
+	class PosixSerialPort : public SerialPort
+	{
+	public:
+		PosixSerialPort(void);
+		~PosixSerialPort();
+
+		// Open the device at the given rate, returns false if it can't be
+		bool Open(const char* path, unsigned long baud = 9600);
+		void Close(void);
+		bool IsOpen(void) const;
+
+		// SerialPort interface
+		void Write(const BYTE* data, int len);
+		bool Read(BYTE* data, int len);
+		void Flush(void);
+		void Break(void);
+		void SetBaud(unsigned long baud);
+		void DelayUS(unsigned int us);
+
+		// Read() timeout in milliseconds
+		int timeoutMS;
+
+	private:
+		int fd;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_POSIXSERIALPORT_H
@@ -0,0 +1,69 @@
+/**
+ * @file SerialPort.h
+ *
+ * SerialPort interface. The byte stream a UART attached OneWire line driver,
+ * such as the DS2480B, is talked to through. Implemented on top of a Linux
+ * tty by PosixSerialPort, or on a Stellaris UART by the application.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SERIALPORT_H
+#define STELLARIS_ONEWIRE_SERIALPORT_H
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Serial byte stream
+	 *
+	 * Only Write() and Read() are required, the rest default to doing nothing
+	 * for ports that can't do them.
+	 */
+	class SerialPort
+	{
+	public:
+		virtual ~SerialPort() {}
+
+		// Queue len bytes for sending
+		virtual void Write(const BYTE* data, int len) = 0;
+
+		// Read exactly len bytes, returns false if they didn't all arrive
+		// before the port's timeout
+		virtual bool Read(BYTE* data, int len) = 0;
+
+		// Throw away anything received and not read yet
+		virtual void Flush(void) {}
+
+		// Hold the line in a break condition
+		virtual void Break(void) {}
+
+		// Change the line rate, in bits per second
+		virtual void SetBaud(unsigned long) {}
+
+		// Wait for a number of microseconds
+		virtual void DelayUS(unsigned int) {}
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SERIALPORT_H
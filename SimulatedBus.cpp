@@ -0,0 +1,647 @@
+/**
+ * @file SimulatedBus.cpp
+ *
+ * Host-side simulated OneWire bus and virtual slave devices
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SimulatedBus.h"
+#include "OneWireMaster.h"
+
+#include <algorithm>
+
+
+namespace OneWire
+{
+
+	/**
+	 * SimulatedDevice constructor, for a device with an empty scratchpad
+	 *
+	 * @param[in] rom ROM ID, 8 bytes with the family code first
+	 */
+	SimulatedDevice::SimulatedDevice(const BYTE* rom)
+		: presenceDelayUS(30)
+		, presenceLengthUS(120)
+		, overdriveCapable(false)
+		, alarm(false)
+		, coupler(0)
+		, couplerLine(0)
+		, command(0)
+		, bus(0)
+		, state(STATE_IDLE)
+		, overdrive(false)
+		, overdriveMatch(false)
+		, resumeFlag(false)
+		, rxByte(0)
+		, rxBits(0)
+		, matchIndex(0)
+		, txBit(0)
+		, searchBit(0)
+		, searchPhase(0)
+		, writeIndex(0)
+	{
+		std::copy(rom, rom + 8, this->rom);
+	}
+
+	/**
+	 * SimulatedDevice constructor
+	 *
+	 * @param[in] rom ROM ID, 8 bytes with the family code first
+	 * @param[in] scratchpad Initial scratchpad contents
+	 * @param[in] scratchpadLen Length of the scratchpad in bytes
+	 */
+	SimulatedDevice::SimulatedDevice
+		( const BYTE* rom
+		, const BYTE* scratchpad
+		, int scratchpadLen
+		)
+		: scratchpad(scratchpad, scratchpad + scratchpadLen)
+		, presenceDelayUS(30)
+		, presenceLengthUS(120)
+		, overdriveCapable(false)
+		, alarm(false)
+		, coupler(0)
+		, couplerLine(0)
+		, command(0)
+		, bus(0)
+		, state(STATE_IDLE)
+		, overdrive(false)
+		, overdriveMatch(false)
+		, resumeFlag(false)
+		, rxByte(0)
+		, rxBits(0)
+		, matchIndex(0)
+		, txBit(0)
+		, searchBit(0)
+		, searchPhase(0)
+		, writeIndex(0)
+	{
+		std::copy(rom, rom + 8, this->rom);
+	}
+
+	SimulatedDevice::~SimulatedDevice()
+	{
+		if (bus) bus->Detach(*this);
+	}
+
+	/**
+	 * Whether the device sees slots generated at the given bus speed. A device
+	 * in overdrive mode ignores standard speed slots and vice versa, and one
+	 * behind a coupler output that is off sees nothing.
+	 */
+	bool SimulatedDevice::Participates(unsigned int busSpeed) const
+	{
+		return Connected() && overdrive == (busSpeed == OW_SPEED_OVERDRIVE);
+	}
+
+	bool SimulatedDevice::Connected(void) const
+	{
+		return !coupler || (coupler->Connected() && coupler->LineOn(couplerLine));
+	}
+
+	/**
+	 * Whether the device is holding the bus low for its presence pulse at the
+	 * given time after the end of the reset pulse.
+	 */
+	bool SimulatedDevice::Presence(unsigned long long sampleNS) const
+	{
+		unsigned long long delay = presenceDelayUS * 1000ULL;
+		unsigned long long length = presenceLengthUS * 1000ULL;
+
+		if (overdrive)
+		{
+			delay /= 8;
+			length /= 8;
+		}
+
+		return sampleNS >= delay && sampleNS < delay + length;
+	}
+
+	/**
+	 * Reset pulse seen on the bus. A standard speed reset knocks overdrive
+	 * devices back to standard speed.
+	 */
+	void SimulatedDevice::BusReset(unsigned int busSpeed)
+	{
+		if (busSpeed == OW_SPEED_STANDARD) overdrive = false;
+
+		state = STATE_ROM_COMMAND;
+		command = 0;
+		rxByte = 0;
+		rxBits = 0;
+		tx.clear();
+		txBit = 0;
+	}
+
+	/**
+	 * Level the device drives during the current slot, 0 to pull the bus low or
+	 * 1 to leave it released.
+	 */
+	BYTE SimulatedDevice::Drive(void)
+	{
+		switch (state)
+		{
+		case STATE_SEARCH:
+			if (searchPhase == 2) return 1;
+			{
+				BYTE bit = (rom[searchBit / 8] >> (searchBit % 8)) & 0x01;
+				return searchPhase == 0 ? bit : bit ^ 0x01;
+			}
+		case STATE_FUNCTION:
+			if (txBit < tx.size() * 8)
+				return (tx[txBit / 8] >> (txBit % 8)) & 0x01;
+			return FunctionDrive();
+		default:
+			return 1;
+		}
+	}
+
+	/**
+	 * Level the bus settled at during the current slot
+	 */
+	void SimulatedDevice::Sample(BYTE level)
+	{
+		if (state == STATE_IDLE) return;
+
+		if (state == STATE_SEARCH)
+		{
+			if (searchPhase < 2)
+			{
+				++searchPhase;
+				return;
+			}
+
+			// Master wrote the direction, drop out if it isn't our bit
+			BYTE bit = (rom[searchBit / 8] >> (searchBit % 8)) & 0x01;
+			if (level != bit)
+			{
+				Deselect();
+				return;
+			}
+
+			searchPhase = 0;
+			if (++searchBit == 64)
+			{
+				resumeFlag = true;
+				Select();
+			}
+			return;
+		}
+
+		if (state == STATE_FUNCTION && txBit < tx.size() * 8)
+		{
+			// Slot was one of ours, move on to the next bit
+			if (++txBit == tx.size() * 8)
+			{
+				tx.clear();
+				txBit = 0;
+			}
+			return;
+		}
+
+		// Receiving, LSB first
+		rxByte = (rxByte >> 1) | (level ? 0x80 : 0x00);
+		if (++rxBits < 8) return;
+
+		BYTE data = rxByte;
+		rxByte = 0;
+		rxBits = 0;
+
+		switch (state)
+		{
+		case STATE_ROM_COMMAND:
+			ROMCommand(data);
+			break;
+		case STATE_MATCH:
+			if (data != rom[matchIndex])
+			{
+				// Only a successful Overdrive Match leaves a device in
+				// overdrive
+				if (overdriveMatch) overdrive = false;
+				Deselect();
+			}
+			else if (++matchIndex == 8)
+			{
+				resumeFlag = true;
+				Select();
+			}
+			break;
+		case STATE_FUNCTION:
+			if (command == 0)
+			{
+				command = data;
+				FunctionCommand(data);
+			}
+			else
+			{
+				FunctionData(data);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	/**
+	 * Handle a ROM layer command byte
+	 */
+	void SimulatedDevice::ROMCommand(BYTE data)
+	{
+		switch (data)
+		{
+		case OW_READ_ROM:
+			resumeFlag = false;
+			Select();
+			Transmit(rom, 8);
+			break;
+		case OW_MATCH_ROM:
+			resumeFlag = false;
+			overdriveMatch = false;
+			matchIndex = 0;
+			state = STATE_MATCH;
+			break;
+		case OW_SKIP_ROM:
+			resumeFlag = false;
+			Select();
+			break;
+		case OW_SEARCH_ROM:
+		case OW_ALARM_SEARCH:
+			resumeFlag = false;
+			if (data == OW_ALARM_SEARCH && !alarm)
+			{
+				Deselect();
+				break;
+			}
+			searchBit = 0;
+			searchPhase = 0;
+			state = STATE_SEARCH;
+			break;
+		case OW_RESUME:
+			if (resumeFlag) Select();
+			else Deselect();
+			break;
+		case OW_OVERDRIVE_SKIP:
+			resumeFlag = false;
+			if (!overdriveCapable)
+			{
+				Deselect();
+				break;
+			}
+			overdrive = true;
+			Select();
+			break;
+		case OW_OVERDRIVE_MATCH:
+			resumeFlag = false;
+			if (!overdriveCapable)
+			{
+				Deselect();
+				break;
+			}
+			overdrive = true;
+			overdriveMatch = true;
+			matchIndex = 0;
+			state = STATE_MATCH;
+			break;
+		default:
+			Deselect();
+			break;
+		}
+	}
+
+	/**
+	 * Enter the function layer
+	 */
+	void SimulatedDevice::Select(void)
+	{
+		state = STATE_FUNCTION;
+		command = 0;
+		writeIndex = 0;
+	}
+
+	void SimulatedDevice::Deselect(void)
+	{
+		state = STATE_IDLE;
+		tx.clear();
+		txBit = 0;
+	}
+
+	/**
+	 * Function command received. The generic device only knows how to read and
+	 * write its scratchpad, anything else takes it off the bus.
+	 */
+	void SimulatedDevice::FunctionCommand(BYTE command)
+	{
+		switch (command)
+		{
+		case 0xBE:	// Read Scratchpad
+			if (!scratchpad.empty()) Transmit(&scratchpad[0], scratchpad.size());
+			break;
+		case 0x4E:	// Write Scratchpad
+			writeIndex = 0;
+			break;
+		default:
+			Deselect();
+			break;
+		}
+	}
+
+	/**
+	 * Data byte received after the function command
+	 */
+	void SimulatedDevice::FunctionData(BYTE data)
+	{
+		if (command == 0x4E && writeIndex < scratchpad.size())
+			scratchpad[writeIndex++] = data;
+	}
+
+	/**
+	 * Level driven on read slots while selected and not transmitting
+	 */
+	BYTE SimulatedDevice::FunctionDrive(void)
+	{
+		return 1;
+	}
+
+	/**
+	 * Only couplers have outputs
+	 */
+	bool SimulatedDevice::LineOn(BYTE) const
+	{
+		return false;
+	}
+
+	void SimulatedDevice::Transmit(const BYTE* data, int len)
+	{
+		tx.insert(tx.end(), data, data + len);
+	}
+
+	unsigned long long SimulatedDevice::Now(void) const
+	{
+		return bus ? bus->Now() : 0;
+	}
+
+
+	/**
+	 * SimulatedBus constructor
+	 *
+	 * @param[in] busSpeed Initial bus speed, OW_SPEED_OVERDRIVE or
+	 * OW_SPEED_STANDARD
+	 */
+	SimulatedBus::SimulatedBus(unsigned int busSpeed)
+		: resetCount(0)
+		, slotCount(0)
+		, now(0)
+		, corrupt(false)
+		, corruptSlot(0)
+		, lineLow(false)
+		, lineEvent(LINE_NONE)
+		, lineLowStart(0)
+		, lineRelease(0)
+		, lineSlotLevel(1)
+	{
+		SetSpeed(busSpeed);
+	}
+
+	/**
+	 * Attach a virtual device to the bus. The device is not owned by the bus.
+	 */
+	void SimulatedBus::Attach(SimulatedDevice& device)
+	{
+		if (device.bus == this) return;
+		if (device.bus) device.bus->Detach(device);
+
+		device.bus = this;
+		device.Deselect();
+		devices.push_back(&device);
+	}
+
+	void SimulatedBus::Detach(SimulatedDevice& device)
+	{
+		std::vector<SimulatedDevice*>::iterator it =
+			std::find(devices.begin(), devices.end(), &device);
+
+		if (it == devices.end()) return;
+
+		devices.erase(it);
+		device.bus = 0;
+	}
+
+	unsigned int SimulatedBus::DeviceCount(void) const
+	{
+		return devices.size();
+	}
+
+	void SimulatedBus::SetSpeed(unsigned int busSpeed)
+	{
+		speed = busSpeed == OW_SPEED_OVERDRIVE ? OW_SPEED_OVERDRIVE : OW_SPEED_STANDARD;
+		timing = TimingNS(speed);
+	}
+
+	unsigned int SimulatedBus::GetSpeed(void) const
+	{
+		return speed;
+	}
+
+	/**
+	 * Reset pulse and presence detect, following the same timing as GPIOBus
+	 */
+	int SimulatedBus::Reset(void)
+	{
+		int presence;
+
+		now += timing[OW_TIME_G] + timing[OW_TIME_H];
+		presence = ResetDevices(timing[OW_TIME_I]);
+		now += timing[OW_TIME_I] + timing[OW_TIME_J];
+
+		return presence;
+	}
+
+	int SimulatedBus::ResetDevices(unsigned long long sampleNS)
+	{
+		int presence = 0;
+
+		for (unsigned int i = 0; i < devices.size(); ++i)
+		{
+			if (!devices[i]->Connected()) continue;
+
+			// Overdrive resets are too short for standard speed devices
+			if (speed == OW_SPEED_OVERDRIVE && !devices[i]->Participates(speed))
+				continue;
+
+			devices[i]->BusReset(speed);
+			if (devices[i]->Presence(sampleNS)) presence = 1;
+		}
+
+		++resetCount;
+		return presence;
+	}
+
+	/**
+	 * Master pulls the line low
+	 */
+	void SimulatedBus::LineLow(void)
+	{
+		if (lineLow) return;
+
+		lineLow = true;
+		lineLowStart = now;
+	}
+
+	/**
+	 * Master releases the line. A low pulse of at least half the reset time is
+	 * a reset, one held past the slave sampling point is a write 0, anything
+	 * shorter is a write 1 or read slot.
+	 */
+	void SimulatedBus::LineRelease(void)
+	{
+		if (!lineLow) return;
+
+		unsigned long long low = now - lineLowStart;
+		unsigned long long samplePoint = speed == OW_SPEED_OVERDRIVE ? 2000 : 15000;
+
+		lineLow = false;
+		lineRelease = now;
+
+		if (low >= timing[OW_TIME_H] / 2)
+		{
+			// Presence is resolved on every LineLevel() call
+			ResetDevices(0);
+			lineEvent = LINE_RESET;
+		}
+		else
+		{
+			lineSlotLevel = Slot(low >= samplePoint ? 0 : 1);
+			lineEvent = LINE_SLOT;
+		}
+	}
+
+	/**
+	 * Level on the line right now. Devices answering a read slot hold the line
+	 * low for twice the sampling point from the start of the slot, presence
+	 * pulses follow the device presence timing.
+	 */
+	BYTE SimulatedBus::LineLevel(void) const
+	{
+		if (lineLow) return 0;
+
+		unsigned long long since = now - lineRelease;
+
+		if (lineEvent == LINE_RESET)
+		{
+			for (unsigned int i = 0; i < devices.size(); ++i)
+			{
+				if (devices[i]->Participates(speed) && devices[i]->Presence(since))
+					return 0;
+			}
+		}
+		else if (lineEvent == LINE_SLOT)
+		{
+			unsigned long long hold = speed == OW_SPEED_OVERDRIVE ? 4000 : 30000;
+			if (now - lineLowStart < hold) return lineSlotLevel;
+		}
+
+		return 1;
+	}
+
+	void SimulatedBus::WriteBit(BYTE bit)
+	{
+		bit &= 0x01;
+		Slot(bit);
+		now += bit ? timing[OW_TIME_A] + timing[OW_TIME_B] : timing[OW_TIME_C] + timing[OW_TIME_D];
+	}
+
+	BYTE SimulatedBus::ReadBit(void)
+	{
+		BYTE result = Slot(1);
+		now += timing[OW_TIME_A] + timing[OW_TIME_E] + timing[OW_TIME_F];
+		return result;
+	}
+
+	void SimulatedBus::WaitUS(unsigned int us)
+	{
+		now += us * 1000ULL;
+	}
+
+	unsigned long long SimulatedBus::Now(void) const
+	{
+		return now;
+	}
+
+	unsigned long long SimulatedBus::NowNS(void) const
+	{
+		return now;
+	}
+
+	/**
+	 * Let virtual time pass without any bus activity
+	 */
+	void SimulatedBus::Advance(unsigned long long ns)
+	{
+		now += ns;
+	}
+
+	void SimulatedBus::ClearCounters(void)
+	{
+		resetCount = 0;
+		slotCount = 0;
+	}
+
+	void SimulatedBus::CorruptSlot(unsigned long slot)
+	{
+		corrupt = true;
+		corruptSlot = slot;
+	}
+
+	/**
+	 * Wired-AND of the master and every device listening at the current speed.
+	 * Every device first decides what to drive, then all of them see the
+	 * resulting level.
+	 */
+	BYTE SimulatedBus::Slot(BYTE bit)
+	{
+		BYTE level = bit;
+		unsigned int count = devices.size();
+
+		// Participation has to be decided before anyone samples, as a device
+		// may change speed on the last bit of an overdrive command
+		active.resize(count);
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			active[i] = devices[i]->Participates(speed);
+			if (active[i]) level &= devices[i]->Drive();
+		}
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (active[i]) devices[i]->Sample(level);
+		}
+
+		if (corrupt && slotCount == corruptSlot)
+		{
+			corrupt = false;
+			level ^= 0x01;
+		}
+
+		++slotCount;
+		return level;
+	}
+
+} // Namespace OneWire
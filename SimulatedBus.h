@@ -0,0 +1,230 @@
+/**
+ * @file SimulatedBus.h
+ *
+ * SimulatedBus and SimulatedDevice class prototypes. A host-side OneWire bus
+ * populated with virtual slave devices, used to run and time the library off
+ * of the target. Bus time is virtual and advances by the datasheet duration
+ * of every slot, so operations can be measured in bus time rather than in
+ * host CPU time.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDBUS_H
+#define STELLARIS_ONEWIRE_SIMULATEDBUS_H
+
+
+#include "OneWireBus.h"
+#include "OneWireTiming.h"
+
+#include <vector>
+
+
+namespace OneWire
+{
+
+	class SimulatedBus;
+
+
+	/**
+	 * Virtual OneWire slave device
+	 *
+	 * Implements the ROM layer common to all OneWire slaves (Read ROM, Match ROM,
+	 * Skip ROM, Search ROM, Alarm Search, Resume, Overdrive Skip and Overdrive
+	 * Match) and a plain scratchpad accessed with Write Scratchpad (0x4E) and
+	 * Read Scratchpad (0xBE). Device models derive from this and override the function layer.
+	 */
+	class SimulatedDevice
+	{
+	public:
+		SimulatedDevice(const BYTE* rom);
+		SimulatedDevice(const BYTE* rom, const BYTE* scratchpad, int scratchpadLen);
+		virtual ~SimulatedDevice();
+
+		// ROM ID, family code first, in the order it is sent on the wire
+		BYTE rom[8];
+
+		// Scratchpad contents
+		std::vector<BYTE> scratchpad;
+
+		// Presence pulse timing at standard speed, in microseconds. Overdrive
+		// timings are these divided by 8.
+		unsigned int presenceDelayUS;
+		unsigned int presenceLengthUS;
+
+		// Set if the device accepts Overdrive Skip/Match
+		bool overdriveCapable;
+
+		// Set if the device answers Alarm Search
+		bool alarm;
+
+		// Coupler output the device hangs off, 0 for the trunk. Set through
+		// SimulatedCoupler::Connect().
+		SimulatedDevice* coupler;
+		BYTE couplerLine;
+
+		// Whether the bus reaches the device, through any couplers
+		bool Connected(void) const;
+
+		// Bus side, driven by SimulatedBus
+		bool Participates(unsigned int busSpeed) const;
+		bool Presence(unsigned long long sampleNS) const;
+		virtual void BusReset(unsigned int busSpeed);
+		BYTE Drive(void);
+		void Sample(BYTE level);
+
+	protected:
+		// Function layer, only called once the device has been selected
+		virtual void FunctionCommand(BYTE command);
+		virtual void FunctionData(BYTE data);
+		virtual BYTE FunctionDrive(void);
+
+		// Whether one of the device's coupler outputs is switched on
+		virtual bool LineOn(BYTE line) const;
+
+		// Queue bytes to be sent on the following read slots
+		void Transmit(const BYTE* data, int len);
+
+		// Drop off the bus until the next reset
+		void Deselect(void);
+
+		// Virtual bus time in nanoseconds
+		unsigned long long Now(void) const;
+
+		// Current function command, 0 until one has been received
+		BYTE command;
+
+		// Bus the device is attached to, 0 if detached
+		SimulatedBus* bus;
+
+	private:
+		friend class SimulatedBus;
+
+		enum State
+		{
+			STATE_IDLE,		// Deselected, waiting for a reset
+			STATE_ROM_COMMAND,	// Receiving a ROM command
+			STATE_MATCH,		// Receiving a ROM for Match ROM
+			STATE_SEARCH,		// Taking part in Search ROM
+			STATE_FUNCTION		// Selected, function layer active
+		};
+
+		void ROMCommand(BYTE data);
+		void Select(void);
+
+		State state;
+		bool overdrive;
+		bool overdriveMatch;
+		bool resumeFlag;
+
+		// Receive shift register
+		BYTE rxByte;
+		int rxBits;
+		int matchIndex;
+
+		// Transmit queue, sent LSB first
+		std::vector<BYTE> tx;
+		unsigned int txBit;
+
+		// Search ROM position
+		int searchBit;
+		int searchPhase;
+
+		// Scratchpad write position
+		unsigned int writeIndex;
+	};
+
+
+	/**
+	 * OneWire transport simulated on the host
+	 *
+	 * The bus is a wired-AND of the master and every attached device. Every slot
+	 * advances the virtual clock by the slot duration from the timing table of
+	 * the current speed.
+	 */
+	class SimulatedBus : public OneWireBus
+	{
+	public:
+		SimulatedBus(unsigned int busSpeed = OW_SPEED_STANDARD);
+
+		// Device population
+		void Attach(SimulatedDevice& device);
+		void Detach(SimulatedDevice& device);
+		unsigned int DeviceCount(void) const;
+
+		// OneWireBus interface
+		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
+		void WaitUS(unsigned int us);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+		unsigned long long NowNS(void) const;
+
+		// Edge level access for masters that generate their own slot timing.
+		// The slot type is decided from how long the line was held low.
+		void LineLow(void);
+		void LineRelease(void);
+		BYTE LineLevel(void) const;
+
+		// Virtual bus time in nanoseconds
+		unsigned long long Now(void) const;
+		void Advance(unsigned long long ns);
+
+		// Operation counters
+		unsigned long resetCount;
+		unsigned long slotCount;
+		void ClearCounters(void);
+
+		// Noise injection, the master reads the wrong level on the slot with
+		// the given slotCount value. Devices still see the real level.
+		void CorruptSlot(unsigned long slot);
+
+	private:
+		// Run one time slot with the master writing bit, returns the bus level
+		BYTE Slot(BYTE bit);
+
+		// Reset every device listening at the current speed, returns the
+		// devices' presence at sampleNS after the end of the reset pulse
+		int ResetDevices(unsigned long long sampleNS);
+
+		std::vector<SimulatedDevice*> devices;
+		std::vector<char> active;
+		unsigned int speed;
+		const unsigned long* timing;
+		unsigned long long now;
+		bool corrupt;
+		unsigned long corruptSlot;
+
+		// Edge level line state
+		enum LineEvent
+		{
+			LINE_NONE,
+			LINE_RESET,
+			LINE_SLOT
+		};
+		bool lineLow;
+		LineEvent lineEvent;
+		unsigned long long lineLowStart;
+		unsigned long long lineRelease;
+		BYTE lineSlotLevel;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDBUS_H
@@ -0,0 +1,120 @@
+/**
+ * @file SimulatedCoupler.cpp
+ *
+ * SimulatedCoupler class, a virtual DS2409.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SimulatedCoupler.h"
+#include "BranchManager.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * SimulatedCoupler constructor, both outputs off
+	 *
+	 * @param[in] rom ROM ID, family code first
+	 */
+	SimulatedCoupler::SimulatedCoupler(const BYTE* rom)
+		: SimulatedDevice(rom)
+		, output(-1)
+		, switchCount(0)
+		, smartOn(0)
+	{
+	}
+
+	void SimulatedCoupler::Connect(BYTE line, SimulatedDevice& device)
+	{
+		device.coupler = this;
+		device.couplerLine = line;
+		branch.push_back(&device);
+	}
+
+	void SimulatedCoupler::FunctionCommand(BYTE command)
+	{
+		smartOn = 0;
+
+		switch (command)
+		{
+		case OW_COUPLER_SMART_ON_MAIN:
+		case OW_COUPLER_SMART_ON_AUX:
+			// Nothing happens until the reset stimulus byte
+			smartOn = command;
+			break;
+		case OW_COUPLER_DIRECT_ON_MAIN:
+			SwitchOn(OW_COUPLER_MAIN, false);
+			Transmit(&command, 1);
+			break;
+		case OW_COUPLER_ALL_LINES_OFF:
+			output = -1;
+			++switchCount;
+			Transmit(&command, 1);
+			break;
+		default:
+			Deselect();
+			break;
+		}
+	}
+
+	/**
+	 * The reset stimulus after a smart-on: reset the branch, then answer with
+	 * presence and confirmation
+	 */
+	void SimulatedCoupler::FunctionData(BYTE data)
+	{
+		BYTE reply[2] = {0xFF, smartOn};
+
+		(void)data;
+		if (!smartOn) return;
+
+		if (SwitchOn(smartOn == OW_COUPLER_SMART_ON_AUX ? OW_COUPLER_AUX : OW_COUPLER_MAIN, true))
+			reply[0] = 0x00;
+		smartOn = 0;
+
+		Transmit(reply, 2);
+	}
+
+	bool SimulatedCoupler::LineOn(BYTE line) const
+	{
+		return output == line;
+	}
+
+	bool SimulatedCoupler::SwitchOn(BYTE line, bool smart)
+	{
+		bool presence = false;
+
+		output = line;
+		++switchCount;
+		if (!smart) return false;
+
+		for (unsigned int i = 0; i < branch.size(); ++i)
+		{
+			if (!branch[i]->Connected()) continue;
+
+			branch[i]->BusReset(OW_SPEED_STANDARD);
+			if (branch[i]->Presence(branch[i]->presenceDelayUS * 1000ULL)) presence = true;
+		}
+
+		return presence;
+	}
+
+} // Namespace OneWire
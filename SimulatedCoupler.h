@@ -0,0 +1,84 @@
+/**
+ * @file SimulatedCoupler.h
+ *
+ * SimulatedCoupler class prototype. A virtual DS2409 MicroLAN coupler for
+ * the SimulatedBus.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDCOUPLER_H
+#define STELLARIS_ONEWIRE_SIMULATEDCOUPLER_H
+
+
+#include "SimulatedBus.h"
+
+#include <vector>
+
+
+// Coupler outputs
+#define OW_COUPLER_MAIN		0
+#define OW_COUPLER_AUX		1
+
+
+namespace OneWire
+{
+
+	/**
+	 * Simulated DS2409
+	 *
+	 * Devices are attached to the SimulatedBus like any other, and connected
+	 * to one of the coupler's outputs with Connect(). They only see the bus
+	 * while that output is on. Smart-on waits for the master's reset stimulus
+	 * byte, resets the branch and answers with its presence, 0x00 if anything
+	 * answered and 0xFF if not, followed by the confirmation byte. Both
+	 * outputs start off.
+	 */
+	class SimulatedCoupler : public SimulatedDevice
+	{
+	public:
+		SimulatedCoupler(const BYTE* rom);
+
+		// Put a device on an output, OW_COUPLER_MAIN or OW_COUPLER_AUX
+		void Connect(BYTE line, SimulatedDevice& device);
+
+		// Output switched on, -1 for neither
+		int output;
+
+		// Number of function commands that changed an output
+		unsigned long switchCount;
+
+	protected:
+		void FunctionCommand(BYTE command);
+		void FunctionData(BYTE data);
+		bool LineOn(BYTE line) const;
+
+	private:
+		// Switch an output on, resetting its devices if smart, returns
+		// whether any of them answered
+		bool SwitchOn(BYTE line, bool smart);
+
+		std::vector<SimulatedDevice*> branch;
+
+		// Smart-on command waiting for its reset stimulus, 0 if none
+		BYTE smartOn;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDCOUPLER_H
@@ -0,0 +1,184 @@
+/**
+ * @file SimulatedDS2482.cpp
+ *
+ * SimulatedDS2482 implementation
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SimulatedDS2482.h"
+
+
+namespace OneWire
+{
+
+	static const BYTE channelCode[OW_DS2482_CHANNELS] =
+		{ 0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87 };
+	static const BYTE channelReadback[OW_DS2482_CHANNELS] =
+		{ 0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87 };
+
+
+	SimulatedDS2482::SimulatedDS2482(int channels)
+		: transactionCount(0)
+		, channels(channels)
+	{
+		for (int i = 0; i < OW_DS2482_CHANNELS; ++i) buses[i] = 0;
+		DeviceReset();
+	}
+
+	void SimulatedDS2482::Attach(int channel, SimulatedBus& bus)
+	{
+		if (channel >= 0 && channel < channels) buses[channel] = &bus;
+	}
+
+	void SimulatedDS2482::DeviceReset(void)
+	{
+		pointer = OW_DS2482_REG_STATUS;
+		status = OW_DS2482_STATUS_RST | OW_DS2482_STATUS_LL;
+		data = 0;
+		config = 0;
+		channel = 0;
+	}
+
+	/**
+	 * Bus on the selected channel, at the configured speed
+	 */
+	SimulatedBus& SimulatedDS2482::Line(void)
+	{
+		SimulatedBus& bus = buses[channel] ? *buses[channel] : unattached;
+
+		bus.SetSpeed(config & OW_DS2482_CONFIG_1WS ? OW_SPEED_OVERDRIVE : OW_SPEED_STANDARD);
+		return bus;
+	}
+
+	/**
+	 * A write transaction is a command byte and an optional parameter. The
+	 * chip doesn't acknowledge unknown commands or bad parameters.
+	 */
+	bool SimulatedDS2482::Write(const BYTE* message, int len)
+	{
+		++transactionCount;
+
+		if (len < 1) return true;
+		return Command(message[0], len > 1 ? message[1] : 0);
+	}
+
+	bool SimulatedDS2482::Command(BYTE command, BYTE parameter)
+	{
+		BYTE result;
+
+		switch (command)
+		{
+		case OW_DS2482_DEVICE_RESET:
+			DeviceReset();
+			return true;
+
+		case OW_DS2482_SET_POINTER:
+			if (parameter == OW_DS2482_REG_CHANNEL && channels == 1) return false;
+			if (parameter != OW_DS2482_REG_STATUS && parameter != OW_DS2482_REG_DATA
+				&& parameter != OW_DS2482_REG_CHANNEL && parameter != OW_DS2482_REG_CONFIG)
+				return false;
+			pointer = parameter;
+			return true;
+
+		case OW_DS2482_WRITE_CONFIG:
+			if ((parameter >> 4) != (~parameter & 0x0F)) return false;
+			config = parameter & 0x0F;
+			status &= ~OW_DS2482_STATUS_RST;
+			pointer = OW_DS2482_REG_CONFIG;
+			return true;
+
+		case OW_DS2482_CHANNEL_SELECT:
+			if (channels == 1) return false;
+			for (int i = 0; i < channels; ++i)
+			{
+				if (channelCode[i] != parameter) continue;
+
+				channel = i;
+				pointer = OW_DS2482_REG_CHANNEL;
+				return true;
+			}
+			return false;
+
+		case OW_DS2482_1W_RESET:
+			status &= ~(OW_DS2482_STATUS_PPD | OW_DS2482_STATUS_SD | OW_DS2482_STATUS_SBR);
+			if (Line().Reset()) status |= OW_DS2482_STATUS_PPD;
+			break;
+
+		case OW_DS2482_1W_BIT:
+			status &= ~OW_DS2482_STATUS_SBR;
+			if (parameter & 0x80) result = Line().ReadBit();
+			else
+			{
+				Line().WriteBit(0);
+				result = 0;
+			}
+			if (result) status |= OW_DS2482_STATUS_SBR;
+			break;
+
+		case OW_DS2482_1W_WRITE:
+			Line().WriteBytes(&parameter, 1);
+			break;
+
+		case OW_DS2482_1W_READ:
+			Line().ReadBytes(&data, 1);
+			break;
+
+		case OW_DS2482_1W_TRIPLET:
+			result = Line().Triplet(parameter & 0x80 ? 1 : 0);
+			status &= ~(OW_DS2482_STATUS_SBR | OW_DS2482_STATUS_TSB | OW_DS2482_STATUS_DIR);
+			status |= result << 5;
+			break;
+
+		default:
+			return false;
+		}
+
+		pointer = OW_DS2482_REG_STATUS;
+		return true;
+	}
+
+	bool SimulatedDS2482::Read(BYTE* message, int len)
+	{
+		BYTE value;
+
+		++transactionCount;
+
+		switch (pointer)
+		{
+		case OW_DS2482_REG_DATA: value = data; break;
+		case OW_DS2482_REG_CHANNEL: value = channelReadback[channel]; break;
+		case OW_DS2482_REG_CONFIG: value = config; break;
+		default: value = status; break;
+		}
+
+		// Reads past the first byte repeat the same register
+		for (int i = 0; i < len; ++i) message[i] = value;
+		return true;
+	}
+
+	void SimulatedDS2482::DelayUS(unsigned int us)
+	{
+		for (int i = 0; i < channels; ++i)
+		{
+			if (buses[i]) buses[i]->Advance(us * 1000ULL);
+		}
+	}
+
+} // Namespace OneWire
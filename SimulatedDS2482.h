@@ -0,0 +1,80 @@
+/**
+ * @file SimulatedDS2482.h
+ *
+ * SimulatedDS2482 class prototype. A DS2482-100 or -800 as an I2CPort, with
+ * a SimulatedBus on each channel, standing in for the I2C adapter and the
+ * chip so DS2482Bus runs on a machine without either.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDDS2482_H
+#define STELLARIS_ONEWIRE_SIMULATEDDS2482_H
+
+
+#include "DS2482Bus.h"
+#include "I2CPort.h"
+#include "SimulatedBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * DS2482 register and command model
+	 *
+	 * 1-Wire commands finish as soon as they are written, the time they take
+	 * passes on the simulated bus instead, as do waits through DelayUS().
+	 * Channels with no bus attached see an empty one.
+	 */
+	class SimulatedDS2482 : public I2CPort
+	{
+	public:
+		// channels is 1 for a DS2482-100, 8 for a DS2482-800
+		SimulatedDS2482(int channels = 1);
+
+		// Put a bus on a channel, 0 on a DS2482-100
+		void Attach(int channel, SimulatedBus& bus);
+
+		// I2CPort interface
+		bool Write(const BYTE* data, int len);
+		bool Read(BYTE* data, int len);
+		void DelayUS(unsigned int us);
+
+		// Every Write() and Read(), a WriteRead() counts twice
+		unsigned long transactionCount;
+
+	private:
+		void DeviceReset(void);
+		bool Command(BYTE command, BYTE parameter);
+		SimulatedBus& Line(void);
+
+		int channels;
+		SimulatedBus* buses[OW_DS2482_CHANNELS];
+		SimulatedBus unattached;
+
+		BYTE pointer;
+		BYTE status;
+		BYTE data;
+		BYTE config;
+		int channel;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDDS2482_H
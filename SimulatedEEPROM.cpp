@@ -0,0 +1,195 @@
+/**
+ * @file SimulatedEEPROM.cpp
+ *
+ * SimulatedEEPROM class, a virtual DS2431 or DS28EC20.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SimulatedEEPROM.h"
+#include "MemoryDevice.h"
+#include "OneWireCRC.h"
+
+#include <algorithm>
+
+
+namespace OneWire
+{
+
+	/**
+	 * SimulatedEEPROM constructor. Memory starts out erased, all 0xFF.
+	 *
+	 * @param[in] rom ROM ID, family code first
+	 */
+	SimulatedEEPROM::SimulatedEEPROM(const BYTE* rom)
+		: SimulatedDevice(rom)
+		, memory(MemorySize(rom[0]), 0xFF)
+		, fragile(false)
+		, copyCount(0)
+		, lostCount(0)
+		, pageSize(MemoryPageSize(rom[0]))
+		, es(0)
+		, received(0)
+		, crc(0)
+		, busyUntil(0)
+		, doneBits(0)
+	{
+		ta[0] = ta[1] = 0;
+		scratchpad.assign(pageSize, 0xFF);
+	}
+
+	/**
+	 * A reset while programming loses the page if the device is fragile
+	 */
+	void SimulatedEEPROM::BusReset(unsigned int busSpeed)
+	{
+		SimulatedDevice::BusReset(busSpeed);
+
+		if (fragile && Now() < busyUntil && !previous.empty())
+		{
+			unsigned int address = ta[0] | (ta[1] << 8);
+
+			std::copy(previous.begin(), previous.end(), memory.begin() + address);
+			++lostCount;
+			busyUntil = 0;
+		}
+
+		previous.clear();
+	}
+
+	void SimulatedEEPROM::FunctionCommand(BYTE command)
+	{
+		received = 0;
+		crc = CRC16Update(CRC16Init(), command);
+
+		if (Now() < busyUntil)
+		{
+			Deselect();
+			return;
+		}
+
+		switch (command)
+		{
+		case 0x0F:	// Write Scratchpad
+		case 0x55:	// Copy Scratchpad
+		case 0xF0:	// Read Memory
+			break;
+		case 0xAA:	// Read Scratchpad, from the target offset to the ending offset
+			{
+				BYTE reply[3 + OW_MEMORY_PAGE_MAX + 2];
+				unsigned int offset = ta[0] & (pageSize - 1);
+				unsigned int end = es & (pageSize - 1);
+				unsigned int len = 0;
+
+				reply[len++] = ta[0];
+				reply[len++] = ta[1];
+				reply[len++] = es;
+				for (unsigned int i = offset; i <= end; ++i) reply[len++] = scratchpad[i];
+
+				crc = CRC16Update(crc, reply, len);
+				crc = CRC16Final(crc);
+				reply[len++] = crc & 0xFF;
+				reply[len++] = crc >> 8;
+
+				Transmit(reply, len);
+			}
+			break;
+		default:
+			Deselect();
+			break;
+		}
+	}
+
+	void SimulatedEEPROM::FunctionData(BYTE data)
+	{
+		unsigned int n = received++;
+		unsigned int address;
+
+		crc = CRC16Update(crc, data);
+
+		switch (command)
+		{
+		case 0x0F:	// Write Scratchpad
+			if (n < 2)
+			{
+				ta[n] = data;
+				es = (ta[0] & (pageSize - 1)) - 1;
+				return;
+			}
+
+			n = (ta[0] & (pageSize - 1)) + n - 2;
+			if (n >= pageSize) return;
+
+			scratchpad[n] = data;
+			es = n;
+
+			// Written up to the end of the scratchpad, answer with the CRC
+			if (n == pageSize - 1)
+			{
+				BYTE reply[2];
+
+				crc = CRC16Final(crc);
+				reply[0] = crc & 0xFF;
+				reply[1] = crc >> 8;
+				Transmit(reply, 2);
+			}
+			break;
+		case 0x55:	// Copy Scratchpad, authorized by the TA and E/S read back
+			if (n == 0 && data != ta[0]) Deselect();
+			if (n == 1 && data != ta[1]) Deselect();
+			if (n != 2) return;
+
+			address = ta[0] | (ta[1] << 8);
+			if (data != es || es != pageSize - 1 || (address & (pageSize - 1)) || address >= memory.size())
+			{
+				Deselect();
+				return;
+			}
+
+			previous.assign(memory.begin() + address, memory.begin() + address + pageSize);
+			std::copy(scratchpad.begin(), scratchpad.end(), memory.begin() + address);
+			es |= 0x80;
+			busyUntil = Now() + OW_MEMORY_PROGRAM_US * 1000ULL;
+			doneBits = 0;
+			++copyCount;
+			break;
+		case 0xF0:	// Read Memory, streaming to the end
+			if (n < 2) ta[n] = data;
+			if (n != 1) return;
+
+			address = ta[0] | (ta[1] << 8);
+			if (address < memory.size())
+				Transmit(&memory[address], memory.size() - address);
+			break;
+		default:
+			break;
+		}
+	}
+
+	/**
+	 * Reads 1 while programming, then alternating 0 and 1
+	 */
+	BYTE SimulatedEEPROM::FunctionDrive(void)
+	{
+		if (command != 0x55 || !(es & 0x80) || Now() < busyUntil) return 1;
+
+		return doneBits++ & 0x01;
+	}
+
+} // Namespace OneWire
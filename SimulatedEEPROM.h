@@ -0,0 +1,85 @@
+/**
+ * @file SimulatedEEPROM.h
+ *
+ * SimulatedEEPROM class prototype. A virtual DS2431 or DS28EC20 for the
+ * SimulatedBus.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDEEPROM_H
+#define STELLARIS_ONEWIRE_SIMULATEDEEPROM_H
+
+
+#include "SimulatedBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Simulated EEPROM
+	 *
+	 * Write Scratchpad, Read Scratchpad, Copy Scratchpad and Read Memory, with
+	 * the size and page of the part picked by the family code. A copy takes
+	 * OW_MEMORY_PROGRAM_US of virtual bus time, during which the device
+	 * ignores function commands.
+	 */
+	class SimulatedEEPROM : public SimulatedDevice
+	{
+	public:
+		SimulatedEEPROM(const BYTE* rom);
+
+		// Data memory
+		std::vector<BYTE> memory;
+
+		// Lose a copy if the bus is reset while it is programming, as a
+		// parasite powered part starved by the traffic would
+		bool fragile;
+
+		// Number of copies done, and lost to fragile
+		unsigned long copyCount;
+		unsigned long lostCount;
+
+		void BusReset(unsigned int busSpeed);
+
+	protected:
+		void FunctionCommand(BYTE command);
+		void FunctionData(BYTE data);
+		BYTE FunctionDrive(void);
+
+	private:
+		unsigned int pageSize;
+
+		// Target address and E/S register
+		BYTE ta[2];
+		BYTE es;
+
+		// Bytes received after the command, and the CRC16 over them
+		unsigned int received;
+		unsigned short crc;
+
+		// Programming in progress, and what the page held before it
+		unsigned long long busyUntil;
+		std::vector<BYTE> previous;
+		unsigned int doneBits;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDEEPROM_H
@@ -0,0 +1,99 @@
+/**
+ * @file SimulatedLine.cpp
+ *
+ * AsyncEngine line and compare timer simulated on a SimulatedBus
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SimulatedLine.h"
+
+
+namespace OneWire
+{
+
+	SimulatedLine::SimulatedLine(SimulatedBus& bus)
+		: bus(bus)
+		, armed(false)
+		, deadline(0)
+	{
+	}
+
+	void SimulatedLine::Low(void)
+	{
+		bus.LineLow();
+	}
+
+	void SimulatedLine::Release(void)
+	{
+		bus.LineRelease();
+	}
+
+	BYTE SimulatedLine::Sample(void)
+	{
+		return bus.LineLevel();
+	}
+
+	void SimulatedLine::Schedule(unsigned long ns)
+	{
+		armed = true;
+		deadline = bus.Now() + ns;
+	}
+
+	/**
+	 * Whether the timer is armed
+	 */
+	bool SimulatedLine::Pending(void) const
+	{
+		return armed;
+	}
+
+	/**
+	 * Bus time the armed timer expires at
+	 */
+	unsigned long long SimulatedLine::Deadline(void) const
+	{
+		return deadline;
+	}
+
+	/**
+	 * Let bus time run up to the armed deadline and take the timer interrupt.
+	 * Returns false if the timer was not armed.
+	 */
+	bool SimulatedLine::Step(void)
+	{
+		if (!armed) return false;
+
+		if (deadline > bus.Now()) bus.Advance(deadline - bus.Now());
+
+		armed = false;
+		Fire();
+		return true;
+	}
+
+	/**
+	 * Take timer interrupts until the engine stops arming the timer
+	 */
+	void SimulatedLine::RunUntilIdle(void)
+	{
+		while (Step());
+	}
+
+} // Namespace OneWire
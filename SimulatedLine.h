@@ -0,0 +1,69 @@
+/**
+ * @file SimulatedLine.h
+ *
+ * SimulatedLine class prototype. Runs an AsyncEngine against a SimulatedBus,
+ * with a simulated compare timer that fires in virtual bus time.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDLINE_H
+#define STELLARIS_ONEWIRE_SIMULATEDLINE_H
+
+
+#include "AsyncEngine.h"
+#include "SimulatedBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWireLine on a SimulatedBus
+	 *
+	 * The timer never fires on its own. Step() advances the bus clock to the
+	 * armed deadline and runs the engine, which is what the timer interrupt
+	 * would do on the target. Anything the caller does between steps is work
+	 * the CPU got done while the bus was busy.
+	 */
+	class SimulatedLine : public OneWireLine
+	{
+	public:
+		SimulatedLine(SimulatedBus& bus);
+
+		// OneWireLine interface
+		void Low(void);
+		void Release(void);
+		BYTE Sample(void);
+		void Schedule(unsigned long ns);
+
+		// Simulated timer
+		bool Pending(void) const;
+		unsigned long long Deadline(void) const;
+		bool Step(void);
+		void RunUntilIdle(void);
+
+	private:
+		SimulatedBus& bus;
+		bool armed;
+		unsigned long long deadline;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDLINE_H
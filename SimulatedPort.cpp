@@ -0,0 +1,132 @@
+/**
+ * @file SimulatedPort.cpp
+ *
+ * OneWirePort on simulated buses
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SimulatedPort.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * SimulatedPort constructor
+	 *
+	 * @param[in] busSpeed Initial speed of every lane
+	 */
+	SimulatedPort::SimulatedPort(unsigned int busSpeed)
+		: speed(busSpeed)
+		, now(0)
+	{
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane) lanes[lane] = 0;
+	}
+
+	/**
+	 * Connect a bus to the port. Its clock jumps ahead to the port's.
+	 */
+	void SimulatedPort::Attach(int lane, SimulatedBus& bus)
+	{
+		lanes[lane] = &bus;
+		bus.SetSpeed(speed);
+		if (bus.Now() < now) bus.Advance(now - bus.Now());
+	}
+
+	void SimulatedPort::Detach(int lane)
+	{
+		lanes[lane] = 0;
+	}
+
+	BYTE SimulatedPort::Lanes(void) const
+	{
+		BYTE mask = 0;
+
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (lanes[lane]) mask |= 1 << lane;
+		}
+
+		return mask;
+	}
+
+	void SimulatedPort::Low(BYTE mask)
+	{
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (lanes[lane] && (mask & (1 << lane))) lanes[lane]->LineLow();
+		}
+	}
+
+	void SimulatedPort::Release(BYTE mask)
+	{
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (lanes[lane] && (mask & (1 << lane))) lanes[lane]->LineRelease();
+		}
+	}
+
+	/**
+	 * Level of every lane, lanes with no bus float high
+	 */
+	BYTE SimulatedPort::Read(void)
+	{
+		BYTE level = 0xFF;
+
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (lanes[lane] && !lanes[lane]->LineLevel()) level &= ~(1 << lane);
+		}
+
+		return level;
+	}
+
+	void SimulatedPort::Delay(int index)
+	{
+		unsigned long ns = TimingNS(speed)[index];
+
+		now += ns;
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (lanes[lane]) lanes[lane]->Advance(ns);
+		}
+	}
+
+	void SimulatedPort::SetSpeed(unsigned int busSpeed)
+	{
+		speed = busSpeed;
+		for (int lane = 0; lane < OW_PORT_LANES; ++lane)
+		{
+			if (lanes[lane]) lanes[lane]->SetSpeed(busSpeed);
+		}
+	}
+
+	unsigned int SimulatedPort::GetSpeed(void) const
+	{
+		return speed;
+	}
+
+	unsigned long long SimulatedPort::Now(void) const
+	{
+		return now;
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,71 @@
+/**
+ * @file SimulatedPort.h
+ *
+ * SimulatedPort class prototype. A OneWirePort whose lanes are SimulatedBus
+ * objects, for running MultiBusMaster on a host machine.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDPORT_H
+#define STELLARIS_ONEWIRE_SIMULATEDPORT_H
+
+
+#include "MultiBusMaster.h"
+#include "SimulatedBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWirePort on SimulatedBus lanes
+	 *
+	 * Lanes are driven through the edge level interface of each bus, and
+	 * Delay() advances every bus clock together, so they all stay in step.
+	 */
+	class SimulatedPort : public OneWirePort
+	{
+	public:
+		SimulatedPort(unsigned int busSpeed = OW_SPEED_STANDARD);
+
+		// Connect a bus as lane number lane
+		void Attach(int lane, SimulatedBus& bus);
+		void Detach(int lane);
+
+		// OneWirePort interface
+		BYTE Lanes(void) const;
+		void Low(BYTE mask);
+		void Release(BYTE mask);
+		BYTE Read(void);
+		void Delay(int index);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+		// Virtual port time in nanoseconds
+		unsigned long long Now(void) const;
+
+	private:
+		SimulatedBus* lanes[OW_PORT_LANES];
+		unsigned int speed;
+		unsigned long long now;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDPORT_H
@@ -0,0 +1,169 @@
+/**
+ * @file SimulatedThermometer.cpp
+ *
+ * Simulated DS18B20, DS1822 and DS18S20
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SimulatedThermometer.h"
+#include "OneWireCRC.h"
+
+
+namespace OneWire
+{
+
+	// Conversion time at 9 bit resolution, doubling for every extra bit
+	static const unsigned long long CONVERSION_9BIT_NS = 93750000ULL;
+
+	/**
+	 * SimulatedThermometer constructor. Starts out at the power-on values: 85
+	 * degrees in the scratchpad and 12 bit resolution.
+	 *
+	 * @param[in] rom ROM ID, family code first
+	 */
+	SimulatedThermometer::SimulatedThermometer(const BYTE* rom)
+		: SimulatedDevice(rom)
+		, temperature(25 * 16)
+		, parasite(false)
+		, conversionPercent(100)
+		, conversionCount(0)
+		, copyCount(0)
+		, extended(rom[0] == 0x10)
+		, busyUntil(0)
+		, writePosition(0)
+		, powerQuery(false)
+	{
+		// 85 degrees, TH 75, TL 70, 12 bits
+		static const BYTE powerOn[9] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0};
+		static const BYTE powerOnS[9] = {0xAA, 0x00, 0x4B, 0x46, 0xFF, 0xFF, 0x0C, 0x10, 0};
+
+		scratchpad.assign(extended ? powerOnS : powerOn, (extended ? powerOnS : powerOn) + 9);
+		eeprom[0] = scratchpad[2];
+		eeprom[1] = scratchpad[3];
+		eeprom[2] = scratchpad[4];
+		UpdateCRC();
+	}
+
+	int SimulatedThermometer::Resolution(void) const
+	{
+		return extended ? 9 : 9 + ((scratchpad[4] >> 5) & 0x03);
+	}
+
+	void SimulatedThermometer::FunctionCommand(BYTE command)
+	{
+		powerQuery = false;
+
+		switch (command)
+		{
+		case 0x44:	// Convert T
+			{
+				int shift = extended ? 3 : Resolution() - 9;
+				unsigned long long ns = (CONVERSION_9BIT_NS << shift) * conversionPercent / 100;
+
+				busyUntil = Now() + ns;
+				Convert();
+			}
+			break;
+		case 0xBE:	// Read Scratchpad
+			Transmit(&scratchpad[0], scratchpad.size());
+			break;
+		case 0x4E:	// Write Scratchpad, TH, TL and configuration
+			writePosition = 2;
+			break;
+		case 0x48:	// Copy Scratchpad
+			eeprom[0] = scratchpad[2];
+			eeprom[1] = scratchpad[3];
+			eeprom[2] = scratchpad[4];
+			++copyCount;
+			break;
+		case 0xB8:	// Recall EEPROM
+			scratchpad[2] = eeprom[0];
+			scratchpad[3] = eeprom[1];
+			if (!extended) scratchpad[4] = eeprom[2];
+			UpdateCRC();
+			break;
+		case 0xB4:	// Read Power Supply
+			powerQuery = true;
+			break;
+		default:
+			Deselect();
+			break;
+		}
+	}
+
+	void SimulatedThermometer::FunctionData(BYTE data)
+	{
+		if (command != 0x4E) return;
+
+		// The DS18S20 has no configuration register
+		if (writePosition < (extended ? 4u : 5u))
+		{
+			if (writePosition == 4) data = (data & 0x60) | 0x1F;
+			scratchpad[writePosition++] = data;
+			UpdateCRC();
+		}
+	}
+
+	BYTE SimulatedThermometer::FunctionDrive(void)
+	{
+		if (powerQuery) return parasite ? 0 : 1;
+		if (command == 0x44 && !parasite) return Now() >= busyUntil ? 1 : 0;
+		return 1;
+	}
+
+	/**
+	 * Latch the temperature the way the part would report it
+	 */
+	void SimulatedThermometer::Convert(void)
+	{
+		int t = temperature;
+
+		++conversionCount;
+
+		if (extended)
+		{
+			// Half degrees plus count remaining, see DecodeTemperature()
+			int whole = (t + 4) >> 4;
+			int raw = whole * 2;
+
+			scratchpad[0] = raw & 0xFF;
+			scratchpad[1] = (raw >> 8) & 0xFF;
+			scratchpad[6] = whole * 16 + 12 - t;
+			scratchpad[7] = 16;
+		}
+		else
+		{
+			// Bits below the resolution are undefined, leave them clear
+			t &= ~((1 << (12 - Resolution())) - 1);
+
+			scratchpad[0] = t & 0xFF;
+			scratchpad[1] = (t >> 8) & 0xFF;
+		}
+
+		UpdateCRC();
+	}
+
+	void SimulatedThermometer::UpdateCRC(void)
+	{
+		scratchpad[8] = CRC8Update(CRC8Init(), &scratchpad[0], 8);
+	}
+
+} // Namespace OneWire
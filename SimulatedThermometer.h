@@ -0,0 +1,84 @@
+/**
+ * @file SimulatedThermometer.h
+ *
+ * SimulatedThermometer class prototype. Model of a DS18B20, DS1822 or
+ * DS18S20 for the simulated bus, picked by the family code of its ROM.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDTHERMOMETER_H
+#define STELLARIS_ONEWIRE_SIMULATEDTHERMOMETER_H
+
+
+#include "SimulatedBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Simulated digital thermometer
+	 *
+	 * Convert T takes the datasheet conversion time for the configured
+	 * resolution, scaled by conversionPercent, in virtual bus time. Read slots
+	 * read 0 until it is done, unless the device is parasite powered.
+	 */
+	class SimulatedThermometer : public SimulatedDevice
+	{
+	public:
+		SimulatedThermometer(const BYTE* rom);
+
+		// Temperature the next conversion reads, in 1/16 degree C
+		int temperature;
+
+		// Parasite powered, answers Read Power Supply with 0
+		bool parasite;
+
+		// Conversion time as a percentage of the datasheet maximum
+		unsigned int conversionPercent;
+
+		// TH, TL and configuration as stored in EEPROM
+		BYTE eeprom[3];
+
+		// Number of conversions and EEPROM copies done
+		unsigned long conversionCount;
+		unsigned long copyCount;
+
+		// Resolution in bits, from the configuration register
+		int Resolution(void) const;
+
+	protected:
+		void FunctionCommand(BYTE command);
+		void FunctionData(BYTE data);
+		BYTE FunctionDrive(void);
+
+	private:
+		// Latch the temperature into the scratchpad
+		void Convert(void);
+		void UpdateCRC(void);
+
+		bool extended;
+		unsigned long long busyUntil;
+		unsigned int writePosition;
+		bool powerQuery;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDTHERMOMETER_H
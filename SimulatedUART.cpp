@@ -0,0 +1,118 @@
+/**
+ * @file SimulatedUART.cpp
+ *
+ * SimulatedUART implementation
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SimulatedUART.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * SimulatedUART constructor
+	 *
+	 * @param[in] bus Bus the UART pins are tied to
+	 * @param[in] baud Initial rate in bits per second
+	 */
+	SimulatedUART::SimulatedUART(SimulatedBus& bus, unsigned long baud)
+		: byteCount(0)
+		, framingErrors(0)
+		, bus(bus)
+		, baud(0)
+		, remainder(0)
+	{
+		SetBaud(baud);
+	}
+
+	void SimulatedUART::SetBaud(unsigned long baud)
+	{
+		this->baud = baud;
+		remainder = 0;
+	}
+
+	/**
+	 * Bit times don't come out to whole nanoseconds, the leftover is carried
+	 * so that a long run of bits keeps the right rate
+	 */
+	BYTE SimulatedUART::Bit(BYTE level)
+	{
+		unsigned long long total = 1000000000ULL + remainder;
+		unsigned long long period = total / baud;
+		remainder = total % baud;
+
+		if (level) bus.LineRelease();
+		else bus.LineLow();
+
+		bus.Advance(period / 2);
+		BYTE sample = bus.LineLevel();
+		bus.Advance(period - period / 2);
+
+		return sample;
+	}
+
+	/**
+	 * Start bit, eight data bits least significant first, stop bit
+	 */
+	void SimulatedUART::Write(const BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			BYTE b = data[i];
+			BYTE echo = 0;
+
+			Bit(0);
+			for (int bit = 0; bit < 8; ++bit, b >>= 1)
+			{
+				if (Bit(b & 0x01)) echo |= 1 << bit;
+			}
+			if (!Bit(1)) ++framingErrors;
+
+			received.push_back(echo);
+			++byteCount;
+		}
+	}
+
+	bool SimulatedUART::Read(BYTE* data, int len)
+	{
+		if ((int)received.size() < len) return false;
+
+		for (int i = 0; i < len; ++i)
+		{
+			data[i] = received.front();
+			received.pop_front();
+		}
+
+		return true;
+	}
+
+	void SimulatedUART::Flush(void)
+	{
+		received.clear();
+	}
+
+	void SimulatedUART::DelayUS(unsigned int us)
+	{
+		bus.Advance(us * 1000ULL);
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,77 @@
+/**
+ * @file SimulatedUART.h
+ *
+ * SimulatedUART class prototype. A UART looped back through a SimulatedBus,
+ * for running UARTBus on the host. Every byte written is clocked onto the bus
+ * bit by bit at the current baud rate and read back the way the UART's
+ * receiver would see it.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SIMULATEDUART_H
+#define STELLARIS_ONEWIRE_SIMULATEDUART_H
+
+
+#include "SerialPort.h"
+#include "SimulatedBus.h"
+
+#include <deque>
+
+
+namespace OneWire
+{
+
+	/**
+	 * UART with transmit and receive tied to a simulated bus
+	 *
+	 * Transmit drives the line through the bus's edge level interface, so the
+	 * devices decide what each byte was from how long the line was held low.
+	 * The receiver samples the middle of every bit.
+	 */
+	class SimulatedUART : public SerialPort
+	{
+	public:
+		SimulatedUART(SimulatedBus& bus, unsigned long baud = 9600);
+
+		// SerialPort interface
+		void Write(const BYTE* data, int len);
+		bool Read(BYTE* data, int len);
+		void Flush(void);
+		void SetBaud(unsigned long baud);
+		void DelayUS(unsigned int us);
+
+		// Bytes sent, and stop bits that read low
+		unsigned long byteCount;
+		unsigned long framingErrors;
+
+	private:
+		// Drive one bit time, returns the level in the middle of it
+		BYTE Bit(BYTE level);
+
+		SimulatedBus& bus;
+		unsigned long baud;
+		std::deque<BYTE> received;
+
+		// Bit time in ns, in 1/baud fractions carried from bit to bit
+		unsigned long long remainder;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SIMULATEDUART_H
@@ -0,0 +1,92 @@
+/**
+ * @file SnapshotFile.cpp
+ *
+ * DeviceSnapshot file storage, see SnapshotFile.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SnapshotFile.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+namespace OneWire
+{
+
+	/**
+	 * @param[in] snapshot Snapshot to save
+	 * @param[in] path File to write, replaced if it exists
+	 * @return true once the snapshot is on disk
+	 */
+	bool SaveSnapshotFile(const DeviceSnapshot& snapshot, const char* path)
+	{
+		std::vector<BYTE> buffer(snapshot.Size());
+		std::string temp = std::string(path) + ".tmp";
+		unsigned int len = snapshot.Save(&buffer[0], buffer.size());
+
+		int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) return false;
+
+		bool ok = write(fd, &buffer[0], len) == (ssize_t)len;
+		ok = fsync(fd) == 0 && ok;
+		ok = close(fd) == 0 && ok;
+
+		if (!ok || rename(temp.c_str(), path) != 0)
+		{
+			unlink(temp.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * @param[out] snapshot Loaded snapshot, empty on failure
+	 * @param[in] path File to read
+	 * @return true if the file held an intact snapshot
+	 */
+	bool LoadSnapshotFile(DeviceSnapshot& snapshot, const char* path)
+	{
+		std::vector<BYTE> buffer(OW_SNAPSHOT_BYTES(OW_MAX_NUM_DEVICES));
+		unsigned int len = 0;
+
+		snapshot.Clear();
+
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+
+		for (;;)
+		{
+			ssize_t n = read(fd, &buffer[len], buffer.size() - len);
+			if (n <= 0) break;
+
+			len += n;
+			if (len == buffer.size()) break;
+		}
+		close(fd);
+
+		return snapshot.Load(&buffer[0], len);
+	}
+
+} // Namespace OneWire
@@ -0,0 +1,43 @@
+/**
+ * @file SnapshotFile.h
+ *
+ * DeviceSnapshot storage in a file, for the Linux backend
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SNAPSHOTFILE_H
+#define STELLARIS_ONEWIRE_SNAPSHOTFILE_H
+
+
+#include "DeviceSnapshot.h"
+
+
+namespace OneWire
+{
+
+	// Write a snapshot to path. A new file is written next to it and renamed
+	// over it, so a crash leaves either the old snapshot or the new one.
+	bool SaveSnapshotFile(const DeviceSnapshot& snapshot, const char* path);
+
+	// Read a snapshot back, false if the file is missing or not intact
+	bool LoadSnapshotFile(DeviceSnapshot& snapshot, const char* path);
+
+}
+#endif // STELLARIS_ONEWIRE_SNAPSHOTFILE_H
@@ -0,0 +1,86 @@
+/**
+ * @file SnapshotFlash.h
+ *
+ * DeviceSnapshot storage in Stellaris internal flash. The snapshot goes at
+ * the start of a region set aside for it, which has to begin on an erase
+ * block and hold OW_SNAPSHOT_BYTES(OW_MAX_NUM_DEVICES). Erased flash reads
+ * as 0xFF and never loads.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SNAPSHOTFLASH_H
+#define STELLARIS_ONEWIRE_SNAPSHOTFLASH_H
+
+
+#include "inc/hw_types.h"
+#include "driverlib/flash.h"
+
+#include "DeviceSnapshot.h"
+
+
+// Flash erase block size
+#ifndef OW_FLASH_BLOCK
+#define OW_FLASH_BLOCK	1024
+#endif // OW_FLASH_BLOCK
+
+// Largest snapshot in whole words, FlashProgram() writes nothing smaller
+#define OW_SNAPSHOT_FLASH_WORDS	((OW_SNAPSHOT_BYTES(OW_MAX_NUM_DEVICES) + 3) / 4)
+
+
+namespace OneWire
+{
+
+	/**
+	 * Erase the blocks the snapshot needs and program it
+	 *
+	 * @param[in] snapshot Snapshot to save
+	 * @param[in] address Start of the flash region, on an erase block
+	 * @return true if every erase and program succeeded
+	 */
+	inline bool SaveSnapshotFlash(const DeviceSnapshot& snapshot, unsigned long address)
+	{
+		// Word aligned for FlashProgram(), and kept off the stack
+		static unsigned long words[OW_SNAPSHOT_FLASH_WORDS];
+
+		unsigned long len = snapshot.Save((BYTE*)words, sizeof(words));
+		unsigned long rounded = (len + 3) & ~3UL;
+
+		for (unsigned long block = 0; block < rounded; block += OW_FLASH_BLOCK)
+		{
+			if (FlashErase(address + block) != 0) return false;
+		}
+
+		return FlashProgram(words, address, rounded) == 0;
+	}
+
+	/**
+	 * Load a snapshot straight out of the memory mapped flash
+	 *
+	 * @param[out] snapshot Loaded snapshot, empty on failure
+	 * @param[in] address Start of the flash region
+	 * @return true if the region held an intact snapshot
+	 */
+	inline bool LoadSnapshotFlash(DeviceSnapshot& snapshot, unsigned long address)
+	{
+		return snapshot.Load((const BYTE*)address, OW_SNAPSHOT_BYTES(OW_MAX_NUM_DEVICES));
+	}
+
+}
+#endif // STELLARIS_ONEWIRE_SNAPSHOTFLASH_H
@@ -0,0 +1,242 @@
+/**
+ * @file SpeedManager.cpp
+ *
+ * SpeedManager class methods, see SpeedManager.h
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SpeedManager.h"
+
+
+namespace OneWire
+{
+
+	SpeedManager::SpeedManager(OneWireMaster& master)
+		: probeCount(0)
+		, overdriveCount(0)
+		, retryCount(0)
+		, fallbackCount(0)
+		, master(master)
+	{
+	}
+
+	/**
+	 * Overdrive Match the device, then reset at overdrive and read its ROM
+	 * back. The standard speed reset first knocks every other device out of
+	 * overdrive, so only this one can answer.
+	 *
+	 * @param[in] rom Device to probe
+	 * @return true if the device answered at overdrive
+	 */
+	bool SpeedManager::Probe(ROM rom)
+	{
+		BYTE bytes[8];
+		bool capable = false;
+
+		++probeCount;
+
+		master.SetSpeed(OW_SPEED_STANDARD);
+		if (master.Reset())
+		{
+			master.WriteByte(OW_OVERDRIVE_MATCH);
+			master.SetSpeed(OW_SPEED_OVERDRIVE);
+
+			UnpackROM(rom, bytes);
+			for (int i = 0; i < 8; ++i) master.WriteByte(bytes[i]);
+
+			if (master.Reset())
+			{
+				master.WriteByte(OW_READ_ROM);
+				for (int i = 0; i < 8; ++i) bytes[i] = master.ReadByte();
+
+				capable = PackROM(bytes) == rom;
+			}
+
+			master.SetSpeed(OW_SPEED_STANDARD);
+		}
+
+		suspect.Remove(rom);
+		if (capable) overdrive.Insert(rom);
+		else overdrive.Remove(rom);
+
+		return capable;
+	}
+
+	int SpeedManager::ProbeAll(const DeviceTable& devices)
+	{
+		int capable = 0;
+
+		for (unsigned int i = 0; i < devices.Count(); ++i)
+		{
+			if (Probe(devices[i])) ++capable;
+		}
+
+		return capable;
+	}
+
+	unsigned int SpeedManager::Speed(ROM rom) const
+	{
+		return overdrive.Contains(rom) ? OW_SPEED_OVERDRIVE : OW_SPEED_STANDARD;
+	}
+
+	const DeviceTable& SpeedManager::OverdriveGroup(void) const
+	{
+		return overdrive;
+	}
+
+	void SpeedManager::Load(const DeviceSnapshot& snapshot)
+	{
+		overdrive.Clear();
+		suspect.Clear();
+
+		for (unsigned int i = 0; i < snapshot.Count(); ++i)
+		{
+			if (snapshot[i].speed == OW_SPEED_OVERDRIVE) overdrive.Insert(snapshot[i].rom);
+		}
+	}
+
+	void SpeedManager::Record(DeviceSnapshot& snapshot) const
+	{
+		for (unsigned int i = 0; i < snapshot.Count(); ++i)
+		{
+			snapshot.SetSpeed(snapshot[i].rom, Speed(snapshot[i].rom));
+		}
+	}
+
+	bool SpeedManager::Overdrive(const Transaction& transaction) const
+	{
+		return transaction.reset
+			&& transaction.select == SELECT_MATCH
+			&& overdrive.Contains(transaction.rom);
+	}
+
+	/**
+	 * Run a transaction, with Overdrive Match in place of Match ROM if the
+	 * device is in the overdrive group. The bus is left at standard speed.
+	 */
+	TransactionResult SpeedManager::Execute(const Transaction& transaction)
+	{
+		if (!Overdrive(transaction)) return master.Execute(transaction);
+
+		Transaction fast = transaction;
+		fast.select = SELECT_OVERDRIVE_MATCH;
+
+		++overdriveCount;
+		TransactionResult result = master.Execute(fast);
+		master.SetSpeed(OW_SPEED_STANDARD);
+
+		if (result != TRANSACTION_CRC_ERROR)
+		{
+			suspect.Remove(transaction.rom);
+			return result;
+		}
+
+		return Fallback(transaction);
+	}
+
+	/**
+	 * Run a batch. Overdrive Skip puts the whole overdrive group in overdrive
+	 * with one standard speed reset, after that each of their transactions
+	 * is an overdrive reset and Match ROM.
+	 *
+	 * @param[in] transactions Transactions to run, in any order
+	 * @param[out] results Result of each transaction
+	 * @param[in] count Number of transactions
+	 * @return Number of transactions that succeeded
+	 */
+	int SpeedManager::ExecuteAll
+		( const Transaction* transactions
+		, TransactionResult* results
+		, int count
+		)
+	{
+		bool fast = false;
+		int ok = 0;
+
+		// Standard speed group first, that reset leaves everyone at standard
+		for (int i = 0; i < count; ++i)
+		{
+			if (Overdrive(transactions[i]))
+			{
+				fast = true;
+				continue;
+			}
+
+			results[i] = master.Execute(transactions[i]);
+		}
+
+		if (fast)
+		{
+			bool present = master.SkipOverdrive() != 0;
+
+			for (int i = 0; i < count; ++i)
+			{
+				if (!Overdrive(transactions[i])) continue;
+
+				// Nothing in overdrive answered, none of these can work
+				results[i] = TRANSACTION_CRC_ERROR;
+				if (!present) continue;
+
+				++overdriveCount;
+				results[i] = master.Execute(transactions[i]);
+			}
+
+			master.SetSpeed(OW_SPEED_STANDARD);
+
+			// Retries go out at standard speed, after the whole group
+			for (int i = 0; i < count; ++i)
+			{
+				if (!Overdrive(transactions[i])) continue;
+
+				if (results[i] == TRANSACTION_CRC_ERROR)
+					results[i] = Fallback(transactions[i]);
+				else
+					suspect.Remove(transactions[i].rom);
+			}
+		}
+
+		for (int i = 0; i < count; ++i)
+		{
+			if (results[i] == TRANSACTION_OK) ++ok;
+		}
+
+		return ok;
+	}
+
+	TransactionResult SpeedManager::Fallback(const Transaction& transaction)
+	{
+		ROM rom = transaction.rom;
+
+		if (suspect.Contains(rom))
+		{
+			suspect.Remove(rom);
+			overdrive.Remove(rom);
+			++fallbackCount;
+		}
+		else
+		{
+			suspect.Insert(rom);
+		}
+
+		++retryCount;
+		return master.Execute(transaction);
+	}
+
+} // Namespace OneWire
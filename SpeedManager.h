@@ -0,0 +1,108 @@
+/**
+ * @file SpeedManager.h
+ *
+ * SpeedManager class prototype. Finds out which devices can run at overdrive
+ * and moves their transactions there, falling back to standard speed for any
+ * device that keeps failing at overdrive.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_SPEEDMANAGER_H
+#define STELLARIS_ONEWIRE_SPEEDMANAGER_H
+
+
+#include "DeviceSnapshot.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * Per device bus speed
+	 *
+	 * Probe() sends Overdrive Match to one device and reads its ROM back with
+	 * Read ROM at overdrive, so a device only joins the overdrive group if
+	 * overdrive slots actually work with it. Everything else stays in the
+	 * standard speed group.
+	 *
+	 * Execute() runs a Match ROM transaction to an overdrive device with
+	 * Overdrive Match, everything else as it is. ExecuteAll() runs a batch
+	 * grouped by speed: the standard speed transactions first, then a single
+	 * Overdrive Skip puts the overdrive group in overdrive for the rest.
+	 *
+	 * A CRC failure at overdrive is retried at standard speed straight away.
+	 * Two in a row and the device is moved to the standard speed group. Only
+	 * transactions that check a CRC can notice a failure.
+	 */
+	class SpeedManager
+	{
+	public:
+		SpeedManager(OneWireMaster& master);
+
+		// Probe one device, true if it runs at overdrive
+		bool Probe(ROM rom);
+
+		// Probe every device in a table, returns how many run at overdrive
+		int ProbeAll(const DeviceTable& devices);
+
+		// OW_SPEED_OVERDRIVE or OW_SPEED_STANDARD
+		unsigned int Speed(ROM rom) const;
+
+		// Devices run at overdrive
+		const DeviceTable& OverdriveGroup(void) const;
+
+		// Take speeds from a snapshot without probing, or store them in one
+		void Load(const DeviceSnapshot& snapshot);
+		void Record(DeviceSnapshot& snapshot) const;
+
+		// Run a transaction at its device's speed
+		TransactionResult Execute(const Transaction& transaction);
+
+		// Run a batch grouped by speed. Each transaction's result goes in
+		// results, returns the number that succeeded.
+		int ExecuteAll
+			( const Transaction* transactions
+			, TransactionResult* results
+			, int count
+			);
+
+		// Work done so far
+		unsigned long probeCount;
+		unsigned long overdriveCount;
+		unsigned long retryCount;
+		unsigned long fallbackCount;
+
+	private:
+		// Whether a transaction goes to an overdrive device
+		bool Overdrive(const Transaction& transaction) const;
+
+		// Count a failure at overdrive and run the transaction again at
+		// standard speed
+		TransactionResult Fallback(const Transaction& transaction);
+
+		OneWireMaster& master;
+
+		// Overdrive group, and those of it that failed their last transaction
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> overdrive;
+		StaticDeviceTable<OW_MAX_NUM_DEVICES> suspect;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_SPEEDMANAGER_H
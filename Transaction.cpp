@@ -0,0 +1,127 @@
+/**
+ * @file Transaction.cpp
+ *
+ * Device access description for OneWireMaster::Execute()
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Transaction.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * An empty transaction: a reset and nothing else
+	 */
+	Transaction::Transaction()
+		: reset(true)
+		, select(SELECT_NONE)
+		, rom(0)
+		, hasCommand(false)
+		, command(0)
+		, write(0)
+		, writeLength(0)
+		, read(0)
+		, readLength(0)
+		, crc(CRC_NONE)
+	{
+	}
+
+	Transaction& Transaction::Skip(void)
+	{
+		select = SELECT_SKIP;
+		return *this;
+	}
+
+	Transaction& Transaction::Match(ROM rom)
+	{
+		select = SELECT_MATCH;
+		this->rom = rom;
+		return *this;
+	}
+
+	Transaction& Transaction::Resume(void)
+	{
+		select = SELECT_RESUME;
+		return *this;
+	}
+
+	Transaction& Transaction::OverdriveMatch(ROM rom)
+	{
+		select = SELECT_OVERDRIVE_MATCH;
+		this->rom = rom;
+		return *this;
+	}
+
+	Transaction& Transaction::NoReset(void)
+	{
+		reset = false;
+		return *this;
+	}
+
+	Transaction& Transaction::Command(BYTE command)
+	{
+		hasCommand = true;
+		this->command = command;
+		return *this;
+	}
+
+	/**
+	 * Bytes to write after the command
+	 *
+	 * @param[in] data Payload, must stay valid until the transaction is done
+	 * @param[in] len Number of bytes
+	 */
+	Transaction& Transaction::Write(const BYTE* data, int len)
+	{
+		write = data;
+		writeLength = len;
+		return *this;
+	}
+
+	/**
+	 * Bytes to read after the payload
+	 *
+	 * @param[out] buffer Where they go, must stay valid until the transaction
+	 * is done
+	 * @param[in] len Number of bytes, including any CRC bytes
+	 */
+	Transaction& Transaction::Read(BYTE* buffer, int len)
+	{
+		read = buffer;
+		readLength = len;
+		return *this;
+	}
+
+	Transaction& Transaction::CheckCRC8(void)
+	{
+		crc = CRC_8;
+		return *this;
+	}
+
+	Transaction& Transaction::CheckCRC16(void)
+	{
+		crc = CRC_16;
+		return *this;
+	}
+
+} // Namespace OneWire
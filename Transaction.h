@@ -0,0 +1,120 @@
+/**
+ * @file Transaction.h
+ *
+ * Transaction class prototype. Describes a whole device access, from the
+ * reset to the CRC check, so OneWireMaster::Execute() can run it in one go.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_TRANSACTION_H
+#define STELLARIS_ONEWIRE_TRANSACTION_H
+
+
+#include "OneWireBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * How the device is addressed after the reset
+	 */
+	enum SelectMode
+	{
+		SELECT_NONE,		// No ROM command, for devices already selected
+		SELECT_SKIP,		// Skip ROM, every device or the only one
+		SELECT_MATCH,		// Match ROM
+		SELECT_RESUME,		// Resume, the device selected last time
+		SELECT_OVERDRIVE_MATCH	// Overdrive Match, leaves the bus in overdrive
+	};
+
+	/**
+	 * CRC the transaction is checked with. The CRC bytes are the last ones
+	 * read, and are part of the read length.
+	 */
+	enum CRCMode
+	{
+		CRC_NONE,
+		CRC_8,		// CRC8 over the bytes read
+		CRC_16		// Inverted CRC16 over command, payload and bytes read
+	};
+
+	/**
+	 * Outcome of OneWireMaster::Execute()
+	 */
+	enum TransactionResult
+	{
+		TRANSACTION_OK,
+		TRANSACTION_NO_PRESENCE,	// Nobody answered the reset
+		TRANSACTION_CRC_ERROR		// Data came back, but failed its CRC
+	};
+
+
+	/**
+	 * A device access, built up step by step:
+	 * <pre>
+	 * BYTE scratchpad[9];
+	 * Transaction t;
+	 * t.Match(rom).Command(0xBE).Read(scratchpad, 9).CheckCRC8();
+	 * if (master.Execute(t) == TRANSACTION_OK) ...
+	 * </pre>
+	 * Nothing is copied, the payload and read buffer belong to the caller and
+	 * are used in place. A transaction can be executed any number of times.
+	 */
+	struct Transaction
+	{
+		Transaction();
+
+		// Addressing, after a reset unless NoReset() is given
+		Transaction& Skip(void);
+		Transaction& Match(ROM rom);
+		Transaction& Resume(void);
+		Transaction& OverdriveMatch(ROM rom);
+		Transaction& NoReset(void);
+
+		// Function command, and bytes written after it
+		Transaction& Command(BYTE command);
+		Transaction& Write(const BYTE* data, int len);
+
+		// Bytes read back into buffer, CRC included
+		Transaction& Read(BYTE* buffer, int len);
+
+		// Check the bytes read
+		Transaction& CheckCRC8(void);
+		Transaction& CheckCRC16(void);
+
+		bool reset;
+		SelectMode select;
+		ROM rom;
+
+		bool hasCommand;
+		BYTE command;
+
+		const BYTE* write;
+		int writeLength;
+
+		BYTE* read;
+		int readLength;
+
+		CRCMode crc;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_TRANSACTION_H
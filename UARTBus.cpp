@@ -0,0 +1,189 @@
+/**
+ * @file UARTBus.cpp
+ *
+ * UARTBus implementation
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UARTBus.h"
+
+
+namespace OneWire
+{
+
+	/**
+	 * UARTBus constructor
+	 *
+	 * @param[in] port UART with transmit and receive on the bus
+	 */
+	UARTBus::UARTBus(SerialPort& port)
+		: timeoutCount(0)
+		, port(port)
+	{
+		SetSpeed(OW_SPEED_STANDARD);
+	}
+
+	/**
+	 * Only standard speed is supported, see the class comment
+	 */
+	void UARTBus::SetSpeed(unsigned int)
+	{
+		port.SetBaud(OW_UART_SLOT_BAUD);
+	}
+
+	unsigned int UARTBus::GetSpeed(void) const
+	{
+		return OW_SPEED_STANDARD;
+	}
+
+	void UARTBus::Slots(BYTE* slots, int count)
+	{
+		port.Write(slots, count);
+		if (port.Read(slots, count)) return;
+
+		++timeoutCount;
+		port.Flush();
+		for (int i = 0; i < count; ++i) slots[i] = OW_UART_SLOT_ONE;
+	}
+
+	/**
+	 * Send the reset byte at the reset rate. Anything other than the byte
+	 * itself coming back means something pulled the line low while its high
+	 * bits were being sent, a presence pulse. 0x00 is a shorted bus, a
+	 * presence pulse never lasts up to the last bit.
+	 */
+	int UARTBus::Reset(void)
+	{
+		BYTE reset = OW_UART_RESET_BYTE;
+		BYTE echo = reset;
+
+		port.SetBaud(OW_UART_RESET_BAUD);
+		Slots(&echo, 1);
+		port.SetBaud(OW_UART_SLOT_BAUD);
+
+		return echo != reset && echo != 0x00;
+	}
+
+	void UARTBus::WriteBit(BYTE bit)
+	{
+		BYTE slot = bit & 0x01 ? OW_UART_SLOT_ONE : OW_UART_SLOT_ZERO;
+
+		Slots(&slot, 1);
+	}
+
+	/**
+	 * Data bit 0 is sampled closest to the master sampling point
+	 */
+	BYTE UARTBus::ReadBit(void)
+	{
+		BYTE slot = OW_UART_SLOT_ONE;
+
+		Slots(&slot, 1);
+		return slot & 0x01;
+	}
+
+	void UARTBus::WaitUS(unsigned int us)
+	{
+		port.DelayUS(us);
+	}
+
+	/**
+	 * Whole bytes, as many as fit in the FIFO at once. A 1 bit goes out as a
+	 * read slot and comes back as what was read, a 0 bit as a write 0.
+	 */
+	void UARTBus::TouchBytes(BYTE* data, int len)
+	{
+		const int batch = OW_UART_FIFO / 8;
+		BYTE slots[batch * 8];
+
+		while (len > 0)
+		{
+			int chunk = len < batch ? len : batch;
+
+			for (int i = 0; i < chunk * 8; ++i)
+			{
+				slots[i] = (data[i / 8] >> (i % 8)) & 0x01
+					? OW_UART_SLOT_ONE
+					: OW_UART_SLOT_ZERO;
+			}
+
+			Slots(slots, chunk * 8);
+
+			for (int i = 0; i < chunk; ++i)
+			{
+				BYTE result = 0;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					if (slots[i * 8 + bit] & 0x01) result |= 1 << bit;
+				}
+				data[i] = result;
+			}
+
+			data += chunk;
+			len -= chunk;
+		}
+	}
+
+	void UARTBus::WriteBytes(const BYTE* data, int len)
+	{
+		BYTE copy[OW_UART_FIFO / 8];
+
+		while (len > 0)
+		{
+			int chunk = len < OW_UART_FIFO / 8 ? len : OW_UART_FIFO / 8;
+
+			for (int i = 0; i < chunk; ++i) copy[i] = data[i];
+			TouchBytes(copy, chunk);
+
+			data += chunk;
+			len -= chunk;
+		}
+	}
+
+	void UARTBus::ReadBytes(BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i) data[i] = 0xFF;
+		TouchBytes(data, len);
+	}
+
+	/**
+	 * The ID bit and its complement go out together, only the direction has
+	 * to wait for them
+	 */
+	BYTE UARTBus::Triplet(BYTE direction)
+	{
+		BYTE slots[2] = { OW_UART_SLOT_ONE, OW_UART_SLOT_ONE };
+
+		Slots(slots, 2);
+
+		BYTE id = slots[0] & 0x01;
+		BYTE comp = slots[1] & 0x01;
+
+		// Only one answer present, that is the way to go
+		if (id != comp) direction = id;
+
+		WriteBit(direction);
+
+		return (id ? OW_TRIPLET_ID : 0)
+			| (comp ? OW_TRIPLET_COMP : 0)
+			| (direction ? OW_TRIPLET_DIR : 0);
+	}
+
+} // Namespace OneWire
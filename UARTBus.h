@@ -0,0 +1,103 @@
+/**
+ * @file UARTBus.h
+ *
+ * UARTBus class prototype. OneWire transport on a UART with its transmit and
+ * receive pins tied to the bus, as in Maxim Application Note 214. Every UART
+ * byte is one time slot and the UART's own bit clock times it, so the slots
+ * don't depend on delay loops or on interrupts arriving between them.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_UARTBUS_H
+#define STELLARIS_ONEWIRE_UARTBUS_H
+
+
+#include "OneWireBus.h"
+#include "SerialPort.h"
+
+
+// Standard speed. The reset byte's start bit and four 0 bits hold the line low
+// for 520us, the last bits sample the presence pulse. A slot byte of 0x00 is
+// 78us low, a write 0; 0xFF is only the 8.7us start bit, a write 1 or read
+// slot, sampled by data bit 0 at 13us.
+#ifndef OW_UART_RESET_BAUD
+#define OW_UART_RESET_BAUD		9600
+#endif // OW_UART_RESET_BAUD
+#ifndef OW_UART_SLOT_BAUD
+#define OW_UART_SLOT_BAUD		115200
+#endif // OW_UART_SLOT_BAUD
+#define OW_UART_RESET_BYTE		0xF0
+
+// Slot bytes
+#define OW_UART_SLOT_ONE		0xFF
+#define OW_UART_SLOT_ZERO		0x00
+
+// UART FIFO depth. Blocks are queued that many slots at a time, in whole
+// bytes, so the receive FIFO can't overflow before the echoes are read.
+#ifndef OW_UART_FIFO
+#define OW_UART_FIFO			16
+#endif // OW_UART_FIFO
+
+
+namespace OneWire
+{
+
+	/**
+	 * OneWire transport on a UART
+	 *
+	 * Transmit is open drain onto the bus and receive reads it back, so every
+	 * byte sent comes back as the level of the line during each of its bits.
+	 *
+	 * Standard speed only. At the 921600 baud overdrive slots would need, the
+	 * single stop bit is the only recovery between slots and at 1.1us is
+	 * short of the 2us minimum, so SetSpeed() leaves the bus at standard and
+	 * GetSpeed() says so.
+	 */
+	class UARTBus : public OneWireBus
+	{
+	public:
+		UARTBus(SerialPort& port);
+
+		// OneWireBus interface
+		int Reset(void);
+		void WriteBit(BYTE bit);
+		BYTE ReadBit(void);
+		void WaitUS(unsigned int us);
+		void SetSpeed(unsigned int busSpeed);
+		unsigned int GetSpeed(void) const;
+
+		void WriteBytes(const BYTE* data, int len);
+		void ReadBytes(BYTE* data, int len);
+		void TouchBytes(BYTE* data, int len);
+		BYTE Triplet(BYTE direction);
+
+		// Echoes that didn't come back
+		unsigned long timeoutCount;
+
+	private:
+		// Send count slot bytes and read back their echoes in place. A lost
+		// echo reads as a released line.
+		void Slots(BYTE* slots, int count);
+
+		SerialPort& port;
+	};
+
+}
+#endif // STELLARIS_ONEWIRE_UARTBUS_H
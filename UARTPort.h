@@ -0,0 +1,175 @@
+/**
+ * @file UARTPort.h
+ *
+ * UARTPort class template. SerialPort on a Stellaris UART through driverlib,
+ * for the UART based transports. The baud rate divisors are worked out for
+ * the CPU clock given as the template parameter.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STELLARIS_ONEWIRE_UARTPORT_H
+#define STELLARIS_ONEWIRE_UARTPORT_H
+
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+
+#include "SerialPort.h"
+#include "OneWireTiming.h"
+
+
+// CPU clock the timing tables are built for by default, see GPIOBus.h
+#ifndef OW_CPU_CLOCK_HZ
+#define OW_CPU_CLOCK_HZ	50000000
+#endif // OW_CPU_CLOCK_HZ
+
+// Polls of the receive FIFO before Read() gives up. One slot byte is at most
+// a millisecond at 9600 baud, this is several of those at 50MHz.
+#ifndef OW_UART_TIMEOUT_LOOPS
+#define OW_UART_TIMEOUT_LOOPS	100000
+#endif // OW_UART_TIMEOUT_LOOPS
+
+
+namespace OneWire
+{
+
+	/**
+	 * SerialPort on a Stellaris UART, 8N1 with the FIFOs on
+	 *
+	 * The transmit pin is set open drain with a weak pull up, so it can be
+	 * tied straight to a OneWire bus along with the receive pin.
+	 */
+	template <unsigned long ClockHz = OW_CPU_CLOCK_HZ>
+	class UARTPort : public SerialPort
+	{
+	public:
+		UARTPort
+			( unsigned long uartPeriph
+			, unsigned long uartBase
+			, unsigned long gpioPeriph
+			, unsigned long gpioPort
+			, unsigned char gpioPinmask
+			);
+
+		// SerialPort interface
+		void Write(const BYTE* data, int len);
+		bool Read(BYTE* data, int len);
+		void Flush(void);
+		void Break(void);
+		void SetBaud(unsigned long baud);
+		void DelayUS(unsigned int us);
+
+	private:
+		unsigned long base;
+	};
+
+
+	/**
+	 * UARTPort constructor
+	 *
+	 * @param[in] uartPeriph Peripheral address of the UART from sysctl.h
+	 * @param[in] uartBase UART base from hw_memmap.h
+	 * @param[in] gpioPeriph Peripheral address of the GPIO port with the
+	 * UART pins
+	 * @param[in] gpioPort GPIO port from hw_memmap.h
+	 * @param[in] gpioPinmask Receive and transmit pins from gpio.h
+	 */
+	template <unsigned long ClockHz>
+	UARTPort<ClockHz>::UARTPort
+		( unsigned long uartPeriph
+		, unsigned long uartBase
+		, unsigned long gpioPeriph
+		, unsigned long gpioPort
+		, unsigned char gpioPinmask
+		)
+		: base(uartBase)
+	{
+		SysCtlPeripheralEnable(uartPeriph);
+		SysCtlPeripheralEnable(gpioPeriph);
+
+		GPIOPinTypeUART(gpioPort, gpioPinmask);
+		GPIOPadConfigSet(gpioPort, gpioPinmask, GPIO_STRENGTH_4MA, GPIO_PIN_TYPE_OD_WPU);
+
+		SetBaud(9600);
+		UARTFIFOEnable(base);
+	}
+
+	template <unsigned long ClockHz>
+	void UARTPort<ClockHz>::Write(const BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i) UARTCharPut(base, data[i]);
+	}
+
+	template <unsigned long ClockHz>
+	bool UARTPort<ClockHz>::Read(BYTE* data, int len)
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			unsigned long loops = 0;
+
+			while (!UARTCharsAvail(base))
+			{
+				if (++loops == OW_UART_TIMEOUT_LOOPS) return false;
+			}
+			data[i] = (BYTE)UARTCharGetNonBlocking(base);
+		}
+
+		return true;
+	}
+
+	template <unsigned long ClockHz>
+	void UARTPort<ClockHz>::Flush(void)
+	{
+		while (UARTCharsAvail(base)) UARTCharGetNonBlocking(base);
+	}
+
+	template <unsigned long ClockHz>
+	void UARTPort<ClockHz>::Break(void)
+	{
+		UARTBreakCtl(base, true);
+		DelayUS(2000);
+		UARTBreakCtl(base, false);
+	}
+
+	/**
+	 * Change the rate once the last byte has left the shift register, the
+	 * FIFOs are kept
+	 */
+	template <unsigned long ClockHz>
+	void UARTPort<ClockHz>::SetBaud(unsigned long baud)
+	{
+		while (UARTBusy(base)) {}
+
+		UARTConfigSetExpClk(base, ClockHz, baud,
+			UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE);
+	}
+
+	template <unsigned long ClockHz>
+	void UARTPort<ClockHz>::DelayUS(unsigned int us)
+	{
+		if (us == 0) return;
+		SysCtlDelay(DelayLoops(us * 1000ULL, ClockHz));
+	}
+
+}
+#endif // STELLARIS_ONEWIRE_UARTPORT_H
@@ -0,0 +1,118 @@
+/**
+ * @file CRCBench.cpp
+ *
+ * Host benchmark of the CRC8 methods and CRC16, in bytes per second. Build it
+ * once per ONEWIRE_CRC8_CALCULATION_METHOD to see what CRC8Update() gets, e.g.
+ *
+ *   g++ -O2 -std=c++11 -I.. -DONEWIRE_CRC8_CALCULATION_METHOD=8 \
+ *       CRCBench.cpp ../OneWireCRC.cpp -o crcbench
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OneWireCRC.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+using namespace OneWire;
+
+
+// Buffer size and number of passes over it
+#define BENCH_BYTES	4096
+#define BENCH_PASSES	4096
+
+
+static BYTE buffer[BENCH_BYTES];
+
+
+static double Seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Time a CRC8 method over the buffer and print its rate. The CRC is chained
+ * from one pass to the next so the work can't be skipped.
+ */
+static BYTE Bench8(const char* name, BYTE (*method)(BYTE, const BYTE*, unsigned int))
+{
+	BYTE crc = CRC8Init();
+	double start = Seconds();
+
+	for (int pass = 0; pass < BENCH_PASSES; ++pass)
+	{
+		crc = method(crc, buffer, BENCH_BYTES);
+	}
+
+	double elapsed = Seconds() - start;
+	printf("crc8\t%s\t%.0f\t%02x\n", name,
+		(double)BENCH_BYTES * BENCH_PASSES / elapsed, crc);
+
+	return crc;
+}
+
+static unsigned short CRC16Bytes(unsigned short crc, const BYTE* data, unsigned int len)
+{
+	return CRC16Update(crc, data, len);
+}
+
+int main(void)
+{
+	srand(1);
+	for (int i = 0; i < BENCH_BYTES; ++i) buffer[i] = rand();
+
+	printf("# method=%d\n", ONEWIRE_CRC8_CALCULATION_METHOD);
+	printf("# crc\tmethod\tbytes_per_sec\tresult\n");
+
+	BYTE results[5] =
+		{ Bench8("bitwise", CRC8Bitwise)
+		, Bench8("table", CRC8Table)
+		, Bench8("slice4", CRC8Slice4)
+		, Bench8("slice8", CRC8Slice8)
+		, Bench8("selected", CRC8Update)
+		};
+
+	unsigned short crc16 = CRC16Init();
+	double start = Seconds();
+	for (int pass = 0; pass < BENCH_PASSES; ++pass)
+	{
+		crc16 = CRC16Bytes(crc16, buffer, BENCH_BYTES);
+	}
+	double elapsed = Seconds() - start;
+	printf("crc16\ttable\t%.0f\t%04x\n",
+		(double)BENCH_BYTES * BENCH_PASSES / elapsed, crc16);
+
+	// Every method has to agree
+	for (int i = 1; i < 5; ++i)
+	{
+		if (results[i] != results[0])
+		{
+			printf("# CRC8 methods disagree\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
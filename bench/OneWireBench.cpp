@@ -0,0 +1,874 @@
+/**
+ * @file OneWireBench.cpp
+ *
+ * Host benchmark of the library against SimulatedBus: Search() time against
+ * device count for random and adversarial ROM sets, Block() and Execute()
+ * cost, DS2480BBus through its emulator, DS2482 I2C traffic, AsyncEngine on
+ * SimulatedLine, DeadlineBus against the host clock, SpeedManager's overdrive
+ * grouping, BranchManager switching DS2409 branches, EEPROM programming time,
+ * and CRC8/CRC16 throughput. Every line is tab separated so results can be
+ * kept and compared from one release to the next:
+ *
+ *   bench  case  n  ops  bus_ns_per_op  host_ns_per_op  bytes_per_sec  allocs_per_op
+ *
+ * Bus time is the simulator's virtual clock, the time the operation takes on
+ * a real bus, and doesn't vary from run to run, except for the DeadlineBus
+ * cases where it follows real time. Host time is the CPU side.
+ * Throughput is over bus time for bus cases, host time for CRC ones.
+ * Columns that don't apply are "-". Built by the CMake host build.
+ *
+ * Copyright (C) <2012> Cliff Chapman <chapman.cliff@gmail.com>
+ *
+ * This file is part of the Stellaris OneWire Library.
+ * 
+ * The Stellaris OneWire Library is free software: you can redistribute it 
+ * and/or modify it under the terms of the GNU General Public License as 
+ * published by the Free Software Foundation, either version 3 of the License, 
+ * or (at your option) any later version.
+ * 
+ * The Stellaris OneWire Library is distributed in the hope that it will be 
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Stellaris OneWire Library.  
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AsyncEngine.h"
+#include "BranchManager.h"
+#include "DS2480BEmulator.h"
+#include "DS2482Bus.h"
+#include "MemoryDevice.h"
+#include "MonotonicLine.h"
+#include "OneWireMaster.h"
+#include "PosixSerialPort.h"
+#include "SimulatedBus.h"
+#include "SimulatedCoupler.h"
+#include "SimulatedDS2482.h"
+#include "SimulatedEEPROM.h"
+#include "SimulatedLine.h"
+#include "SimulatedThermometer.h"
+#include "SpeedManager.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+
+using namespace OneWire;
+
+
+// Largest bus searched, the device table has to hold it
+#define BENCH_MAX_DEVICES	1000
+
+// Search passes run for each device count, spread over repeats
+#define BENCH_SEARCH_PASSES	1000
+
+// CRC buffer size and number of passes over it
+#define BENCH_CRC_BYTES		4096
+#define BENCH_CRC_PASSES	4096
+
+// Bytes moved through Block() for each block size
+#define BENCH_BLOCK_BYTES	65536
+
+#define BENCH_TRANSACTIONS	1000
+
+// Devices searched and bytes moved through the DS2480B emulator
+#define BENCH_BRIDGE_DEVICES	50
+#define BENCH_BRIDGE_BLOCK		1024
+
+// Devices spread over the DS2482-800 channels, and resets issued over them
+#define BENCH_DS2482_DEVICES	68
+#define BENCH_DS2482_RESETS		80
+
+// Devices and scratchpad reads on the real time DeadlineBus
+#define BENCH_DEADLINE_DEVICES	8
+#define BENCH_DEADLINE_READS	20
+
+// Overdrive capable devices on the SpeedManager bus, with as many that aren't
+#define BENCH_SPEED_DEVICES	5
+
+// DS2409 couplers, and DS18B20s on the trunk and their outputs
+#define BENCH_COUPLERS			3
+#define BENCH_COUPLER_SENSORS	24
+
+// EEPROMs programmed at once, each with a full image
+#define BENCH_EEPROMS		8
+
+#if OW_MAX_NUM_DEVICES < BENCH_MAX_DEVICES
+#error "OW_MAX_NUM_DEVICES has to be at least BENCH_MAX_DEVICES"
+#endif
+
+
+// Heap allocations so far, counted by the global operator new below
+static unsigned long allocations;
+
+void* operator new(size_t size)
+{
+	++allocations;
+
+	void* p = malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+
+static unsigned long long HostNS(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Bus and host time and heap allocations of a run of operations
+ */
+class Measurement
+{
+public:
+	Measurement(const SimulatedBus* bus)
+		: bus(bus)
+		, busStart(bus ? bus->Now() : 0)
+		, allocStart(allocations)
+		, hostStart(HostNS())
+	{
+	}
+
+	/**
+	 * Print a result line for ops operations of bytes each, bytes 0 if
+	 * throughput makes no sense for them
+	 */
+	void Report(const char* bench, const char* name, int n, int ops, unsigned long bytes)
+	{
+		unsigned long long host = HostNS() - hostStart;
+		unsigned long long busNS = bus ? bus->Now() - busStart : 0;
+		unsigned long allocs = allocations - allocStart;
+
+		printf("%s\t%s\t%d\t%d\t", bench, name, n, ops);
+
+		if (bus) printf("%.0f\t", (double)busNS / ops);
+		else printf("-\t");
+
+		printf("%.0f\t", (double)host / ops);
+
+		// Throughput on the bus when there is one, of the host otherwise
+		unsigned long long elapsed = bus ? busNS : host;
+		if (bytes && elapsed) printf("%.0f\t", (double)bytes * ops * 1e9 / elapsed);
+		else printf("-\t");
+
+		printf("%.2f\n", (double)allocs / ops);
+	}
+
+private:
+	const SimulatedBus* bus;
+	unsigned long long busStart;
+	unsigned long allocStart;
+	unsigned long long hostStart;
+};
+
+
+/**
+ * Random family codes and serial numbers. Branches are spread evenly over
+ * the ROM, the usual case on a real bus.
+ */
+static ROM RandomROM(int, int)
+{
+	BYTE rom[8];
+
+	for (int i = 0; i < 7; ++i) rom[i] = rand();
+	rom[7] = OneWireMaster::CRC8(rom, 7);
+
+	return PackROM(rom);
+}
+
+/**
+ * One family with serial numbers that only differ in their top bits. Every
+ * pass shares a long prefix and then branches in the last bits sent, the
+ * most triplets per device found and the deepest backtracking.
+ */
+static ROM AdversarialROM(int index, int count)
+{
+	int bits = 0;
+	while ((1 << bits) < count) ++bits;
+
+	uint64_t serial = (uint64_t)index << (48 - bits);
+	BYTE rom[8];
+
+	rom[0] = 0x28;
+	for (int i = 0; i < 6; ++i) rom[i + 1] = serial >> (8 * i);
+	rom[7] = OneWireMaster::CRC8(rom, 7);
+
+	return PackROM(rom);
+}
+
+/**
+ * Search time for a device count. Returns false if the search didn't find
+ * every device.
+ */
+static bool BenchSearch(const char* name, ROM (*generate)(int, int), int count)
+{
+	std::vector<SimulatedDevice*> devices;
+	SimulatedBus bus;
+	OneWireMaster master(bus);
+
+	srand(count);
+	while ((int)devices.size() < count)
+	{
+		ROM rom = generate(devices.size(), count);
+
+		bool duplicate = false;
+		for (unsigned int i = 0; i < devices.size(); ++i)
+		{
+			duplicate = duplicate || PackROM(devices[i]->rom) == rom;
+		}
+		if (duplicate) continue;
+
+		BYTE bytes[8];
+		UnpackROM(rom, bytes);
+		devices.push_back(new SimulatedDevice(bytes));
+		bus.Attach(*devices.back());
+	}
+
+	// The first search sizes the simulator's buffers
+	int found = master.Search();
+
+	int repeats = BENCH_SEARCH_PASSES / count;
+	if (repeats < 1) repeats = 1;
+
+	Measurement run(&bus);
+	for (int i = 0; i < repeats; ++i) found = master.Search();
+	run.Report("search", name, count, repeats, 0);
+
+	for (unsigned int i = 0; i < devices.size(); ++i) delete devices[i];
+
+	return found == count;
+}
+
+/**
+ * Block() throughput, on a bus with one idle device. Nothing drives the read
+ * slots, so the buffer comes back unchanged and can be sent again.
+ */
+static void BenchBlock(int len)
+{
+	BYTE rom[8] = {0x28, 1, 2, 3, 4, 5, 6, 0};
+	rom[7] = OneWireMaster::CRC8(rom, 7);
+
+	SimulatedBus bus;
+	SimulatedDevice device(rom);
+	OneWireMaster master(bus);
+	std::vector<BYTE> data(len);
+
+	bus.Attach(device);
+	for (int i = 0; i < len; ++i) data[i] = i & 1 ? 0xFF : rand();
+
+	int repeats = BENCH_BLOCK_BYTES / len;
+
+	master.Block(&data[0], len);
+
+	Measurement run(&bus);
+	for (int i = 0; i < repeats; ++i) master.Block(&data[0], len);
+	run.Report("block", "touch", len, repeats, len);
+}
+
+/**
+ * Serial traffic of a DS2480BBus run against DS2480BEmulator on a pty
+ */
+static void BridgeTraffic(const char* name, const DS2480BBus& bus)
+{
+	printf("# ds2480b %s writes %lu sent %lu received %lu serial_ms_at_9600 %.1f\n",
+		name, bus.writeCount, bus.bytesSent, bus.bytesReceived,
+		(bus.bytesSent + bus.bytesReceived) * 10 / 9.6);
+}
+
+/**
+ * DS2480BBus through DS2480BEmulator: a search of BENCH_BRIDGE_DEVICES
+ * devices, then Block() in data mode with 0xE3 bytes that need escaping.
+ * Bus time is the 1-Wire side; the serial line at 9600 baud is printed with
+ * the traffic counters. Returns false if the search missed a device or the
+ * block didn't come back intact.
+ */
+static bool BenchBridge(void)
+{
+	SimulatedBus sim;
+	std::vector<SimulatedDevice*> devices;
+	DS2480BEmulator emulator(sim);
+	PosixSerialPort port;
+	BYTE data[BENCH_BRIDGE_BLOCK];
+	int found;
+	bool intact = true;
+
+	srand(BENCH_BRIDGE_DEVICES);
+	for (int i = 0; i < BENCH_BRIDGE_DEVICES; ++i)
+	{
+		BYTE rom[8];
+
+		UnpackROM(RandomROM(i, BENCH_BRIDGE_DEVICES), rom);
+		devices.push_back(new SimulatedDevice(rom));
+		sim.Attach(*devices[i]);
+	}
+
+	if (!emulator.Open() || !port.Open(emulator.Path()))
+	{
+		printf("# ds2480b no pty, skipped\n");
+		for (unsigned int i = 0; i < devices.size(); ++i) delete devices[i];
+		return true;
+	}
+
+	DS2480BBus bus(port);
+	OneWireMaster master(bus);
+
+	bus.Detect();
+
+	bus.ClearCounters();
+	Measurement search(&sim);
+	found = master.Search();
+	search.Report("ds2480b", "search", BENCH_BRIDGE_DEVICES, 1, 0);
+	BridgeTraffic("search", bus);
+
+	for (int i = 0; i < BENCH_BRIDGE_BLOCK; ++i) data[i] = i % 5 ? 0xFF : 0xE3;
+	master.Reset();
+	master.SkipROM();
+
+	bus.ClearCounters();
+	Measurement block(&sim);
+	master.Block(data, BENCH_BRIDGE_BLOCK);
+	block.Report("ds2480b", "block", BENCH_BRIDGE_BLOCK, 1, BENCH_BRIDGE_BLOCK);
+	BridgeTraffic("block", bus);
+
+	for (int i = 0; i < BENCH_BRIDGE_BLOCK; ++i) intact = intact && data[i] == (i % 5 ? 0xFF : 0xE3);
+
+	port.Close();
+	emulator.Close();
+	for (unsigned int i = 0; i < devices.size(); ++i) delete devices[i];
+
+	return found == BENCH_BRIDGE_DEVICES && intact;
+}
+
+/**
+ * I2C traffic of a DS2482 run against SimulatedDS2482, and the bus time
+ * summed over its channels
+ */
+static void BridgeTraffic
+	( const char* name
+	, const DS2482& chip
+	, const SimulatedDS2482& stub
+	, const std::vector<SimulatedBus*>& channels
+	, unsigned long long startNS
+	)
+{
+	unsigned long long busNS = 0;
+
+	for (unsigned int i = 0; i < channels.size(); ++i) busNS += channels[i]->Now();
+
+	printf("# ds2482 %s transactions %lu i2c_ops %lu polls %lu selects %lu selects_skipped %lu bus_ms %.1f\n",
+		name, chip.transactionCount, stub.transactionCount, chip.pollCount,
+		chip.selectCount, chip.selectSkipped, (busNS - startNS) / 1e6);
+}
+
+/**
+ * A DS2482-800 stub with BENCH_DS2482_DEVICES devices spread over its 8
+ * channels: a search of every channel, then BENCH_DS2482_RESETS resets taken
+ * round robin over the channels against the same resets grouped by channel.
+ * Counts are what matter here, every case is one line of I2C traffic.
+ * Returns false if the search missed a device.
+ */
+static bool BenchDS2482(void)
+{
+	SimulatedDS2482 stub(OW_DS2482_CHANNELS);
+	DS2482 chip(stub);
+	std::vector<SimulatedBus*> channels;
+	std::vector<SimulatedDevice*> devices;
+	std::vector<DS2482Bus*> buses;
+	std::vector<OneWireMaster*> masters;
+	unsigned long long startNS;
+	int found = 0;
+
+	for (int c = 0; c < OW_DS2482_CHANNELS; ++c)
+	{
+		channels.push_back(new SimulatedBus());
+		stub.Attach(c, *channels[c]);
+		buses.push_back(new DS2482Bus(chip, c));
+		masters.push_back(new OneWireMaster(*buses[c]));
+	}
+
+	srand(BENCH_DS2482_DEVICES);
+	for (int i = 0; i < BENCH_DS2482_DEVICES; ++i)
+	{
+		BYTE rom[8];
+
+		UnpackROM(RandomROM(i, BENCH_DS2482_DEVICES), rom);
+		devices.push_back(new SimulatedDevice(rom));
+		channels[i % OW_DS2482_CHANNELS]->Attach(*devices[i]);
+	}
+
+	chip.Detect();
+
+	// Warm up, so the simulator's buffers are grown before anything counts
+	for (int c = 0; c < OW_DS2482_CHANNELS; ++c)
+	{
+		masters[c]->Reset();
+		masters[c]->ReadByte();
+	}
+	chip.Select(0);
+
+	// Every channel searched in turn
+	chip.ClearCounters();
+	stub.transactionCount = 0;
+	startNS = 0;
+	for (int c = 0; c < OW_DS2482_CHANNELS; ++c) startNS += channels[c]->Now();
+
+	Measurement search(0);
+	for (int c = 0; c < OW_DS2482_CHANNELS; ++c) found += masters[c]->Search();
+	search.Report("ds2482", "search_all_channels", BENCH_DS2482_DEVICES, 1, 0);
+	BridgeTraffic("search_all_channels", chip, stub, channels, startNS);
+
+	// The same resets, one channel after another or a channel at a time
+	for (int grouped = 0; grouped < 2; ++grouped)
+	{
+		const char* name = grouped ? "resets_grouped" : "resets_round_robin";
+
+		chip.ClearCounters();
+		stub.transactionCount = 0;
+		startNS = 0;
+		for (int c = 0; c < OW_DS2482_CHANNELS; ++c) startNS += channels[c]->Now();
+
+		Measurement resets(0);
+		for (int i = 0; i < BENCH_DS2482_RESETS; ++i)
+		{
+			int c = grouped
+				? i / (BENCH_DS2482_RESETS / OW_DS2482_CHANNELS)
+				: i % OW_DS2482_CHANNELS;
+
+			masters[c]->Reset();
+		}
+		resets.Report("ds2482", name, BENCH_DS2482_RESETS, BENCH_DS2482_RESETS, 0);
+		BridgeTraffic(name, chip, stub, channels, startNS);
+	}
+
+	for (int c = 0; c < OW_DS2482_CHANNELS; ++c)
+	{
+		delete masters[c];
+		delete buses[c];
+		delete channels[c];
+	}
+	for (unsigned int i = 0; i < devices.size(); ++i) delete devices[i];
+
+	return found == BENCH_DS2482_DEVICES;
+}
+
+/**
+ * A scratchpad read with Execute(). Returns false if any of them failed.
+ */
+static bool BenchTransaction(void)
+{
+	BYTE rom[8] = {0x28, 6, 5, 4, 3, 2, 1, 0};
+	rom[7] = OneWireMaster::CRC8(rom, 7);
+
+	SimulatedBus bus;
+	SimulatedThermometer thermometer(rom);
+	OneWireMaster master(bus);
+	BYTE scratchpad[9];
+	Transaction t;
+	int failed = 0;
+
+	bus.Attach(thermometer);
+	t.Match(PackROM(rom)).Command(0xBE).Read(scratchpad, 9).CheckCRC8();
+
+	Measurement run(&bus);
+	for (int i = 0; i < BENCH_TRANSACTIONS; ++i)
+	{
+		failed += master.Execute(t) != TRANSACTION_OK;
+	}
+	run.Report("transaction", "read_scratchpad", 9, BENCH_TRANSACTIONS, 9);
+
+	return failed == 0;
+}
+
+/**
+ * The same scratchpad read through AsyncEngine, with SimulatedLine standing
+ * in for the timer interrupt. Returns false if any of them failed.
+ */
+static bool BenchAsync(void)
+{
+	BYTE rom[8] = {0x28, 6, 5, 4, 3, 2, 1, 0};
+	rom[7] = OneWireMaster::CRC8(rom, 7);
+
+	SimulatedBus bus;
+	SimulatedThermometer thermometer(rom);
+	SimulatedLine line(bus);
+	AsyncEngine engine(line, OW_SPEED_STANDARD);
+	BYTE data[19];
+	AsyncTransaction t(true, data, 19);
+	int failed = 0;
+
+	bus.Attach(thermometer);
+
+	Measurement run(&bus);
+	for (int i = 0; i < BENCH_TRANSACTIONS; ++i)
+	{
+		data[0] = OW_MATCH_ROM;
+		UnpackROM(PackROM(rom), data + 1);
+		data[9] = 0xBE;
+		for (int j = 10; j < 19; ++j) data[j] = 0xFF;
+
+		engine.Submit(t);
+		line.RunUntilIdle();
+
+		failed += !t.done || !t.presence || OneWireMaster::CRC8(data + 10, 9) != 0;
+	}
+	run.Report("async", "read_scratchpad", 9, BENCH_TRANSACTIONS, 9);
+
+	printf("# async edges per transaction %lu\n", engine.edgeCount / BENCH_TRANSACTIONS);
+
+	return failed == 0;
+}
+
+/**
+ * DeadlineBus over MonotonicLine: the bit-bang slot code timed by the host's
+ * CLOCK_MONOTONIC, with the simulator following real time. Bus time here is
+ * real time and varies from run to run, as do the edge errors, so failed
+ * reads are only counted.
+ */
+static void BenchDeadline(void)
+{
+	SimulatedBus sim;
+	std::vector<SimulatedThermometer*> thermometers;
+	int good = 0;
+
+	srand(BENCH_DEADLINE_DEVICES);
+	for (int i = 0; i < BENCH_DEADLINE_DEVICES; ++i)
+	{
+		BYTE rom[8];
+
+		UnpackROM(RandomROM(i, BENCH_DEADLINE_DEVICES), rom);
+		rom[0] = 0x28;
+		rom[7] = OneWireMaster::CRC8(rom, 7);
+
+		thermometers.push_back(new SimulatedThermometer(rom));
+		sim.Attach(*thermometers[i]);
+	}
+
+	MonotonicLine line(sim);
+	DeadlineBus bus(line);
+	OneWireMaster master(bus);
+	BYTE scratchpad[9];
+
+	Measurement search(&sim);
+	master.Search();
+	search.Report("deadline", "search", BENCH_DEADLINE_DEVICES, 1, 0);
+
+	// Warm up, so the simulator's buffers are grown before the reads count
+	for (unsigned int i = 0; i < master.devices.Count(); ++i)
+	{
+		Transaction t;
+
+		t.Match(master.devices[i]).Command(0xBE).Read(scratchpad, 9);
+		master.Execute(t);
+	}
+
+	Measurement run(&sim);
+	for (int i = 0; i < BENCH_DEADLINE_READS; ++i)
+	{
+		Transaction t;
+
+		t.Match(master.devices[i % master.devices.Count()]).Command(0xBE)
+			.Read(scratchpad, 9).CheckCRC8();
+		good += master.Execute(t) == TRANSACTION_OK;
+	}
+	run.Report("deadline", "read_scratchpad", 9, BENCH_DEADLINE_READS, 9);
+
+	printf("# deadline found %u reads_ok %d bound_ns %lu worst_error_ns %lu bound_misses %lu\n",
+		master.devices.Count(), good, bus.ErrorBoundNS(), bus.worstErrorNS, bus.boundMisses);
+
+	for (unsigned int i = 0; i < thermometers.size(); ++i) delete thermometers[i];
+}
+
+/**
+ * SpeedManager on a bus of BENCH_SPEED_DEVICES overdrive capable devices with
+ * a 32 byte scratchpad and as many DS18B20s that aren't: probing, the
+ * capable devices' reads one by one at standard speed against ExecuteAll(),
+ * then a read whose CRC fails at overdrive twice, which has to fall back to
+ * standard speed. Returns false if a read failed or there was no fallback.
+ */
+static bool BenchSpeed(void)
+{
+	SimulatedBus bus;
+	OneWireMaster master(bus);
+	SpeedManager speeds(master);
+	std::vector<SimulatedDevice*> devices;
+	BYTE data[BENCH_SPEED_DEVICES][32];
+	Transaction reads[BENCH_SPEED_DEVICES];
+	TransactionResult results[BENCH_SPEED_DEVICES];
+	int good = 0;
+
+	srand(BENCH_SPEED_DEVICES);
+	for (int i = 0; i < 2 * BENCH_SPEED_DEVICES; ++i)
+	{
+		BYTE rom[8];
+
+		UnpackROM(RandomROM(i, 2 * BENCH_SPEED_DEVICES), rom);
+		rom[0] = i < BENCH_SPEED_DEVICES ? 0x2D : 0x28;
+		rom[7] = OneWireMaster::CRC8(rom, 7);
+
+		if (i < BENCH_SPEED_DEVICES)
+		{
+			BYTE scratchpad[32];
+
+			for (int j = 0; j < 31; ++j) scratchpad[j] = rand();
+			scratchpad[31] = OneWireMaster::CRC8(scratchpad, 31);
+
+			devices.push_back(new SimulatedDevice(rom, scratchpad, 32));
+			devices[i]->overdriveCapable = true;
+			reads[i].Match(PackROM(rom)).Command(0xBE).Read(data[i], 32).CheckCRC8();
+		}
+		else
+		{
+			devices.push_back(new SimulatedThermometer(rom));
+		}
+
+		bus.Attach(*devices[i]);
+	}
+
+	master.Search();
+
+	// Warm up, so the simulator's buffers are grown before anything counts
+	for (int i = 0; i < BENCH_SPEED_DEVICES; ++i) master.Execute(reads[i]);
+
+	Measurement probe(&bus);
+	speeds.ProbeAll(master.devices);
+	probe.Report("speed", "probe", 2 * BENCH_SPEED_DEVICES, 1, 0);
+
+	Measurement standard(&bus);
+	for (int i = 0; i < BENCH_SPEED_DEVICES; ++i)
+	{
+		good += master.Execute(reads[i]) == TRANSACTION_OK;
+	}
+	standard.Report("speed", "read32_standard", BENCH_SPEED_DEVICES, 1, 32 * BENCH_SPEED_DEVICES);
+
+	Measurement grouped(&bus);
+	good += speeds.ExecuteAll(reads, results, BENCH_SPEED_DEVICES);
+	grouped.Report("speed", "read32_execute_all", BENCH_SPEED_DEVICES, 1, 32 * BENCH_SPEED_DEVICES);
+
+	// A read bit of the scratchpad comes back wrong at overdrive, twice: a
+	// retry at standard speed each time, then the device leaves the group
+	for (int i = 0; i < 2; ++i)
+	{
+		bus.ClearCounters();
+		bus.CorruptSlot(8 + 64 + 8 + 40);
+		good += speeds.Execute(reads[0]) == TRANSACTION_OK;
+	}
+
+	printf("# speed overdrive %u retries %lu fallbacks %lu\n",
+		speeds.OverdriveGroup().Count(), speeds.retryCount, speeds.fallbackCount);
+
+	for (unsigned int i = 0; i < devices.size(); ++i) delete devices[i];
+
+	return good == 2 * BENCH_SPEED_DEVICES + 2 && speeds.fallbackCount == 1;
+}
+
+/**
+ * BranchManager polling BENCH_COUPLER_SENSORS DS18B20s spread over the trunk
+ * and both outputs of BENCH_COUPLERS DS2409s, first one read at a time in
+ * ROM order, switching as it goes, then as one ExecuteAll() batch. Returns
+ * false if discovery missed a device or a read failed.
+ */
+static bool BenchCouplers(void)
+{
+	SimulatedBus bus;
+	OneWireMaster master(bus);
+	BranchManager branches(master);
+	std::vector<SimulatedDevice*> devices;
+	std::vector<SimulatedCoupler*> couplers;
+	BYTE data[BENCH_COUPLER_SENSORS][9];
+	Transaction reads[BENCH_COUPLER_SENSORS];
+	TransactionResult results[BENCH_COUPLER_SENSORS];
+	int good = 0;
+
+	srand(BENCH_COUPLERS);
+	for (int i = 0; i < BENCH_COUPLERS + BENCH_COUPLER_SENSORS; ++i)
+	{
+		BYTE rom[8];
+
+		UnpackROM(RandomROM(i, BENCH_COUPLERS + BENCH_COUPLER_SENSORS), rom);
+		rom[0] = i < BENCH_COUPLERS ? OW_FAMILY_DS2409 : 0x28;
+		rom[7] = OneWireMaster::CRC8(rom, 7);
+
+		if (i < BENCH_COUPLERS)
+		{
+			couplers.push_back(new SimulatedCoupler(rom));
+			devices.push_back(couplers[i]);
+		}
+		else
+		{
+			devices.push_back(new SimulatedThermometer(rom));
+		}
+		bus.Attach(*devices[i]);
+	}
+
+	// A few sensors stay on the trunk, the rest go round the coupler outputs
+	for (int i = BENCH_COUPLERS + 3; i < BENCH_COUPLERS + BENCH_COUPLER_SENSORS; ++i)
+	{
+		int output = (i - BENCH_COUPLERS - 3) % (2 * BENCH_COUPLERS);
+
+		couplers[output / 2]->Connect(output % 2 ? OW_COUPLER_AUX : OW_COUPLER_MAIN, *devices[i]);
+	}
+
+	good += branches.Discover() == BENCH_COUPLERS + BENCH_COUPLER_SENSORS;
+
+	// In ROM order, which jumps from branch to branch
+	unsigned int first;
+	unsigned int count = branches.Devices().FamilyRange(0x28, first);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		reads[i].Match(branches.Devices()[first + i]).Command(0xBE).Read(data[i], 9).CheckCRC8();
+	}
+	good += count == BENCH_COUPLER_SENSORS;
+
+	// Warm up, so the simulator's buffers are grown before anything counts,
+	// and start from the trunk
+	branches.ExecuteAll(reads, results, BENCH_COUPLER_SENSORS);
+	branches.Activate(OW_BRANCH_TRUNK);
+
+	branches.switchCount = 0;
+	Measurement inOrder(&bus);
+	for (int i = 0; i < BENCH_COUPLER_SENSORS; ++i)
+	{
+		good += branches.Execute(reads[i]) == TRANSACTION_OK;
+	}
+	inOrder.Report("coupler", "read_in_order", BENCH_COUPLER_SENSORS, 1, 9 * BENCH_COUPLER_SENSORS);
+	unsigned long inOrderSwitches = branches.switchCount;
+
+	branches.switchCount = 0;
+	Measurement grouped(&bus);
+	good += branches.ExecuteAll(reads, results, BENCH_COUPLER_SENSORS);
+	grouped.Report("coupler", "read_execute_all", BENCH_COUPLER_SENSORS, 1, 9 * BENCH_COUPLER_SENSORS);
+
+	printf("# coupler switches in_order %lu execute_all %lu\n", inOrderSwitches, branches.switchCount);
+
+	for (unsigned int i = 0; i < devices.size(); ++i) delete devices[i];
+
+	return good == 2 + 2 * BENCH_COUPLER_SENSORS;
+}
+
+/**
+ * MemoryProgrammer writing a full image to a string of DS2431s at overdrive,
+ * waiting out every copy or overlapping them. Returns false if any device
+ * didn't end up with its image.
+ */
+static bool BenchProgram(bool overlap)
+{
+	SimulatedBus bus;
+	OneWireMaster master(bus);
+	MemoryProgrammer programmer(master);
+	std::vector<SimulatedEEPROM*> devices;
+	unsigned int size = MemorySize(OW_FAMILY_DS2431);
+	std::vector<BYTE> images(BENCH_EEPROMS * size);
+	int written;
+
+	for (int i = 0; i < BENCH_EEPROMS; ++i)
+	{
+		BYTE rom[8];
+
+		UnpackROM(RandomROM(i, BENCH_EEPROMS), rom);
+		rom[0] = OW_FAMILY_DS2431;
+		rom[7] = OneWireMaster::CRC8(rom, 7);
+
+		devices.push_back(new SimulatedEEPROM(rom));
+		devices[i]->overdriveCapable = true;
+		bus.Attach(*devices[i]);
+
+		for (unsigned int j = 0; j < size; ++j) images[i * size + j] = rand();
+		programmer.Add(PackROM(rom), 0, &images[i * size], size);
+	}
+
+	master.SkipOverdrive();
+	programmer.overlap = overlap;
+
+	// Warm up, so the simulator's buffers are grown before anything counts,
+	// then program a fresh set of images
+	programmer.Run();
+	for (unsigned int i = 0; i < images.size(); ++i) images[i] = rand();
+
+	Measurement run(&bus);
+	written = programmer.Run();
+	run.Report("program", overlap ? "ds2431_overlap" : "ds2431_wait", BENCH_EEPROMS, 1, 0);
+
+	for (int i = 0; i < BENCH_EEPROMS; ++i) delete devices[i];
+
+	return written == BENCH_EEPROMS;
+}
+
+/**
+ * CRC8Update() and CRC16Update() over a buffer, chained from one pass to the
+ * next so the work can't be skipped. bench/CRCBench.cpp compares the CRC8
+ * methods against each other.
+ */
+static void BenchCRC(void)
+{
+	static BYTE buffer[BENCH_CRC_BYTES];
+	for (int i = 0; i < BENCH_CRC_BYTES; ++i) buffer[i] = rand();
+
+	BYTE crc8 = CRC8Init();
+	Measurement run8(0);
+	for (int pass = 0; pass < BENCH_CRC_PASSES; ++pass)
+	{
+		crc8 = CRC8Update(crc8, buffer, BENCH_CRC_BYTES);
+	}
+	run8.Report("crc", "crc8", BENCH_CRC_BYTES, BENCH_CRC_PASSES, BENCH_CRC_BYTES);
+
+	unsigned short crc16 = CRC16Init();
+	Measurement run16(0);
+	for (int pass = 0; pass < BENCH_CRC_PASSES; ++pass)
+	{
+		crc16 = CRC16Update(crc16, buffer, BENCH_CRC_BYTES);
+	}
+	run16.Report("crc", "crc16", BENCH_CRC_BYTES, BENCH_CRC_PASSES, BENCH_CRC_BYTES);
+
+	printf("# crc results %02x %04x\n", crc8, crc16);
+}
+
+int main(void)
+{
+	static const int counts[] = {10, 20, 50, 100, 200, 500, 1000};
+	bool ok = true;
+
+	printf("# onewirebench format=2 crc8_method=%d max_devices=%d statistics=%d\n",
+		ONEWIRE_CRC8_CALCULATION_METHOD, OW_MAX_NUM_DEVICES, OW_STATISTICS);
+	printf("# bench\tcase\tn\tops\tbus_ns_per_op\thost_ns_per_op\tbytes_per_sec\tallocs_per_op\n");
+
+	for (unsigned int i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+	{
+		ok = BenchSearch("random", RandomROM, counts[i]) && ok;
+		ok = BenchSearch("adversarial", AdversarialROM, counts[i]) && ok;
+	}
+
+	BenchBlock(8);
+	BenchBlock(64);
+	BenchBlock(256);
+	ok = BenchBridge() && ok;
+	ok = BenchDS2482() && ok;
+
+	ok = BenchTransaction() && ok;
+	ok = BenchAsync() && ok;
+	ok = BenchSpeed() && ok;
+	BenchDeadline();
+	ok = BenchCouplers() && ok;
+
+	ok = BenchProgram(false) && ok;
+	ok = BenchProgram(true) && ok;
+
+	BenchCRC();
+
+	if (!ok) printf("# search, bridge, transaction, speed, coupler or programming failed\n");
+	return ok ? 0 : 1;
+}